@@ -0,0 +1,78 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AICOMMAND_H
+#define AICOMMAND_H
+
+#include <cstdint>
+#include <vector>
+
+class Creature;
+class Room;
+class Tile;
+
+enum class RoomType;
+
+enum class AICommandType
+{
+    //! \brief Builds a room of type mRoomType on mTiles
+    buildRoom,
+    //! \brief Marks mTiles for digging. If mTileWayEnd is not null, a way from mTileWayStart to mTileWayEnd
+    //! is marked first and mTiles are only marked if such a way is found
+    markDig,
+    //! \brief Picks up mCreature
+    pickUp,
+    //! \brief Drops what was picked up on mTiles[0]
+    drop,
+    //! \brief Casts summon worker on mTiles
+    summonWorkers,
+    //! \brief Repairs mRoom
+    repairRoom,
+    //! \brief Chooses the skills to research
+    setupSkills
+};
+
+/*! \brief Change to the game map decided by an AI. The AIs decide what to do at the same time on a read
+ * only game map (see AIManager::doTurn). Their commands are then applied one after the other. As the game
+ * map may have changed since the decision (commands of other AIs), each command checks again that it can
+ * be done when applied.
+ */
+struct AICommand
+{
+    explicit AICommand(AICommandType type) :
+        mType(type),
+        mRoomType(),
+        mTileWayStart(nullptr),
+        mTileWayEnd(nullptr),
+        mCreature(nullptr),
+        mRoom(nullptr),
+        mTag(0)
+    {}
+
+    AICommandType mType;
+    RoomType mRoomType;
+    std::vector<Tile*> mTiles;
+    Tile* mTileWayStart;
+    Tile* mTileWayEnd;
+    Creature* mCreature;
+    Room* mRoom;
+
+    //! \brief Set by the AI to recognize the command if it fails (see BaseAI::notifyCommandFailed)
+    uint32_t mTag;
+};
+
+#endif // AICOMMAND_H
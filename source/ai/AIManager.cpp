@@ -20,6 +20,15 @@
 #include "ai/AIFactory.h"
 #include "ai/BaseAI.h"
 
+#include "game/Player.h"
+#include "game/Seat.h"
+
+#include "gamemap/GameMap.h"
+
+#include "utils/ThreadPool.h"
+
+#include <algorithm>
+
 AIManager::AIManager(GameMap& gameMap)
     : mGameMap(gameMap)
 {
@@ -36,15 +45,29 @@ bool AIManager::assignAI(Player& player, KeeperAIType type)
     if(ai == nullptr)
         return false;
 
-    mAiList.push_back(ai);
+    // The AIs are kept sorted by seat id so that their commands are always applied in the same order
+    AIList::iterator it = std::upper_bound(mAiList.begin(), mAiList.end(), ai, [](BaseAI* ai1, BaseAI* ai2)
+    {
+        return ai1->getPlayer().getSeat()->getId() < ai2->getPlayer().getSeat()->getId();
+    });
+    mAiList.insert(it, ai);
     return true;
 }
 
 bool AIManager::doTurn(double timeSinceLastTurn)
 {
+    // The AIs decide at the same time on the game map that is not modified until every one is done
+    mGameMap.getThreadPool().parallelFor(0, static_cast<uint32_t>(mAiList.size()), 1,
+        [this, timeSinceLastTurn](uint32_t begin, uint32_t end)
+    {
+        for(uint32_t i = begin; i < end; ++i)
+            mAiList[i]->doTurn(timeSinceLastTurn);
+    });
+
+    // Then, their commands are applied by seat id order
     for(BaseAI* ai : mAiList)
     {
-        ai->doTurn(timeSinceLastTurn);
+        ai->applyCommands();
     }
     return true;
 }
@@ -23,13 +23,16 @@
 #include "entities/Tile.h"
 
 #include "game/Player.h"
+#include "game/Seat.h"
 
 #include "gamemap/GameMap.h"
 
 #include "network/ODServer.h"
 
 #include "rooms/Room.h"
+#include "rooms/RoomManager.h"
 #include "rooms/RoomType.h"
+#include "spells/SpellSummonWorker.h"
 #include "utils/Helper.h"
 #include "utils/LogManager.h"
 
@@ -38,10 +41,91 @@ const int32_t handicapPerTileOffset = 20;
 
 BaseAI::BaseAI(GameMap& gameMap, Player& player):
     mGameMap(gameMap),
-    mPlayer(player)
+    mPlayer(player),
+    mRandom((static_cast<unsigned long>(Random::Uint(0, 32767)) << 15) | Random::Uint(0, 32767))
 {
 }
 
+void BaseAI::applyCommands()
+{
+    for(const AICommand& command : mCommands)
+    {
+        if(!applyCommand(command))
+            notifyCommandFailed(command);
+    }
+    mCommands.clear();
+}
+
+bool BaseAI::applyCommand(const AICommand& command)
+{
+    Seat* seat = mPlayer.getSeat();
+    switch(command.mType)
+    {
+        case AICommandType::buildRoom:
+        {
+            if(!RoomManager::buildRoomOnTiles(&mGameMap, command.mRoomType, &mPlayer, command.mTiles))
+                return false;
+
+            OD_LOG_INF("AI seatId=" + Helper::toString(seat->getId()) + " builds room type=" + Helper::toString(static_cast<uint32_t>(command.mRoomType)) + ", nbTiles=" + Helper::toString(static_cast<uint32_t>(command.mTiles.size())));
+            return true;
+        }
+        case AICommandType::markDig:
+        {
+            if((command.mTileWayEnd != nullptr) &&
+               !digWayToTile(command.mTileWayStart, command.mTileWayEnd))
+            {
+                return false;
+            }
+
+            for(Tile* tile : command.mTiles)
+                tile->setMarkedForDigging(true, &mPlayer);
+
+            return true;
+        }
+        case AICommandType::pickUp:
+        {
+            // Another AI may have picked up the creature in the meantime
+            if(!command.mCreature->tryPickup(seat))
+                return false;
+
+            mPlayer.pickUpEntity(command.mCreature);
+            return true;
+        }
+        case AICommandType::drop:
+        {
+            // If the matching pick up failed, there is nothing to drop
+            if(mPlayer.numObjectsInHand() == 0)
+                return false;
+
+            mPlayer.dropHand(command.mTiles.front());
+            return true;
+        }
+        case AICommandType::summonWorkers:
+            return SpellSummonWorker::summonWorkersOnTiles(&mGameMap, &mPlayer, command.mTiles);
+
+        case AICommandType::repairRoom:
+        {
+            // The room may have been destroyed by the previous commands
+            if(!command.mRoom->getIsOnMap() || !command.mRoom->canBeRepaired())
+                return false;
+
+            if(!mGameMap.withdrawFromTreasuries(command.mRoom->getCostRepair(), seat))
+                return false;
+
+            command.mRoom->repairRoom();
+            return true;
+        }
+        case AICommandType::setupSkills:
+        {
+            setupSkills();
+            return true;
+        }
+        default:
+            OD_LOG_ERR("seatId=" + Helper::toString(seat->getId()) + ", command type=" + Helper::toString(static_cast<uint32_t>(command.mType)));
+            return false;
+    }
+}
+
 Room* BaseAI::getDungeonTemple()
 {
     std::vector<Room*> dt = mGameMap.getRoomsByTypeAndSeat(RoomType::dungeonTemple, mPlayer.getSeat());
@@ -18,6 +18,9 @@
 #ifndef BASEAI_H
 #define BASEAI_H
 
+#include "ai/AICommand.h"
+#include "utils/Random.h"
+
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -40,13 +43,34 @@ public:
      *  This is the function that will be called each turn for the ai.
      *  For custom AI's this should be overridden and return true on a
      *  successful call.
+     *  It is called for every AI at the same time from different threads. Thus, it should
+     *  only read the game map and queue what it wants to change with pushCommand. Random
+     *  numbers should come from mRandom.
      *  \param frameTime Time elapsed since last call in seconds.
      */
     virtual bool doTurn(double timeSinceLastTurn) = 0;
 
+    //! \brief Applies the commands queued during doTurn in the order they were queued. Called
+    //! on the main thread
+    void applyCommands();
+
+    inline Player& getPlayer() const
+    { return mPlayer; }
+
 protected:
     BaseAI(GameMap& gameMap, Player& player);
 
+    inline void pushCommand(const AICommand& command)
+    { mCommands.push_back(command); }
+
+    //! \brief Called by applyCommands when a command could not be applied
+    virtual void notifyCommandFailed(const AICommand&)
+    {}
+
+    //! \brief Called by applyCommands for setupSkills commands
+    virtual void setupSkills()
+    {}
+
     Room* getDungeonTemple();
 
     //! \brief Searches for the best place where to place a room around the given tile. It will take
@@ -56,14 +80,26 @@ protected:
     bool findBestPlaceForRoom(Tile* tile, Seat* playerSeat, int32_t wantedSize, bool useWalls,
         int32_t& bestX, int32_t& bestY);
 
-    bool digWayToTile(Tile* tileStart, Tile* tileEnd);
     bool computePointsForRoom(Tile* tile, Seat* playerSeat, int32_t wantedSize,
         bool bottomLeft2TopRight, bool useWalls, int32_t& points);
 
     GameMap& mGameMap;
     Player& mPlayer;
 
+    //! \brief Seeded from the global generator when the AI is created
+    Random::Generator mRandom;
+
 private:
+    //! \brief Marks for digging the tiles needed to go from tileStart to tileEnd. It computes a path
+    //! so it can only be used on the main thread
+    bool digWayToTile(Tile* tileStart, Tile* tileEnd);
+
+    //! \brief Returns true if the command could be applied
+    bool applyCommand(const AICommand& command);
+
+    //! \brief Commands queued during the current turn
+    std::vector<AICommand> mCommands;
+
     bool shouldGroundTileBeConsideredForBestPlaceForRoom(Tile* tile, Seat* playerSeat);
     bool shouldWallTileBeConsideredForBestPlaceForRoom(Tile* tile, Seat* playerSeat);
 };
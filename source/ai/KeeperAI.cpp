@@ -31,7 +31,6 @@
 #include "spells/SpellSummonWorker.h"
 #include "utils/Helper.h"
 #include "utils/LogManager.h"
-#include "utils/Random.h"
 
 #include <vector>
 
@@ -47,6 +46,8 @@ static const std::vector<RoomType> wantedBuildings = {
     RoomType::crypt
 };
 
+//! \brief Tag of the commands digging to gold
+static const uint32_t COMMAND_TAG_GOLD = 1;
 
 KeeperAI::KeeperAI(GameMap& gameMap, Player& player, int cooldownDefenseMin, int cooldownDefenseMax,
              int cooldownSaveWoundedCreaturesMin, int cooldownSaveWoundedCreaturesMax,
@@ -113,6 +114,13 @@ bool KeeperAI::doTurn(double timeSinceLastTurn)
     return true;
 }
 
+void KeeperAI::notifyCommandFailed(const AICommand& command)
+{
+    // If we could not dig a way to the closest gold, we consider there is no more reachable gold
+    if(command.mTag == COMMAND_TAG_GOLD)
+        mNoMoreReachableGold = true;
+}
+
 bool KeeperAI::checkTreasury()
 {
     // If the treasury gets destroyed, we don't want the AI to build each turn the
@@ -122,7 +130,7 @@ bool KeeperAI::checkTreasury()
         --mCooldownCheckTreasury;
         return false;
     }
-    mCooldownCheckTreasury = Random::Int(10,30);
+    mCooldownCheckTreasury = mRandom.Int(10,30);
 
     int totalGold = 0;
     int totalStorage = 0;
@@ -162,12 +170,10 @@ bool KeeperAI::checkTreasury()
                 if(neigh->isBuildableUpon(mPlayer.getSeat()) &&
                    mGameMap.pathExists(worker, central, neigh))
                 {
-                    std::vector<Tile*> tiles;
-                    tiles.push_back(neigh);
-
-                    if(!RoomManager::buildRoomOnTiles(&mGameMap, RoomType::treasury, &mPlayer, tiles))
-                        return false;
-
+                    AICommand command(AICommandType::buildRoom);
+                    command.mRoomType = RoomType::treasury;
+                    command.mTiles.push_back(neigh);
+                    pushCommand(command);
                     return true;
                 }
             }
@@ -272,12 +278,10 @@ bool KeeperAI::checkTreasury()
     if(firstAvailableTile == nullptr)
         return true;
 
-    std::vector<Tile*> tiles;
-    tiles.push_back(firstAvailableTile);
-
-    if(!RoomManager::buildRoomOnTiles(&mGameMap, RoomType::treasury, &mPlayer, tiles))
-        return false;
-
+    AICommand command(AICommandType::buildRoom);
+    command.mRoomType = RoomType::treasury;
+    command.mTiles.push_back(firstAvailableTile);
+    pushCommand(command);
     return true;
 }
 
@@ -289,7 +293,7 @@ bool KeeperAI::handleRooms()
         return false;
     }
 
-    mCooldownLookingForRooms = Random::Int(mCooldownLookingForRoomsMin, mCooldownLookingForRoomsMax);
+    mCooldownLookingForRooms = mRandom.Int(mCooldownLookingForRoomsMin, mCooldownLookingForRoomsMax);
 
     // We check if the last built room is done
     if(mRoomSize != -1)
@@ -334,9 +338,10 @@ bool KeeperAI::handleRooms()
         OD_LOG_ERR("tileDest=" + Tile::displayAsString(tileDest) + ", mRoomPosX=" + Helper::toString(mRoomPosX) + ", mRoomPosY=" + Helper::toString(mRoomPosY));
         return false;
     }
-    if(!digWayToTile(central, tileDest))
-        return false;
-
+    // The way is computed when the command is applied
+    AICommand command(AICommandType::markDig);
+    command.mTileWayStart = central;
+    command.mTileWayEnd = tileDest;
     for(int xx = 0; xx < mRoomSize; ++xx)
     {
         for(int yy = 0; yy < mRoomSize; ++yy)
@@ -348,9 +353,10 @@ bool KeeperAI::handleRooms()
                 continue;
             }
 
-            tile->setMarkedForDigging(true, &mPlayer);
+            command.mTiles.push_back(tile);
         }
     }
+    pushCommand(command);
 
     return true;
 }
@@ -366,7 +372,7 @@ bool KeeperAI::lookForGold()
         return false;
     }
 
-    mCooldownLookingForGold = Random::Int(70,120);
+    mCooldownLookingForGold = mRandom.Int(70,120);
 
     // Do we need gold ?
     int emptyStorage = 0;
@@ -399,7 +405,7 @@ bool KeeperAI::lookForGold()
             {
                 // If we already have a tile at same distance, we randomly change to
                 // try to not be too predictable
-                if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                     firstGoldTile = t;
             }
             // North-West
@@ -408,7 +414,7 @@ bool KeeperAI::lookForGold()
                 t = mGameMap.getTile(central->getX() - k, central->getY() + distance);
                 if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
                 {
-                    if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                    if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                         firstGoldTile = t;
                 }
             }
@@ -416,7 +422,7 @@ bool KeeperAI::lookForGold()
             t = mGameMap.getTile(central->getX() + k, central->getY() - distance);
             if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
             {
-                if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                     firstGoldTile = t;
             }
             // South-West
@@ -425,7 +431,7 @@ bool KeeperAI::lookForGold()
                 t = mGameMap.getTile(central->getX() - k, central->getY() - distance);
                 if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
                 {
-                    if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                    if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                         firstGoldTile = t;
                 }
             }
@@ -433,7 +439,7 @@ bool KeeperAI::lookForGold()
             t = mGameMap.getTile(central->getX() + distance, central->getY() + k);
             if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
             {
-                if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                     firstGoldTile = t;
             }
             // East-South
@@ -442,7 +448,7 @@ bool KeeperAI::lookForGold()
                 t = mGameMap.getTile(central->getX() + distance, central->getY() - k);
                 if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
                 {
-                    if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                    if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                         firstGoldTile = t;
                 }
             }
@@ -450,7 +456,7 @@ bool KeeperAI::lookForGold()
             t = mGameMap.getTile(central->getX() - distance, central->getY() + k);
             if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
             {
-                if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                     firstGoldTile = t;
             }
             // West-South
@@ -459,7 +465,7 @@ bool KeeperAI::lookForGold()
                 t = mGameMap.getTile(central->getX() - distance, central->getY() - k);
                 if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
                 {
-                    if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                    if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                         firstGoldTile = t;
                 }
             }
@@ -480,12 +486,6 @@ bool KeeperAI::lookForGold()
         return false;
     }
 
-    if(!digWayToTile(central, firstGoldTile))
-    {
-        mNoMoreReachableGold = true;
-        return false;
-    }
-
     // If the neighbors are gold, we dig them
     const int levelTilesDig = 2;
     std::set<Tile*> tilesDig;
@@ -506,12 +506,28 @@ bool KeeperAI::lookForGold()
         }
     }
 
-    for(Tile* tile : tilesDig)
-        tile->setMarkedForDigging(true, &mPlayer);
+    // If no way can be dug up to the gold, notifyCommandFailed will be called
+    AICommand command(AICommandType::markDig);
+    command.mTileWayStart = central;
+    command.mTileWayEnd = firstGoldTile;
+    command.mTiles.assign(tilesDig.begin(), tilesDig.end());
+    command.mTag = COMMAND_TAG_GOLD;
+    pushCommand(command);
 
     return true;
 }
 
+void KeeperAI::pushPickUpAndDrop(Creature* creature, Tile* tile)
+{
+    AICommand pickUp(AICommandType::pickUp);
+    pickUp.mCreature = creature;
+    pushCommand(pickUp);
+
+    AICommand drop(AICommandType::drop);
+    drop.mTiles.push_back(tile);
+    pushCommand(drop);
+}
+
 bool KeeperAI::buildMostNeededRoom()
 {
     for(RoomType roomType: wantedBuildings)
@@ -536,10 +552,10 @@ bool KeeperAI::buildRoom(RoomType roomType, int x, int y, int roomSize)
     if (tiles.size() < static_cast<uint32_t>(roomSize * roomSize))
         return false;
 
-    if(!RoomManager::buildRoomOnTiles(&mGameMap, roomType, &mPlayer, tiles))
-        return false;
-
-    OD_LOG_INF("AI seatId=" + Helper::toString(mPlayer.getSeat()->getId())+ " builds room type=" + Helper::toString(static_cast<uint32_t>(roomType)) + ", x=" + Helper::toString(x) + ", y=" + Helper::toString(y) + ", roomSize=" + Helper::toString(roomSize));
+    AICommand command(AICommandType::buildRoom);
+    command.mRoomType = roomType;
+    command.mTiles = tiles;
+    pushCommand(command);
     return true;
 }
 
@@ -607,7 +623,7 @@ void KeeperAI::saveWoundedCreatures()
         --mCooldownSaveWoundedCreatures;
         return;
     }
-    mCooldownSaveWoundedCreatures = Random::Int(mCooldownSaveWoundedCreaturesMin, mCooldownSaveWoundedCreaturesMax);
+    mCooldownSaveWoundedCreatures = mRandom.Int(mCooldownSaveWoundedCreaturesMin, mCooldownSaveWoundedCreaturesMax);
 
     Tile* dungeonTempleTile = getDungeonTemple()->getCentralTile();
     if(dungeonTempleTile == nullptr)
@@ -637,9 +653,7 @@ void KeeperAI::saveWoundedCreatures()
         if(!creature->tryPickup(seat))
             continue;
 
-        mPlayer.pickUpEntity(creature);
-
-        mPlayer.dropHand(dungeonTempleTile);
+        pushPickUpAndDrop(creature, dungeonTempleTile);
     }
 }
 
@@ -650,7 +664,7 @@ void KeeperAI::handleDefense()
         --mCooldownDefense;
         return;
     }
-    mCooldownDefense = Random::Int(mCooldownDefenseMin, mCooldownDefenseMax);
+    mCooldownDefense = mRandom.Int(mCooldownDefenseMin, mCooldownDefenseMax);
 
     Seat* seat = mPlayer.getSeat();
     // We drop creatures nearby owned or allied attacked creatures
@@ -690,8 +704,7 @@ void KeeperAI::handleDefense()
         {
             if(creatureToDrop->tryDrop(seat, neigh))
             {
-                mPlayer.pickUpEntity(creatureToDrop);
-                mPlayer.dropHand(neigh);
+                pushPickUpAndDrop(creatureToDrop, neigh);
                 return;
             }
         }
@@ -706,7 +719,7 @@ bool KeeperAI::handleWorkers()
         return false;
     }
 
-    mCooldownWorkers = Random::Int(3,10);
+    mCooldownWorkers = mRandom.Int(3,10);
 
     // We want to use the first covered tile because the central might be destroyed and enemy claimed
     // and, if it is the case, we will not be able to spawn a worker.
@@ -719,14 +732,11 @@ bool KeeperAI::handleWorkers()
     // If we have less than 4 workers or we have the chance, we summon
     int nbWorkers = mPlayer.getSeat()->getNumCreaturesWorkers();
     if((nbWorkers < 4) ||
-       (Random::Int(0, nbWorkers * 3) == 0))
+       (mRandom.Int(0, nbWorkers * 3) == 0))
     {
-        Tile* tile = getDungeonTemple()->getCoveredTile(0);
-        std::vector<Tile*> tiles;
-        tiles.push_back(tile);
-        if(!SpellSummonWorker::summonWorkersOnTiles(&mGameMap, &mPlayer, tiles))
-            return false;
-
+        AICommand command(AICommandType::summonWorkers);
+        command.mTiles.push_back(getDungeonTemple()->getCoveredTile(0));
+        pushCommand(command);
         return true;
     }
 
@@ -741,7 +751,7 @@ bool KeeperAI::repairRooms()
         return false;
     }
 
-    mCooldownRepairRooms = Random::Int(20,60);
+    mCooldownRepairRooms = mRandom.Int(20,60);
 
     Seat* seat = mPlayer.getSeat();
     for(Room* room : mGameMap.getRooms())
@@ -752,14 +762,13 @@ bool KeeperAI::repairRooms()
         if(!room->canBeRepaired())
             continue;
 
-        int goldRequired = room->getCostRepair();
-
-        if(!mGameMap.withdrawFromTreasuries(goldRequired, mPlayer.getSeat()))
+        if(room->getCostRepair() > seat->getGold())
             return false;
 
-        room->repairRoom();
-        // We only repair one room at a time. Note that if we want to repair more than one room at a time, we should pay
-        // attention to not modify the room list (if room absorbed in RoomManager::buildRoom) while iterating it
+        AICommand command(AICommandType::repairRoom);
+        command.mRoom = room;
+        pushCommand(command);
+        // We only repair one room at a time
         break;
     }
 
@@ -825,9 +834,7 @@ bool KeeperAI::handleTiredCreatures()
         if(!creature->tryPickup(mPlayer.getSeat()))
             continue;
 
-        mPlayer.pickUpEntity(creature);
-
-        mPlayer.dropHand(dropTile);
+        pushPickUpAndDrop(creature, dropTile);
 
         // We help only 1 creature per turn
         return true;
@@ -868,9 +875,7 @@ bool KeeperAI::handleHungryCreatures()
         if(!creature->tryPickup(mPlayer.getSeat()))
             continue;
 
-        mPlayer.pickUpEntity(creature);
-
-        mPlayer.dropHand(dungeonTempleTile);
+        pushPickUpAndDrop(creature, dungeonTempleTile);
 
         // We help only 1 creature per turn
         return true;
@@ -880,6 +885,12 @@ bool KeeperAI::handleHungryCreatures()
 }
 
 void KeeperAI::handleFirstTurn()
+{
+    // Setting the skill tree modifies the seat so it is done when the command is applied
+    pushCommand(AICommand(AICommandType::setupSkills));
+}
+
+void KeeperAI::setupSkills()
 {
     Seat* seat = mPlayer.getSeat();
     // We set the skills to research. We start with pending skills to not modify research
@@ -32,6 +32,10 @@ public:
     virtual bool doTurn(double timeSinceLastTurn);
 
 protected:
+    virtual void notifyCommandFailed(const AICommand& command);
+
+    virtual void setupSkills();
+
     //! \brief Checks if the AI has a treasury. If not, we search for the first available tile
     //! to add it
     //! Returns true if the action has been done and false if nothing has been done
@@ -74,10 +78,13 @@ protected:
     void handleFirstTurn();
 
 private:
+    //! \brief Queues the commands to pick up the given creature and to drop it on the given tile
+    void pushPickUpAndDrop(Creature* creature, Tile* tile);
+
     //! \brief try to build the most needed available room
     bool buildMostNeededRoom();
 
-    //! \brief Try to build the given room on the given position. Returns true if the room was built and
+    //! \brief Try to build the given room on the given position. Returns true if the room will be built and
     //! false otherwise
     bool buildRoom(RoomType roomType, int x, int y, int roomSize);
 
@@ -53,7 +53,7 @@ bool CreatureActionClaimGroundTile::handleCreatureActionClaimGroundTile(Creature
     // We check if we are on the expected tile. If not, we go there
     if(myTile != &tileClaim)
     {
-        if(!creature.setDestination(&tileClaim))
+        if(!creature.setDestinationAsync(&tileClaim))
             creature.popAction();
 
         return true;
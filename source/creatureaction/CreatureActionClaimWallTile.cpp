@@ -86,7 +86,7 @@ bool CreatureActionClaimWallTile::handleClaimWallTile(Creature& creature, Tile&
 
     if(tileDest != myTile)
     {
-        if(!creature.setDestination(tileDest))
+        if(!creature.setDestinationAsync(tileDest))
         {
             OD_LOG_ERR("creature=" + creature.getName() + ", myTile=" + Tile::displayAsString(myTile) + ", tileClaim=" + Tile::displayAsString(&tileClaim) + ", tileDest=" + Tile::displayAsString(tileDest));
             creature.popAction();
@@ -72,7 +72,7 @@ bool CreatureActionDigTile::handleDigTile(Creature& creature, Tile& tileDig, Til
     // We go to the tile we locked
     if(&tilePos != myTile)
     {
-        if(!creature.setDestination(&tilePos))
+        if(!creature.setDestinationAsync(&tilePos))
         {
             OD_LOG_ERR("creature=" + creature.getName() + ", myTile=" + Tile::displayAsString(myTile) + ", tileDig=" + Tile::displayAsString(&tileDig) + ", tilePos=" + Tile::displayAsString(&tilePos));
             creature.popAction();
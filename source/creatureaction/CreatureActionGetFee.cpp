@@ -101,11 +101,11 @@ bool CreatureActionGetFee::handleGetFee(Creature& creature)
         return true;
     }
 
-    Tile* chosenTile = nullptr;
-    std::list<Tile*> tilePath = creature.getGameMap()->findBestPath(&creature, myTile,
-        availableTreasuries, chosenTile);
+    // On pay day, every creature of the seat goes to the treasuries so we share the same flow field
+    std::list<Tile*> tilePath = creature.getGameMap()->pathFromFlowField(&creature, myTile,
+        availableTreasuries);
 
-    if(tilePath.empty() || (chosenTile == nullptr))
+    if(tilePath.empty())
     {
         // No available treasury
         creature.popAction();
@@ -153,7 +153,7 @@ bool CreatureActionSearchJob::handleSearchJob(Creature& creature, bool forced)
             {
                 int index = Random::Int(0, room->numCoveredTiles() - 1);
                 Tile* tileDest = room->getCoveredTile(index);
-                creature.setDestination(tileDest);
+                creature.setDestinationAsync(tileDest);
                 return false;
             }
 
@@ -18,17 +18,39 @@
 #include "creatureaction/CreatureActionWalkToTile.h"
 
 #include "entities/Creature.h"
+#include "gamemap/GameMap.h"
+#include "gamemap/PathJobQueue.h"
 
 #include <functional>
 
 std::function<bool()> CreatureActionWalkToTile::action()
 {
     return std::bind(&CreatureActionWalkToTile::handleWalkToTile,
-        std::ref(mCreature));
+        std::ref(mCreature), std::ref(mPathRequest), mTileDest);
 }
 
-bool CreatureActionWalkToTile::handleWalkToTile(Creature& creature)
+bool CreatureActionWalkToTile::handleWalkToTile(Creature& creature, std::shared_ptr<PathRequest>& pathRequest, Tile* tileDest)
 {
+    if(pathRequest != nullptr)
+    {
+        // The path is computed in the background
+        if(!pathRequest->isReady())
+            return false;
+
+        // If some tiles got closed since the path was computed, it may not be valid anymore
+        std::list<Tile*> result;
+        if(pathRequest->isOutdated())
+            result = creature.getGameMap()->path(&creature, tileDest);
+        else
+            result = pathRequest->getPath();
+
+        pathRequest.reset();
+
+        std::vector<Ogre::Vector3> path;
+        creature.tileToVector3(result, path, true, 0.0);
+        creature.setWalkPath(EntityAnimation::walk_anim, EntityAnimation::idle_anim, true, true, path);
+    }
+
     if (creature.isMoving())
         return false;
 
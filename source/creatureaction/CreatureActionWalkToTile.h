@@ -20,11 +20,25 @@
 
 #include "creatureaction/CreatureAction.h"
 
+#include <memory>
+
+class PathRequest;
+class Tile;
+
 class CreatureActionWalkToTile : public CreatureAction
 {
 public:
+    //! \brief Waits until the creature stops walking the path it has been given
     CreatureActionWalkToTile(Creature& creature) :
-        CreatureAction(creature)
+        CreatureAction(creature),
+        mTileDest(nullptr)
+    {}
+
+    //! \brief Waits for the given path request to be ready and walks the path to tileDest
+    CreatureActionWalkToTile(Creature& creature, const std::shared_ptr<PathRequest>& pathRequest, Tile& tileDest) :
+        CreatureAction(creature),
+        mPathRequest(pathRequest),
+        mTileDest(&tileDest)
     {}
 
     virtual ~CreatureActionWalkToTile()
@@ -35,7 +49,11 @@ public:
 
     std::function<bool()> action() override;
 
-    static bool handleWalkToTile(Creature& creature);
+    static bool handleWalkToTile(Creature& creature, std::shared_ptr<PathRequest>& pathRequest, Tile* tileDest);
+
+private:
+    std::shared_ptr<PathRequest> mPathRequest;
+    Tile* mTileDest;
 };
 
 #endif // CREATUREACTIONWALKTOTILE_H
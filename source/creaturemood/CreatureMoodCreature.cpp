@@ -50,10 +50,10 @@ const std::string& CreatureMoodCreature::getModifierName() const
 
 int32_t CreatureMoodCreature::computeMood(const Creature& creature) const
 {
-    std::vector<GameEntity*> alliedCreatures = creature.getGameMap()->getVisibleCreatures(creature.getVisibleTiles(),
-        creature.getSeat(), false);
+    // The mood is computed during the upkeep, once the visible allied objects are known. That
+    // avoids looking at the visible tiles again
     int nbCreatures = 0;
-    for(GameEntity* entity : alliedCreatures)
+    for(GameEntity* entity : creature.getVisibleAlliedObjects())
     {
         if(entity->getObjectType() != GameEntityType::creature)
             continue;
@@ -436,7 +436,10 @@ bool Building::importFromStream(std::istream& is)
         }
 
         if(tileData->mHP > 0)
+        {
             tile->setSeat(getSeat());
+            tile->refreshHotState();
+        }
     }
 
     return true;
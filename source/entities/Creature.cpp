@@ -100,6 +100,33 @@ static const Ogre::Real CANNON_MISSILE_HEIGHT = 0.3;
 const int32_t Creature::NB_TURNS_BEFORE_CHECKING_TASK = 15;
 const uint32_t Creature::NB_OVERLAY_HEALTH_VALUES = 8;
 
+//! \brief Copies in objects the sensed objects that are still relevant. Since the sense phase, some of them
+//! may have been removed from the gamemap or killed by the creatures that did their upkeep before. Some may
+//! also have changed seat (like a converted creature or a claimed room) as well as the given seat, so the
+//! alliance is checked again: the objects kept are allied with seat (or not allied if enemy is true)
+static void copyStillSensedObjects(const std::vector<GameEntity*>& sensedObjects, Seat* seat, bool enemy,
+    std::vector<GameEntity*>& objects)
+{
+    objects.clear();
+    for(GameEntity* entity : sensedObjects)
+    {
+        if(!entity->getIsOnMap())
+            continue;
+
+        Seat* entitySeat = entity->getSeat();
+        if((entitySeat == nullptr) || (entitySeat->isAlliedSeat(seat) == enemy))
+            continue;
+
+        if((entity->getObjectType() == GameEntityType::creature) &&
+           !static_cast<Creature*>(entity)->isAlive())
+        {
+            continue;
+        }
+
+        objects.push_back(entity);
+    }
+}
+
 CreatureParticleEffect::CreatureParticleEffect(Creature& creature, const std::string& name, const std::string& script, uint32_t nbTurnsEffect,
         CreatureEffect* effect) :
     EntityParticleEffect(name, script, nbTurnsEffect),
@@ -171,7 +198,9 @@ Creature::Creature(GameMap* gameMap, const CreatureDefinition* definition, Seat*
     mSeatPrison              (nullptr),
     mNbTurnsTorture          (0),
     mNbTurnsPrison           (0),
-    mActiveSlapsCount        (0)
+    mActiveSlapsCount        (0),
+    mSeatCounted             (nullptr),
+    mSensedTurn              (-1)
 
 {
     //TODO: This should be set in initialiser list in parent classes
@@ -249,7 +278,9 @@ Creature::Creature(GameMap* gameMap) :
     mSeatPrison              (nullptr),
     mNbTurnsTorture          (0),
     mNbTurnsPrison           (0),
-    mActiveSlapsCount        (0)
+    mActiveSlapsCount        (0),
+    mSeatCounted             (nullptr),
+    mSensedTurn              (-1)
 {
 }
 
@@ -677,25 +708,35 @@ void Creature::update(Ogre::Real timeSinceLastFrame)
 
 void Creature::computeVisibleTiles()
 {
-    // dead Creatures do not give vision
-    if (getHP() <= 0.0)
+    if (!needsTilesInSightUpdate())
         return;
 
-    // KO Creatures do not give vision
-    if (isKo())
-        return;
+    // Look at the surrounding area
+    updateTilesInSight();
+    setVisionSource();
+}
 
-    // creatures in jail do not give vision
-    if (mSeatPrison != nullptr)
-        return;
+bool Creature::needsTilesInSightUpdate()
+{
+    VisionMap& visionMap = getGameMap()->getVisionMap();
 
-    if (!getIsOnMap())
-        return;
+    // dead Creatures do not give vision. KO Creatures and creatures in jail
+    // do not give vision either
+    if ((getHP() <= 0.0) || isKo() || (mSeatPrison != nullptr) || !getIsOnMap())
+    {
+        visionMap.removeSource(*this);
+        return false;
+    }
 
-    // Look at the surrounding area
-    updateTilesInSight();
-    for(Tile* tile : mVisibleTiles)
-        tile->notifyVision(getSeat());
+    // If the creature did not move and nothing changed around, the tiles it sees are the same
+    uint32_t radius = static_cast<uint32_t>(mDefinition->getSightRadius());
+    return visionMap.needsUpdate(*this, getSeat(), getPositionTile(), radius);
+}
+
+void Creature::setVisionSource()
+{
+    uint32_t radius = static_cast<uint32_t>(mDefinition->getSightRadius());
+    getGameMap()->getVisionMap().setSource(*this, getSeat(), getPositionTile(), radius, mVisibleTiles, true);
 }
 
 void Creature::setLevel(unsigned int level)
@@ -896,9 +937,21 @@ void Creature::doUpkeep()
         increaseHunger(mDefinition->getHungerGrowthPerTurn());
     }
 
-    mVisibleEnemyObjects         = getVisibleEnemyObjects();
-    mVisibleAlliedObjects        = getVisibleAlliedObjects();
-    mReachableAlliedObjects      = getReachableAttackableObjects(mVisibleAlliedObjects);
+    // If the visible objects have been computed during the sense phase, we use them
+    if(mSensedTurn == getGameMap()->getTurnNumber())
+    {
+        copyStillSensedObjects(mSensedEnemyObjects, getSeat(), true, mVisibleEnemyObjects);
+        copyStillSensedObjects(mSensedAlliedObjects, getSeat(), false, mVisibleAlliedObjects);
+        // The paths have been checked during the sense phase too. We only drop the objects that are
+        // not relevant anymore
+        copyStillSensedObjects(mSensedReachableAlliedObjects, getSeat(), false, mReachableAlliedObjects);
+    }
+    else
+    {
+        getGameMap()->getVisibleForce(mVisibleTiles, getSeat(), true, mVisibleEnemyObjects);
+        getGameMap()->getVisibleForce(mVisibleTiles, getSeat(), false, mVisibleAlliedObjects);
+        getReachableAttackableObjects(mVisibleAlliedObjects, mReachableAlliedObjects);
+    }
 
     // Check if we should compute mood
     if(mMoodCooldownTurns > 0)
@@ -1092,7 +1145,9 @@ bool Creature::handleIdleAction()
             uint32_t index = Random::Uint(0,reachableCallToWars.size()-1);
             Spell* callToWar = reachableCallToWars[index];
             Tile* callToWarTile = callToWar->getPositionTile();
-            std::list<Tile*> tempPath = getGameMap()->path(this, callToWarTile);
+            // Every creature of the seat is likely to go to the same call to war
+            std::list<Tile*> tempPath = getGameMap()->pathFromFlowField(this, getPositionTile(),
+                std::vector<Tile*>(1, callToWarTile));
             // If we are 5 tiles from the call to war, we don't go there
             if(tempPath.size() >= 5)
             {
@@ -1650,14 +1705,25 @@ void Creature::updateTilesInSight()
     mVisibleTiles = getGameMap()->visibleTiles(posTile->getX(), posTile->getY(), mDefinition->getSightRadius());
 }
 
+void Creature::updateTilesInSight(LineOfSight& lineOfSight)
+{
+    Tile* posTile = getPositionTile();
+    if (posTile == nullptr)
+        return;
+
+    mTilesWithinSightRadius = getGameMap()->circularRegion(posTile->getX(), posTile->getY(), mDefinition->getSightRadius());
+    mVisibleTiles = getGameMap()->visibleTiles(posTile->getX(), posTile->getY(), mDefinition->getSightRadius(), lineOfSight);
+}
+
 std::vector<GameEntity*> Creature::getVisibleEnemyObjects()
 {
     return getVisibleForce(getSeat(), true);
 }
 
-std::vector<GameEntity*> Creature::getReachableAttackableObjects(const std::vector<GameEntity*>& objectsToCheck)
+void Creature::getReachableAttackableObjects(const std::vector<GameEntity*>& objectsToCheck,
+    std::vector<GameEntity*>& objects) const
 {
-    std::vector<GameEntity*> tempVector;
+    objects.clear();
     Tile* myTile = getPositionTile();
 
     // Loop over the vector of objects we are supposed to check.
@@ -1671,10 +1737,8 @@ std::vector<GameEntity*> Creature::getReachableAttackableObjects(const std::vect
 
         Tile* objectTile = entity->getCoveredTile(0);
         if (getGameMap()->pathExists(this, myTile, objectTile))
-            tempVector.push_back(objectsToCheck[i]);
+            objects.push_back(objectsToCheck[i]);
     }
-
-    return tempVector;
 }
 
 std::vector<GameEntity*> Creature::getCreaturesFromList(const std::vector<GameEntity*> &objectsToCheck, bool workersOnly)
@@ -1706,7 +1770,25 @@ std::vector<GameEntity*> Creature::getVisibleAlliedObjects()
 
 std::vector<GameEntity*> Creature::getVisibleForce(Seat* seat, bool invert)
 {
-    return getGameMap()->getVisibleForce(mVisibleTiles, seat, invert);
+    std::vector<GameEntity*> forces;
+    getGameMap()->getVisibleForce(mVisibleTiles, seat, invert, forces);
+    return forces;
+}
+
+bool Creature::isSensingObjects() const
+{
+    // Same conditions as the ones for reaching the visible objects computation in doUpkeep
+    return getIsOnMap() && isAlive() && (mKoTurnCounter == 0) && (mSeatPrison == nullptr);
+}
+
+void Creature::senseObjects(EntitySpatialIndex::TileMarks& tileMarks)
+{
+    // The sensed lists keep their capacity from one turn to the next
+    getGameMap()->getVisibleForce(mVisibleTiles, getSeat(), true, tileMarks, mSensedEnemyObjects);
+    getGameMap()->getVisibleForce(mVisibleTiles, getSeat(), false, tileMarks, mSensedAlliedObjects);
+    // GameMap::pathExists only reads the floodfill values
+    getReachableAttackableObjects(mSensedAlliedObjects, mSensedReachableAlliedObjects);
+    mSensedTurn = getGameMap()->getTurnNumber();
 }
 
 void Creature::computeVisualDebugEntities()
@@ -2350,6 +2432,19 @@ bool Creature::setDestination(Tile* tile)
     return true;
 }
 
+bool Creature::setDestinationAsync(Tile* tile)
+{
+    if(tile == nullptr)
+        return false;
+
+    Tile *posTile = getPositionTile();
+    if(posTile == nullptr)
+        return false;
+
+    pushAction(Utils::make_unique<CreatureActionWalkToTile>(*this, getGameMap()->requestPath(this, tile), *tile));
+    return true;
+}
+
 bool Creature::wanderRandomly(const std::string& animationState)
 {
     // We pick randomly a visible tile far away (at the end of visible tiles)
@@ -2548,8 +2643,7 @@ void Creature::fireAddEntity(Seat* seat, bool async)
 
         serverNotification = new ServerNotification(
             ServerNotificationType::carryEntity, seat->getPlayer());
-        serverNotification->mPacket << getName() << mCarriedEntity->getObjectType();
-        serverNotification->mPacket << mCarriedEntity->getName();
+        serverNotification->mPacket << getNetworkId() << mCarriedEntity->getNetworkId();
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
 }
@@ -2561,20 +2655,16 @@ void Creature::fireRemoveEntity(Seat* seat)
     {
         ServerNotification* serverNotification = new ServerNotification(
             ServerNotificationType::releaseCarriedEntity, seat->getPlayer());
-        serverNotification->mPacket << getName() << mCarriedEntity->getObjectType();
-        serverNotification->mPacket << mCarriedEntity->getName();
+        serverNotification->mPacket << getNetworkId() << mCarriedEntity->getNetworkId();
         serverNotification->mPacket << mPosition;
         ODServer::getSingleton().queueServerNotification(serverNotification);
 
         mCarriedEntity->removeSeatWithVision(seat);
     }
 
-    const std::string& name = getName();
     ServerNotification *serverNotification = new ServerNotification(
         ServerNotificationType::removeEntity, seat->getPlayer());
-    GameEntityType type = getObjectType();
-    serverNotification->mPacket << type;
-    serverNotification->mPacket << name;
+    serverNotification->mPacket << getNetworkId();
     ODServer::getSingleton().queueServerNotification(serverNotification);
 }
 
@@ -2591,13 +2681,11 @@ void Creature::fireCreatureRefreshIfNeeded()
         if(!seat->getPlayer()->getIsHuman())
             continue;
 
-        const std::string& name = getName();
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::entitiesRefresh, seat->getPlayer());
         uint32_t nbCreature = 1;
         serverNotification->mPacket << nbCreature;
-        serverNotification->mPacket << GameEntityType::creature;
-        serverNotification->mPacket << name;
+        serverNotification->mPacket << getNetworkId();
         exportToPacketForUpdate(serverNotification->mPacket, seat);
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
@@ -2894,6 +2982,9 @@ void Creature::computeCreatureOverlayHealthValue()
         mOverlayHealthValue = value;
         mNeedFireRefresh = true;
     }
+
+    // Every hp change ends here so we check if the creature just died
+    updateSeatCounters();
 }
 
 void Creature::computeCreatureOverlayMoodValue()
@@ -3220,6 +3311,9 @@ void Creature::changeSeat(Seat* newSeat)
     OD_LOG_INF("creature=" + getName() + " changes side from seatId=" + Helper::toString(getSeat()->getId()) + " to seatId=" + Helper::toString(newSeat->getId()));
     OD_ASSERT_TRUE_MSG(getSeat() != newSeat, "creature=" + getName() + ", seatId=" + Helper::toString(newSeat->getId()));
     setSeat(newSeat);
+    updateSeatCounters();
+    // The objects sensed with the former seat are not relevant anymore
+    mSensedTurn = -1;
     mMoodValue = CreatureMoodLevel::Neutral;
     mMoodPoints = 0;
     mWakefulness = 100;
@@ -3236,3 +3330,27 @@ void Creature::changeSeat(Seat* newSeat)
         home->releaseTileForSleeping(getHomeTile(), this);
     }
 }
+
+void Creature::updateSeatCounters()
+{
+    if(!getIsOnServerMap())
+        return;
+
+    // A creature is counted by its seat while it is alive on the gamemap (from GameMap::addCreature
+    // until GameMap::removeCreature)
+    Seat* seat = nullptr;
+    if(isAlive() && (getGameMap()->getCreature(getName()) == this))
+        seat = getSeat();
+
+    if(seat == mSeatCounted)
+        return;
+
+    bool isWorker = getDefinition()->isWorker();
+    if(mSeatCounted != nullptr)
+        mSeatCounted->notifyCreatureCounted(isWorker, false);
+
+    if(seat != nullptr)
+        seat->notifyCreatureCounted(isWorker, true);
+
+    mSeatCounted = seat;
+}
@@ -22,6 +22,7 @@
 #define CREATURE_H
 
 #include "entities/MovableGameEntity.h"
+#include "gamemap/EntitySpatialIndex.h"
 
 #include <OgreVector2.h>
 #include <OgreVector3.h>
@@ -38,6 +39,7 @@ class CreatureDefinition;
 class CreatureOverlayStatus;
 class CreatureSkill;
 class GameMap;
+class LineOfSight;
 class ODPacket;
 class Room;
 class Weapon;
@@ -204,6 +206,10 @@ public:
 
     bool setDestination(Tile* tile);
 
+    //! \brief Same as setDestination but the path is computed in the background. The creature
+    //! will start walking when it is ready (usually at the next turn)
+    bool setDestinationAsync(Tile* tile);
+
     //! \brief Picks a destination far away in the visible tiles and goes there
     //! Returns true if a valid Tile was found. The creature will go there
     //! Returns false if no reachable Tile was found
@@ -252,6 +258,13 @@ public:
     //! \brief Computes the visible tiles and tags them to know which are visible
     void computeVisibleTiles();
 
+    //! \brief Returns true if the tiles seen by this creature have to be computed again (with updateTilesInSight)
+    //! before calling setVisionSource. If the creature does not give vision, its vision source is removed
+    bool needsTilesInSightUpdate();
+
+    //! \brief Gives vision on the tiles computed by the last updateTilesInSight
+    void setVisionSource();
+
     virtual bool isAttackable(Tile* tile, Seat* seat) const override;
 
     double getPhysicalDefense() const;
@@ -265,11 +278,18 @@ public:
     //! And the tiles the creature can "see" (removing the ones behind walls).
     void updateTilesInSight();
 
+    //! \brief Same as updateTilesInSight but uses the given LineOfSight instead of the game map one. It only
+    //! reads the game map so it can be called from worker threads as long as each thread uses its own LineOfSight
+    //! with the tile distances already computed for the creature sight
+    void updateTilesInSight(LineOfSight& lineOfSight);
+
     //! \brief Loops over the visibleTiles and adds all enemy creatures in each tile to a list which it returns.
     std::vector<GameEntity*> getVisibleEnemyObjects();
 
-    //! \brief Loops over objectsToCheck and returns a vector containing all the ones which can be reached via a valid path.
-    std::vector<GameEntity*> getReachableAttackableObjects(const std::vector<GameEntity*> &objectsToCheck);
+    //! \brief Loops over objectsToCheck and fills objects with all the ones which can be reached via a valid path.
+    //! It only reads the gamemap so it can be called during the sense phase
+    void getReachableAttackableObjects(const std::vector<GameEntity*>& objectsToCheck,
+        std::vector<GameEntity*>& objects) const;
 
     //! \brief Loops over objectsToCheck and returns a vector containing all the creatures in the list.
     std::vector<GameEntity*> getCreaturesFromList(const std::vector<GameEntity*> &objectsToCheck, bool workersOnly);
@@ -588,6 +608,19 @@ public:
     //! \brief Called when the creature changes seat (for example when it becomes rogue or after torture)
     void changeSeat(Seat* newSeat);
 
+    //! \brief Server side. Updates the workers/fighters counters of the seats when the creature is added to/removed
+    //! from the gamemap, dies or changes seat
+    void updateSeatCounters();
+
+    //! \brief Server side. Returns true if the creature will look for visible objects during its next upkeep
+    bool isSensingObjects() const;
+
+    /*! \brief Server side. Sense phase of the upkeep (see GameMap::doMiscUpkeep): computes the enemy and allied
+     * objects the creature sees, and the allied ones it can reach, so that doUpkeep does not have to. It only reads the gamemap. Thus, it can be
+     * called for several creatures at the same time from different threads as long as each thread uses its own tileMarks.
+     */
+    void senseObjects(EntitySpatialIndex::TileMarks& tileMarks);
+
 protected:
     virtual void exportToPacket(ODPacket& os, const Seat* seat) const override;
     virtual void importFromPacket(ODPacket& is) override;
@@ -758,6 +791,15 @@ private:
     //! \brief Counts the number of active slaps affecting the creature
     uint32_t                        mActiveSlapsCount;
 
+    //! \brief Seat counting this creature in its workers/fighters (see updateSeatCounters)
+    Seat*                           mSeatCounted;
+
+    //! \brief Objects seen during the sense phase of the turn mSensedTurn (see senseObjects)
+    std::vector<GameEntity*>        mSensedEnemyObjects;
+    std::vector<GameEntity*>        mSensedAlliedObjects;
+    std::vector<GameEntity*>        mSensedReachableAlliedObjects;
+    int64_t                         mSensedTurn;
+
     //! \brief Skills the creature can use
     std::vector<CreatureSkillData> mSkillData;
 
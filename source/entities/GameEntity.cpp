@@ -88,6 +88,7 @@ GameEntity::GameEntity(
           ) :
     mPosition          (Ogre::Vector3::ZERO),
     mName              (name),
+    mNetworkId         (0),
     mMeshName          (meshName),
     mMeshExists        (false),
     mSeat              (seat),
@@ -375,6 +376,7 @@ void GameEntity::exportToPacket(ODPacket& os, const Seat* seat) const
     if(mSeat != nullptr)
         seatId = mSeat->getId();
 
+    os << mNetworkId;
     os << seatId;
     os << mName;
     os << mMeshName;
@@ -389,6 +391,7 @@ void GameEntity::exportToPacket(ODPacket& os, const Seat* seat) const
 void GameEntity::importFromPacket(ODPacket& is)
 {
     int seatId;
+    OD_ASSERT_TRUE(is >> mNetworkId);
     OD_ASSERT_TRUE(is >> seatId);
     if(seatId != -1)
         mSeat = mGameMap->getSeatById(seatId);
@@ -168,6 +168,11 @@ class GameEntity
     inline const std::string& getName() const
     { return mName; }
 
+    //! \brief Id used to address the entity in the network messages. It is given by the server
+    //! GameMap when the entity is added and sent to the clients with addEntity. 0 means no id
+    inline uint32_t getNetworkId() const
+    { return mNetworkId; }
+
     //! \brief Get the mesh name of the object
     inline const std::string& getMeshName() const
     { return mMeshName; }
@@ -193,6 +198,9 @@ class GameEntity
     inline void setName(const std::string& name)
     { mName = name; }
 
+    inline void setNetworkId(uint32_t networkId)
+    { mNetworkId = networkId; }
+
     //! \brief Set the name of the mesh file
     inline void setMeshName(const std::string& meshName)
     { mMeshName = meshName; }
@@ -426,6 +434,9 @@ class GameEntity
     //! brief The name of the entity
     std::string mName;
 
+    //! \brief Id of the entity in the network messages
+    uint32_t mNetworkId;
+
     //! \brief The name of the mesh
     std::string mMeshName;
 
@@ -174,12 +174,9 @@ void MapLight::fireAddEntity(Seat* seat, bool async)
 
 void MapLight::fireRemoveEntity(Seat* seat)
 {
-    const std::string& name = getName();
     ServerNotification *serverNotification = new ServerNotification(
         ServerNotificationType::removeEntity, seat->getPlayer());
-    GameEntityType type = getObjectType();
-    serverNotification->mPacket << type;
-    serverNotification->mPacket << name;
+    serverNotification->mPacket << getNetworkId();
     ODServer::getSingleton().queueServerNotification(serverNotification);
 }
 
@@ -24,7 +24,10 @@
 #include "entities/TreasuryObject.h"
 #include "game/Player.h"
 #include "game/Seat.h"
+#include "gamemap/EntitySpatialIndex.h"
 #include "gamemap/GameMap.h"
+#include "gamemap/TileHotState.h"
+#include "gamemap/VisionMap.h"
 #include "network/ODPacket.h"
 #include "render/RenderManager.h"
 #include "rooms/Room.h"
@@ -490,155 +493,42 @@ bool Tile::isFloodFillFilled(Seat* seat) const
 
 bool Tile::isFloodFillPossible(Seat* seat, FloodFillType type) const
 {
-    // No floodfill can be set on full tiles
-    if(getFullness() > 0.0)
-        return false;
-
-    switch(getType())
-    {
-        case TileType::dirt:
-        case TileType::gold:
-        case TileType::rock:
-        {
-            switch(type)
-            {
-                case FloodFillType::ground:
-                case FloodFillType::groundWater:
-                case FloodFillType::groundLava:
-                case FloodFillType::groundWaterLava:
-                {
-                    return true;
-                }
-                default:
-                    return false;
-            }
-        }
-        case TileType::water:
-        {
-            switch(type)
-            {
-                case FloodFillType::groundWater:
-                case FloodFillType::groundWaterLava:
-                {
-                    return true;
-                }
-                default:
-                    return false;
-            }
-        }
-        case TileType::lava:
-        {
-            switch(type)
-            {
-                case FloodFillType::groundLava:
-                case FloodFillType::groundWaterLava:
-                {
-                    return true;
-                }
-                default:
-                    return false;
-            }
-        }
-        default:
-            return false;
-    }
-
-    return false;
+    return TileHotState::isFloodFillPossible(getType(), getFullness(), type);
 }
 
 bool Tile::isSameFloodFill(Seat* seat, FloodFillType type, Tile* tile) const
 {
-    return getFloodFillValue(seat, type) == tile->getFloodFillValue(seat, type);
-}
-
-void Tile::resetFloodFill()
-{
-    for(std::vector<uint32_t>& values : mFloodFillColor)
-    {
-        for(uint32_t& floodFillValue : values)
-        {
-            floodFillValue = NO_FLOODFILL;
-        }
-    }
+    GameMap* gameMap = getGameMap();
+    return gameMap->isSameFloodFill(seat->getTeamIndex(), type, gameMap->getTileIndex(mX, mY),
+        gameMap->getTileIndex(tile->getX(), tile->getY()));
 }
 
 bool Tile::updateFloodFillFromTile(Seat* seat, FloodFillType type, Tile* tile)
 {
-    if(seat->getTeamIndex() >= mFloodFillColor.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", seatIndex=" + Helper::toString(seat->getTeamIndex()) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(mFloodFillColor.size()))
-                + ", fullness=" + Helper::toString(getFullness()));
-        }
-        return false;
-    }
-
-    std::vector<uint32_t>& values = mFloodFillColor[seat->getTeamIndex()];
-    uint32_t intType = static_cast<uint32_t>(type);
-    if(intType >= values.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", intType=" + Helper::toString(intType) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(values.size())));
-        }
+    GameMap* gameMap = getGameMap();
+    uint32_t tileIndex = gameMap->getTileIndex(mX, mY);
+    if(gameMap->getFloodFillValue(seat->getTeamIndex(), type, tileIndex) != NO_FLOODFILL)
         return false;
-    }
 
-    if((values[intType] != NO_FLOODFILL) ||
-       (tile->getFloodFillValue(seat, type) == NO_FLOODFILL))
-    {
+    uint32_t value = tile->getFloodFillValue(seat, type);
+    if(value == NO_FLOODFILL)
         return false;
-    }
 
-    values[intType] = tile->getFloodFillValue(seat, type);
+    gameMap->setFloodFillValue(seat->getTeamIndex(), type, tileIndex, value);
     return true;
 }
 
 void Tile::replaceFloodFill(Seat* seat, FloodFillType type, uint32_t newValue)
 {
-    if(seat->getTeamIndex() >= mFloodFillColor.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", seatIndex=" + Helper::toString(seat->getTeamIndex()) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(mFloodFillColor.size())));
-        }
-        return;
-    }
-
-    std::vector<uint32_t>& values = mFloodFillColor[seat->getTeamIndex()];
-    uint32_t intType = static_cast<uint32_t>(type);
-    if(intType >= values.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", intType=" + Helper::toString(intType) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(values.size())));
-        }
-        return;
-    }
-
-    values[intType] = newValue;
+    getGameMap()->setFloodFillValue(seat->getTeamIndex(), type, getGameMap()->getTileIndex(mX, mY), newValue);
 }
 
 void Tile::copyFloodFillToOtherSeats(Seat* seatToCopy)
 {
-    if(seatToCopy->getTeamIndex() >= mFloodFillColor.size())
+    GameMap* gameMap = getGameMap();
+    uint32_t tileIndex = gameMap->getTileIndex(mX, mY);
+    uint32_t nbTeams = gameMap->getNbFloodFillTeams();
+    if(seatToCopy->getTeamIndex() >= nbTeams)
     {
         static bool logMsg = false;
         if(!logMsg)
@@ -646,37 +536,40 @@ void Tile::copyFloodFillToOtherSeats(Seat* seatToCopy)
             logMsg = true;
             OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seatToCopy->getId())
                 + ", tile=" + Tile::displayAsString(this)
-                + ", seatIndex=" + Helper::toString(seatToCopy->getTeamIndex()) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(mFloodFillColor.size())));
+                + ", seatIndex=" + Helper::toString(seatToCopy->getTeamIndex()) + ", floodfillsize=" + Helper::toString(nbTeams));
         }
         return;
     }
 
-    std::vector<uint32_t>& valuesToCopy = mFloodFillColor[seatToCopy->getTeamIndex()];
-    for(uint32_t indexFloodFill = 0; indexFloodFill < mFloodFillColor.size(); ++indexFloodFill)
+    // Merged regions are not shared between teams so we copy the resolved values
+    for(uint32_t intType = 0; intType < static_cast<uint32_t>(FloodFillType::nbValues); ++intType)
     {
-        if(seatToCopy->getTeamIndex() == indexFloodFill)
-            continue;
-
-        std::vector<uint32_t>& values = mFloodFillColor[indexFloodFill];
-        for(uint32_t intType = 0; intType < static_cast<uint32_t>(FloodFillType::nbValues); ++intType)
-            values[intType] = valuesToCopy[intType];
+        FloodFillType type = static_cast<FloodFillType>(intType);
+        uint32_t value = gameMap->getFloodFillValue(seatToCopy->getTeamIndex(), type, tileIndex);
+        for(uint32_t teamIndex = 0; teamIndex < nbTeams; ++teamIndex)
+        {
+            if(seatToCopy->getTeamIndex() == teamIndex)
+                continue;
 
+            gameMap->setFloodFillValue(teamIndex, type, tileIndex, value);
+        }
     }
 }
 
 void Tile::logFloodFill() const
 {
+    GameMap* gameMap = getGameMap();
+    uint32_t tileIndex = gameMap->getTileIndex(mX, mY);
     std::string str = "Floodfill : " + Tile::displayAsString(this)
         + " - type=" + Tile::tileVisualToString(getTileVisual())
         + " - fullness=" + Helper::toString(getFullness())
         + " - seatId=" + std::string(getSeat() == nullptr ? "-1" : Helper::toString(getSeat()->getId()));
-    for(const std::vector<uint32_t>& values : mFloodFillColor)
+    for(uint32_t teamIndex = 0; teamIndex < gameMap->getNbFloodFillTeams(); ++teamIndex)
     {
-        int cpt = 0;
-        for(const uint32_t& floodFill : values)
+        for(uint32_t intType = 0; intType < static_cast<uint32_t>(FloodFillType::nbValues); ++intType)
         {
-            str += ", [" + Helper::toString(cpt) + "]=" + Helper::toString(floodFill);
-            ++cpt;
+            uint32_t floodFill = gameMap->getFloodFillValue(teamIndex, static_cast<FloodFillType>(intType), tileIndex);
+            str += ", [" + Helper::toString(intType) + "]=" + Helper::toString(floodFill);
         }
     }
     OD_LOG_INF(str);
@@ -729,7 +622,7 @@ void Tile::notifyVision(Seat* seat)
     if(std::find(mSeatsWithVision.begin(), mSeatsWithVision.end(), seat) != mSeatsWithVision.end())
         return;
 
-    seat->notifyVisionOnTile(this);
+    seat->notifyVisionOnTile(this, true);
     mSeatsWithVision.push_back(seat);
 
     // We also notify vision for allied seats
@@ -737,6 +630,20 @@ void Tile::notifyVision(Seat* seat)
         notifyVision(alliedSeat);
 }
 
+void Tile::setSeatHasVision(Seat* seat, bool hasVision)
+{
+    std::vector<Seat*>::iterator it = std::find(mSeatsWithVision.begin(), mSeatsWithVision.end(), seat);
+    if(hasVision)
+    {
+        if(it == mSeatsWithVision.end())
+            mSeatsWithVision.push_back(seat);
+    }
+    else if(it != mSeatsWithVision.end())
+    {
+        mSeatsWithVision.erase(it);
+    }
+}
+
 void Tile::setSeats(const std::vector<Seat*>& seats)
 {
     mTileChangedForSeats.clear();
@@ -836,47 +743,15 @@ void Tile::computeTileVisual()
         default:
             OD_LOG_ERR("Computing tile visual for unknown tile type tile=" + Tile::displayAsString(this) + ", TileType=" + tileTypeToString(getType()));
             mTileVisual = TileVisual::nullTileVisual;
-            return;
-    }
-}
-
-uint32_t Tile::getFloodFillValue(Seat* seat, FloodFillType type) const
-{
-    if(seat->getTeamIndex() >= mFloodFillColor.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", seatIndex=" + Helper::toString(seat->getTeamIndex()) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(mFloodFillColor.size()))
-                + ", fullness=" + Helper::toString(getFullness()));
-        }
-        return NO_FLOODFILL;
-    }
-
-    const std::vector<uint32_t>& values = mFloodFillColor[seat->getTeamIndex()];
-    uint32_t intType = static_cast<uint32_t>(type);
-    if(intType >= values.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", intType=" + Helper::toString(intType) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(values.size())));
-        }
-        return NO_FLOODFILL;
+            break;
     }
 
-    return values.at(intType);
+    refreshHotState();
 }
 
-void Tile::setTeamsNumber(uint32_t nbTeams)
+uint32_t Tile::getFloodFillValue(Seat* seat, FloodFillType type) const
 {
-    mFloodFillColor = std::vector<std::vector<uint32_t>>(nbTeams, std::vector<uint32_t>(static_cast<uint32_t>(FloodFillType::nbValues), NO_FLOODFILL));
+    return getGameMap()->getFloodFillValue(seat->getTeamIndex(), type, getGameMap()->getTileIndex(mX, mY));
 }
 
 bool Tile::shouldColorTileMesh() const
@@ -902,6 +777,7 @@ void Tile::setFullness(double f)
     double oldFullness = getFullness();
 
     mFullness = f;
+    refreshHotState();
 
     // If the tile was marked for digging and has been dug out, unmark it and set its fullness to 0.
     if (mFullness == 0.0 && isMarkedForDiggingByAnySeat())
@@ -920,6 +796,11 @@ void Tile::setFullness(double f)
                 getGameMap()->refreshFloodFill(seat, this);
         }
     }
+
+    // A wall being dug cannot be walked through until it is empty so only the first and last
+    // fullness changes matter
+    if((oldFullness > 0.0) != (mFullness > 0.0))
+        getGameMap()->notifyTilePassabilityChanged(*this, (mFullness == 0.0) ? TilePassabilityChange::dug : TilePassabilityChange::filled);
 }
 
 void Tile::createMeshLocal()
@@ -969,8 +850,18 @@ void Tile::setCoveringBuilding(Building *building)
                 continue;
 
             seatChanged.second = true;
+            seatChanged.first->notifyTileChanged(this);
         }
     }
+    if((mCoveringBuilding == nullptr) != (building == nullptr))
+    {
+        EntitySpatialIndex& spatialIndex = getGameMap()->getEntitySpatialIndex();
+        uint32_t index = getGameMap()->getTileIndex(mX, mY);
+        if(building != nullptr)
+            spatialIndex.addBuildingTile(index);
+        else
+            spatialIndex.removeBuildingTile(index);
+    }
     mCoveringBuilding = building;
     mIsRoom = false;
     if(getCoveringRoom() != nullptr)
@@ -994,12 +885,17 @@ void Tile::setCoveringBuilding(Building *building)
                 continue;
 
             seatChanged.second = true;
+            seatChanged.first->notifyTileChanged(this);
         }
 
         // Set the tile as claimed and of the team color of the building
         setSeat(mCoveringBuilding->getSeat());
         mClaimedPercentage = 1.0;
     }
+    refreshHotState();
+
+    // Bridges and doors change the tiles creatures can walk on
+    getGameMap()->notifyTilePassabilityChanged(*this, TilePassabilityChange::coveringBuilding);
 }
 
 bool Tile::isGroundClaimable(Seat* seat) const
@@ -1076,6 +972,7 @@ void Tile::updateFromPacket(ODPacket& is)
             setSeat(seat);
 
     }
+    refreshHotState();
 
     // We need to check if the tile is unmarked after reading the needed information.
     if(getMarkedForDigging(getGameMap()->getLocalPlayer()) &&
@@ -1144,6 +1041,7 @@ void Tile::loadFromLine(const std::string& line, Tile *t)
     if(!shouldSetSeat)
     {
         t->setSeat(nullptr);
+        t->refreshHotState();
         return;
     }
 
@@ -1153,6 +1051,7 @@ void Tile::loadFromLine(const std::string& line, Tile *t)
         return;
     t->setSeat(seat);
     t->mClaimedPercentage = 1.0;
+    t->refreshHotState();
 }
 
 void Tile::refreshMesh()
@@ -1195,6 +1094,9 @@ bool Tile::addEntity(GameEntity *entity)
     }
 
     mEntitiesInTile.push_back(entity);
+    if(entity->getObjectType() == GameEntityType::creature)
+        getGameMap()->getEntitySpatialIndex().addCreature(entity, getGameMap()->getTileIndex(mX, mY));
+
     if(!getGameMap()->isServerGameMap())
     {
         // On client side, we cull any movable entity that walks over a
@@ -1217,6 +1119,9 @@ void Tile::removeEntity(GameEntity *entity)
     }
 
     mEntitiesInTile.erase(it);
+    if(entity->getObjectType() == GameEntityType::creature)
+        getGameMap()->getEntitySpatialIndex().removeCreature(entity, getGameMap()->getTileIndex(mX, mY));
+
     fireTileStateChanged();
 }
 
@@ -1228,6 +1133,7 @@ void Tile::claimForSeat(Seat* seat, double nDanceRate)
         (getCoveringBuilding()->isClaimable(seat)))
     {
         getCoveringBuilding()->claimForSeat(seat, this, nDanceRate);
+        refreshHotState();
         return;
     }
 
@@ -1262,6 +1168,9 @@ void Tile::claimForSeat(Seat* seat, double nDanceRate)
     {
         claimTile(seat);
     }
+
+    // An enemy claiming a claimed tile unclaims it without changing its visual
+    refreshHotState();
 }
 
 void Tile::claimTile(Seat* seat)
@@ -1297,6 +1206,11 @@ void Tile::claimTile(Seat* seat)
         }
     }
 
+    refreshHotState();
+    // Claimed and unclaimed ground have the same speed. Only the owner of the building covering
+    // the tile (like a door) can change the creatures going through
+    if(getCoveringBuilding() != nullptr)
+        getGameMap()->notifyTilePassabilityChanged(*this, TilePassabilityChange::coveringBuilding);
     fireTileStateChanged();
 }
 
@@ -1324,6 +1238,11 @@ void Tile::unclaimTile()
         }
     }
 
+    refreshHotState();
+    // Claimed and unclaimed ground have the same speed. Only the owner of the building covering
+    // the tile (like a door) can change the creatures going through
+    if(getCoveringBuilding() != nullptr)
+        getGameMap()->notifyTilePassabilityChanged(*this, TilePassabilityChange::coveringBuilding);
     fireTileStateChanged();
 }
 
@@ -1708,24 +1627,17 @@ bool Tile::checkCoveringTrapType(TrapType type) const
 
 void Tile::computeVisibleTiles()
 {
-    if(!getGameMap()->getIsFOWActivated())
+    VisionMap& visionMap = getGameMap()->getVisionMap();
+    if(!isClaimed())
     {
-        // If the FOW is deactivated, we allow vision for every seat
-        for(Seat* seat : getGameMap()->getSeats())
-            notifyVision(seat);
-
+        visionMap.removeSource(*this);
         return;
     }
 
-    if(!isClaimed())
-        return;
-
     // A claimed tile can see it self and its neighboors
-    notifyVision(getSeat());
-    for(Tile* tile : mNeighbors)
-    {
-        tile->notifyVision(getSeat());
-    }
+    std::vector<Tile*> tiles = mNeighbors;
+    tiles.push_back(this);
+    visionMap.setSource(*this, getSeat(), this, 1, tiles, false);
 }
 
 void Tile::setDirtyForAllSeats()
@@ -1734,7 +1646,10 @@ void Tile::setDirtyForAllSeats()
         return;
 
     for(std::pair<Seat*, bool>& seatChanged : mTileChangedForSeats)
+    {
         seatChanged.second = true;
+        seatChanged.first->notifyTileChanged(this);
+    }
 }
 
 void Tile::notifyEntitiesSeatsWithVision()
@@ -1817,20 +1732,8 @@ double Tile::getCreatureSpeedDefault(const Creature* creature) const
     if(!getIsOnServerMap() && isFullTile())
         return creature->getMoveSpeedGround();
 
-    switch(getTileVisual())
-    {
-        case TileVisual::dirtGround:
-        case TileVisual::goldGround:
-        case TileVisual::rockGround:
-        case TileVisual::claimedGround:
-            return creature->getMoveSpeedGround();
-        case TileVisual::waterGround:
-            return creature->getMoveSpeedWater();
-        case TileVisual::lavaGround:
-            return creature->getMoveSpeedLava();
-        default:
-            return 0.0;
-    }
+    return TileHotState::getCreatureSpeed(getTileVisual(), creature->getMoveSpeedGround(),
+        creature->getMoveSpeedWater(), creature->getMoveSpeedLava());
 }
 
 bool Tile::canWorkerClaim(const Creature& worker)
@@ -1995,6 +1898,31 @@ bool Tile::removeTileStateListener(TileStateListener& listener)
     return true;
 }
 
+void Tile::refreshHotState()
+{
+    if(getGameMap() == nullptr)
+        return;
+
+    uint32_t index = getGameMap()->getTileIndex(mX, mY);
+    TileHotState& hotState = getGameMap()->getTileHotState();
+    Seat* oldClaimingSeat = hotState.isClaimed(index) ? hotState.getSeat(index) : nullptr;
+    if(!hotState.update(index, *this))
+        return;
+
+    getGameMap()->getVisionMap().notifyTileClaimChanged(index);
+
+    // Every claim change goes through here (claimTile, unclaimTile, loading, ...) so the count
+    // of claimed tiles of each seat is kept up to date on server side
+    if(!getGameMap()->isServerGameMap())
+        return;
+
+    Seat* claimingSeat = hotState.isClaimed(index) ? hotState.getSeat(index) : nullptr;
+    if(oldClaimingSeat != nullptr)
+        oldClaimingSeat->decrementNumClaimedTiles();
+    if(claimingSeat != nullptr)
+        claimingSeat->incrementNumClaimedTiles();
+}
+
 void Tile::fireTileStateChanged()
 {
     for(TileStateListener* stateListener : mStateListeners)
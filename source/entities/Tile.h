@@ -173,7 +173,7 @@ public:
      * for the tile.
      */
     inline void setType(TileType t)
-    { mType = t; }
+    { mType = t; refreshHotState(); }
 
     //! \brief Returns the tile type (rock, claimed, etc.).
     inline TileType getType() const
@@ -185,7 +185,7 @@ public:
 
     //! \brief Sets the tile type (rock, claimed, etc.).
     inline void setTileVisual(TileVisual tileVisual)
-    { mTileVisual = tileVisual; }
+    { mTileVisual = tileVisual; refreshHotState(); }
 
     //! \brief A mutator to change how "filled in" the tile is.
     //! Additionally this function refreshes floodfill if needed (if a tile becomes walkable)
@@ -366,10 +366,14 @@ public:
     //! Fills the given vector with corresponding entities on this tile.
     void fillWithEntities(std::vector<GameEntity*>& entities, SelectionEntityWanted entityWanted, Player* player);
 
-    //! \brief Computes the visible tiles and tags them to know which are visible
+    //! \brief Registers the tiles seen by this tile (if claimed) in the GameMap VisionMap. Called
+    //! when the tile is claimed or changes owner
     void computeVisibleTiles();
     void clearVision();
+    //! \brief Gives vision on this tile to the given seat and its allies
     void notifyVision(Seat* seat);
+    //! \brief Sets whether the given seat has vision on this tile (allies are not changed)
+    void setSeatHasVision(Seat* seat, bool hasVision);
 
     void setSeats(const std::vector<Seat*>& seats);
     bool hasChangedForSeat(Seat* seat) const;
@@ -380,8 +384,6 @@ public:
     const std::vector<Seat*>& getSeatsWithVision()
     { return mSeatsWithVision; }
 
-    void resetFloodFill();
-
     static std::string toString(FloodFillType type);
 
     bool isSameFloodFill(Seat* seat, FloodFillType type, Tile* tile) const;
@@ -413,9 +415,6 @@ public:
     //! server and client
     bool isFullTile() const;
 
-    //! Sets the number of teams in this gamemap (after seat configuration). This number includes the rogue team.
-    void setTeamsNumber(uint32_t nbTeams);
-
     //! \brief returns true if the mesh from the tileset should be displayed and false otherwise
     inline bool shouldDisplayTileMesh() const
     { return mDisplayTileMesh; }
@@ -462,6 +461,10 @@ public:
     virtual void updateFromPacket(ODPacket& is) override;
     void exportToPacketForUpdate(ODPacket& os, const Seat* seat, bool hideSeatId) const;
 
+    //! \brief Copies the fields read by the simulation loops to the GameMap TileHotState. Called
+    //! by the tile mutators. Should also be called when the seat of the tile is changed from outside
+    void refreshHotState();
+
     bool addTileStateListener(TileStateListener& listener);
     bool removeTileStateListener(TileStateListener& listener);
 
@@ -514,8 +517,6 @@ private:
     std::vector<GameEntity*> mEntitiesInTile;
 
     Building* mCoveringBuilding;
-    //! Floodfill values per seat and per floodfill type
-    std::vector<std::vector<uint32_t>> mFloodFillColor;
 
     //! \brief The tile claiming. Used on server side only
     double mClaimedPercentage;
@@ -541,7 +542,7 @@ private:
      *  before a map object has been set. setFullness is called once a map is assigned.
      */
     inline void setFullnessValue(double f)
-    { mFullness = f; }
+    { mFullness = f; refreshHotState(); }
 
     void setDirtyForAllSeats();
 
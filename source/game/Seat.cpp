@@ -38,6 +38,7 @@
 #include "spawnconditions/SpawnCondition.h"
 #include "traps/Trap.h"
 #include "traps/TrapManager.h"
+#include "traps/TrapType.h"
 #include "utils/ConfigManager.h"
 #include "utils/Helper.h"
 #include "utils/LogManager.h"
@@ -60,8 +61,6 @@ TileStateNotified::TileStateNotified():
     mTileVisual(TileVisual::nullTileVisual),
     mSeatIdOwner(-1),
     mMarkedForDigging(false),
-    mVisionTurnLast(false),
-    mVisionTurnCurrent(false),
     mBuilding(nullptr)
 {
 }
@@ -75,6 +74,10 @@ Seat::Seat(GameMap* gameMap) :
     mTeamIndex(0),
     mIsDebuggingVision(false),
     mSkillPoints(0),
+    mRoomsByType(static_cast<uint32_t>(RoomType::nbRooms)),
+    mTrapsByType(static_cast<uint32_t>(TrapType::nbTraps)),
+    mGoldStored(0),
+    mGoldStorage(0),
     mCurrentSkill(nullptr),
     mGuiSkillNeedsRefresh(false),
     mConfigPlayerId(-1),
@@ -232,17 +235,11 @@ void Seat::clearTilesWithVision()
     if(!mPlayer->getIsHuman())
         return;
 
-    for(std::vector<TileStateNotified>& vec : mTilesStates)
-    {
-        for(TileStateNotified& p : vec)
-        {
-            p.mVisionTurnLast = p.mVisionTurnCurrent;
-            p.mVisionTurnCurrent = false;
-        }
-    }
+    // The tiles that were visible will be sent as lost by sendVisibleTiles
+    mVisionCurrent.reset();
 }
 
-void Seat::notifyVisionOnTile(Tile* tile)
+void Seat::notifyVisionOnTile(Tile* tile, bool hasVision)
 {
     if(mPlayer == nullptr)
         return;
@@ -260,8 +257,35 @@ void Seat::notifyVisionOnTile(Tile* tile)
         return;
     }
 
-    TileStateNotified& tileState = mTilesStates[tile->getX()][tile->getY()];
-    tileState.mVisionTurnCurrent = true;
+    uint32_t tileIndex = mGameMap->getTileIndex(tile->getX(), tile->getY());
+    bool hadVision = mVisionCurrent.test(tileIndex);
+    mVisionCurrent.set(tileIndex, hasVision);
+
+    // If the tile changed while not visible, it has to be sent now
+    if(hasVision && !hadVision && tile->hasChangedForSeat(this))
+        notifyTileChanged(tile);
+}
+
+void Seat::notifyTileChanged(Tile* tile)
+{
+    if(mPlayer == nullptr)
+        return;
+    if(!mPlayer->getIsHuman())
+        return;
+
+    uint32_t tileIndex = mGameMap->getTileIndex(tile->getX(), tile->getY());
+    if(tileIndex >= mIsTileInChangedList.size())
+        return;
+
+    // Tiles not visible will be added when vision is gained
+    if(!mVisionCurrent.test(tileIndex))
+        return;
+
+    if(mIsTileInChangedList.test(tileIndex))
+        return;
+
+    mIsTileInChangedList.set(tileIndex, true);
+    mTilesChanged.push_back(tile);
 }
 
 void Seat::notifyTileClaimedByEnemy(Tile* tile)
@@ -287,7 +311,8 @@ void Seat::notifyTileClaimedByEnemy(Tile* tile)
     // By default, we set the tile like if it was not claimed anymore
     tileState.mSeatIdOwner = -1;
     tileState.mTileVisual = TileVisual::dirtGround;
-    tileState.mVisionTurnCurrent = true;
+    notifyVisionOnTile(tile, true);
+    mTilesVisionForced.push_back(tile);
 }
 
 const std::string Seat::getFactionFromLine(const std::string& line)
@@ -355,9 +380,7 @@ bool Seat::hasVisionOnTile(Tile* tile)
         return false;
     }
 
-    TileStateNotified& stateTile = mTilesStates[tile->getX()][tile->getY()];
-
-    return stateTile.mVisionTurnCurrent;
+    return mVisionCurrent.test(mGameMap->getTileIndex(tile->getX(), tile->getY()));
 }
 
 void Seat::initSeat()
@@ -481,6 +504,11 @@ void Seat::setMapSize(int x, int y)
         return;
 
     mTilesStates = std::vector<std::vector<TileStateNotified>>(x, std::vector<TileStateNotified>(y));
+    mVisionCurrent.resize(static_cast<uint32_t>(x * y));
+    mVisionLast.resize(static_cast<uint32_t>(x * y));
+    mIsTileInChangedList.resize(static_cast<uint32_t>(x * y));
+    mTilesChanged.clear();
+    mTilesVisionForced.clear();
     // By default, we know that rock (ground & full) will be set as rock full tiles,
     // gold (ground & full) will be set as gold full tiles,
     // other tiles will be set as dirt full tiles
@@ -602,24 +630,22 @@ void Seat::notifyChangedVisibleTiles()
     if(!mPlayer->getIsHuman())
         return;
 
+    // We only check the tiles that changed while visible or that got visible since the last call
     std::vector<Tile*> tilesToNotify;
-    int xMax = static_cast<int>(mTilesStates.size());
-    for(int xxx = 0; xxx < xMax; ++xxx)
+    for(Tile* tile : mTilesChanged)
     {
-        int yMax = static_cast<int>(mTilesStates[xxx].size());
-        for(int yyy = 0; yyy < yMax; ++yyy)
-        {
-            if(!mTilesStates[xxx][yyy].mVisionTurnCurrent)
-                continue;
+        uint32_t tileIndex = mGameMap->getTileIndex(tile->getX(), tile->getY());
+        mIsTileInChangedList.set(tileIndex, false);
+        if(!mVisionCurrent.test(tileIndex))
+            continue;
 
-            Tile* tile = mGameMap->getTile(xxx, yyy);
-            if(!tile->hasChangedForSeat(this))
-                continue;
+        if(!tile->hasChangedForSeat(this))
+            continue;
 
-            tilesToNotify.push_back(tile);
-            tile->changeNotifiedForSeat(this);
-        }
+        tilesToNotify.push_back(tile);
+        tile->changeNotifiedForSeat(this);
     }
+    mTilesChanged.clear();
 
     if(tilesToNotify.empty())
         return;
@@ -709,19 +735,10 @@ void Seat::refreshSeatVisualDebug()
     if(mIsDebuggingVision)
     {
         std::vector<Tile*> tiles;
-        int xMax = static_cast<int>(mTilesStates.size());
-        for(int xxx = 0; xxx < xMax; ++xxx)
+        mVisionCurrent.forEachSetBit([&](uint32_t tileIndex)
         {
-            int yMax = static_cast<int>(mTilesStates[xxx].size());
-            for(int yyy = 0; yyy < yMax; ++yyy)
-            {
-                if(!mTilesStates[xxx][yyy].mVisionTurnCurrent)
-                    continue;
-
-                Tile* tile = mGameMap->getTile(xxx, yyy);
-                tiles.push_back(tile);
-            }
-        }
+            tiles.push_back(mGameMap->getTileByIndex(tileIndex));
+        });
         uint32_t nbTiles = tiles.size();
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::refreshSeatVisDebug, nullptr);
@@ -755,75 +772,173 @@ void Seat::sendVisibleTiles()
     if(!getPlayer()->getIsHuman())
         return;
 
-    uint32_t nbTiles;
     ServerNotification *serverNotification = new ServerNotification(
         ServerNotificationType::refreshVisibleTiles, getPlayer());
     std::vector<Tile*> tilesVisionGained;
     std::vector<Tile*> tilesVisionLost;
-    // Tiles we gained vision
-    int xMax = static_cast<int>(mTilesStates.size());
-    for(int xxx = 0; xxx < xMax; ++xxx)
+
+    // The tiles claimed by an enemy were seen until now. They get back their real vision
+    for(Tile* tile : mTilesVisionForced)
     {
-        int yMax = static_cast<int>(mTilesStates[xxx].size());
-        for(int yyy = 0; yyy < yMax; ++yyy)
+        uint32_t tileIndex = mGameMap->getTileIndex(tile->getX(), tile->getY());
+        mVisionLast.set(tileIndex, true);
+        mVisionCurrent.set(tileIndex, mGameMap->getVisionMap().hasVision(this, tileIndex));
+    }
+    mTilesVisionForced.clear();
+
+    // The tiles that changed are the bits that differ from the last call
+    BitVector::forEachDifference(mVisionCurrent, mVisionLast, [&](uint32_t tileIndex, bool hasVision)
+    {
+        Tile* tile = mGameMap->getTileByIndex(tileIndex);
+        if(hasVision)
         {
-            if(mTilesStates[xxx][yyy].mVisionTurnCurrent == mTilesStates[xxx][yyy].mVisionTurnLast)
-                continue;
+            // Vision gained
+            tilesVisionGained.push_back(tile);
+        }
+        else
+        {
+            // Vision lost
+            tilesVisionLost.push_back(tile);
+        }
+    });
+    mVisionLast = mVisionCurrent;
 
-            Tile* tile = mGameMap->getTile(xxx, yyy);
-            if(mTilesStates[xxx][yyy].mVisionTurnCurrent)
+    // Notify tiles we gained vision then tiles we lost vision
+    mGameMap->tilesToPacket(serverNotification->mPacket, tilesVisionGained);
+    mGameMap->tilesToPacket(serverNotification->mPacket, tilesVisionLost);
+    ODServer::getSingleton().queueServerNotification(serverNotification);
+}
+
+void Seat::computeSeatBeginTurn()
+{
+    if(mPlayer != nullptr)
+    {
+        std::fill(mNbRooms.begin(), mNbRooms.end(), 0);
+        for(uint32_t index = 0; index < mRoomsByType.size(); ++index)
+        {
+            if(index >= mNbRooms.size())
             {
-                // Vision gained
-                tilesVisionGained.push_back(tile);
+                OD_LOG_ERR("wrong index=" + Helper::toString(index) + ", size=" + Helper::toString(mNbRooms.size()));
+                return;
             }
-            else
+
+            for(Room* room : mRoomsByType[index])
             {
-                // Vision lost
-                tilesVisionLost.push_back(tile);
+                if(room->getHP(nullptr) <= 0.0)
+                    continue;
+
+                ++mNbRooms[index];
             }
         }
     }
+}
 
-    // Notify tiles we gained vision
-    nbTiles = tilesVisionGained.size();
-    serverNotification->mPacket << nbTiles;
-    for(Tile* tile : tilesVisionGained)
+void Seat::addRoom(Room* room)
+{
+    uint32_t index = static_cast<uint32_t>(room->getType());
+    if(index >= mRoomsByType.size())
     {
-        mGameMap->tileToPacket(serverNotification->mPacket, tile);
+        OD_LOG_ERR("room=" + room->getName() + ", wrong index=" + Helper::toString(index));
+        return;
     }
 
-    // Notify tiles we lost vision
-    nbTiles = tilesVisionLost.size();
-    serverNotification->mPacket << nbTiles;
-    for(Tile* tile : tilesVisionLost)
+    mRoomsByType[index].push_back(room);
+    notifyGoldStorageChanged(room->getTotalGoldStored(), room->getTotalGoldStorage());
+}
+
+void Seat::removeRoom(Room* room)
+{
+    uint32_t index = static_cast<uint32_t>(room->getType());
+    if(index >= mRoomsByType.size())
     {
-        mGameMap->tileToPacket(serverNotification->mPacket, tile);
+        OD_LOG_ERR("room=" + room->getName() + ", wrong index=" + Helper::toString(index));
+        return;
     }
-    ODServer::getSingleton().queueServerNotification(serverNotification);
+
+    std::vector<Room*>& rooms = mRoomsByType[index];
+    auto it = std::find(rooms.begin(), rooms.end(), room);
+    if(it == rooms.end())
+    {
+        OD_LOG_ERR("room=" + room->getName() + ", seatId=" + Helper::toString(getId()));
+        return;
+    }
+
+    // We keep the order so that the rooms are iterated like in the gamemap
+    rooms.erase(it);
+    notifyGoldStorageChanged(-room->getTotalGoldStored(), -room->getTotalGoldStorage());
 }
 
-void Seat::computeSeatBeginTurn()
+const std::vector<Room*>& Seat::getRooms(RoomType type) const
 {
-    if(mPlayer != nullptr)
+    static const std::vector<Room*> EMPTY_ROOMS;
+    uint32_t index = static_cast<uint32_t>(type);
+    if(index >= mRoomsByType.size())
     {
-        std::fill(mNbRooms.begin(), mNbRooms.end(), 0);
-        for(Room* room : mGameMap->getRooms())
-        {
-            if(room->getSeat() != this)
-                continue;
+        OD_LOG_ERR("wrong index=" + Helper::toString(index));
+        return EMPTY_ROOMS;
+    }
 
-            if(room->getHP(nullptr) <= 0.0)
-                continue;
+    return mRoomsByType[index];
+}
 
-            uint32_t index = static_cast<uint32_t>(room->getType());
-            if(index >= mNbRooms.size())
-            {
-                OD_LOG_ERR("wrong index=" + Helper::toString(index) + ", size=" + Helper::toString(mNbRooms.size()));
-                return;
-            }
-            ++mNbRooms[index];
-        }
+void Seat::addTrap(Trap* trap)
+{
+    uint32_t index = static_cast<uint32_t>(trap->getType());
+    if(index >= mTrapsByType.size())
+    {
+        OD_LOG_ERR("trap=" + trap->getName() + ", wrong index=" + Helper::toString(index));
+        return;
+    }
+
+    mTrapsByType[index].push_back(trap);
+}
+
+void Seat::removeTrap(Trap* trap)
+{
+    uint32_t index = static_cast<uint32_t>(trap->getType());
+    if(index >= mTrapsByType.size())
+    {
+        OD_LOG_ERR("trap=" + trap->getName() + ", wrong index=" + Helper::toString(index));
+        return;
+    }
+
+    std::vector<Trap*>& traps = mTrapsByType[index];
+    auto it = std::find(traps.begin(), traps.end(), trap);
+    if(it == traps.end())
+    {
+        OD_LOG_ERR("trap=" + trap->getName() + ", seatId=" + Helper::toString(getId()));
+        return;
     }
+
+    traps.erase(it);
+}
+
+const std::vector<Trap*>& Seat::getTraps(TrapType type) const
+{
+    static const std::vector<Trap*> EMPTY_TRAPS;
+    uint32_t index = static_cast<uint32_t>(type);
+    if(index >= mTrapsByType.size())
+    {
+        OD_LOG_ERR("wrong index=" + Helper::toString(index));
+        return EMPTY_TRAPS;
+    }
+
+    return mTrapsByType[index];
+}
+
+void Seat::notifyGoldStorageChanged(int goldStoredDelta, int goldStorageDelta)
+{
+    mGoldStored += goldStoredDelta;
+    mGoldStorage += goldStorageDelta;
+}
+
+void Seat::notifyCreatureCounted(bool isWorker, bool isCounted)
+{
+    int delta = isCounted ? 1 : -1;
+    if(isWorker)
+        mNumCreaturesWorkers += delta;
+    else
+        mNumCreaturesFighters += delta;
 }
 
 
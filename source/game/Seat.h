@@ -19,6 +19,7 @@
 #define SEAT_H
 
 #include "game/SeatData.h"
+#include "utils/BitVector.h"
 
 #include <OgreVector3.h>
 #include <OgreColourValue.h>
@@ -34,9 +35,11 @@ class ODPacket;
 class GameMap;
 class CreatureDefinition;
 class Player;
+class Room;
 class Skill;
 class Seat;
 class Tile;
+class Trap;
 
 enum class KeeperAIType;
 enum class RoomType;
@@ -54,8 +57,6 @@ public:
     TileVisual mTileVisual;
     int mSeatIdOwner;
     bool mMarkedForDigging;
-    bool mVisionTurnLast;
-    bool mVisionTurnCurrent;
     Building* mBuilding;
 };
 
@@ -200,10 +201,17 @@ public:
     bool canOwnedCreatureUseRoomFrom(const Seat* seat) const;
     bool canBuildingBeDestroyedBy(const Seat* seat) const;
 
+    //! \brief Sets every tile as not visible. The tiles that were visible will be notified as lost
     void clearTilesWithVision();
-    void notifyVisionOnTile(Tile* tile);
+    //! \brief Called when this seat gains or loses vision on the given tile. The change is sent to the
+    //! player with sendVisibleTiles
+    void notifyVisionOnTile(Tile* tile, bool hasVision);
     void notifyTileClaimedByEnemy(Tile* tile);
 
+    //! \brief Called when the given tile is set as changed for this seat (see Tile::hasChangedForSeat). If this
+    //! seat has vision on it, it will be sent to the player by the next notifyChangedVisibleTiles
+    void notifyTileChanged(Tile* tile);
+
     //! \brief Returns true if this seat can see the given tile and false otherwise
     bool hasVisionOnTile(Tile* tile);
 
@@ -227,6 +235,29 @@ public:
 
     void computeSeatBeginTurn();
 
+    //! \brief Rooms and traps owned by this seat by type, in the order they were added to the gamemap.
+    //! They are kept up to date by the GameMap when a room/trap is added, removed or changes seat
+    void addRoom(Room* room);
+    void removeRoom(Room* room);
+    const std::vector<Room*>& getRooms(RoomType type) const;
+    void addTrap(Trap* trap);
+    void removeTrap(Trap* trap);
+    const std::vector<Trap*>& getTraps(TrapType type) const;
+
+    //! \brief Gold stored in the rooms of this seat and their capacity. The rooms notify the changes when
+    //! gold is deposited/withdrawn or when their tiles change (see RoomTreasury)
+    inline int getGoldStored() const
+    { return mGoldStored; }
+
+    inline int getGoldStorage() const
+    { return mGoldStorage; }
+
+    void notifyGoldStorageChanged(int goldStoredDelta, int goldStorageDelta);
+
+    //! \brief Called when a creature owned by this seat starts or stops being counted in the
+    //! workers/fighters (see Creature::updateSeatCounters)
+    void notifyCreatureCounted(bool isWorker, bool isCounted);
+
     //! \brief Gets whether a skill is being done
     bool isSkilling() const
     { return mCurrentSkill != nullptr; }
@@ -358,11 +389,26 @@ private:
 
     //! \brief List of all the tiles in the gamemap (used for human players seats only). The first vector stores the X position.
     //! The second vector stores the Y position. TileStateNotified contains information about the tile
-    //! state (last tile state notified, vision last turn for this seat, vision for current turn, ...
+    //! state (last tile state notified, owner, building, ...
     std::vector<std::vector<TileStateNotified>> mTilesStates;
 
     std::map<std::pair<int, int>, TileStateNotified> mTilesStateLoaded;
 
+    //! \brief Tiles this seat has vision on (current turn and at the last sendVisibleTiles). Bits are
+    //! indexed like the tiles in the gamemap (x + y * mapSizeX)
+    BitVector mVisionCurrent;
+    BitVector mVisionLast;
+
+    //! \brief Visible tiles that may have changed since the last notifyChangedVisibleTiles. A tile is added when it
+    //! changes while visible or when vision is gained on a tile that changed. mIsTileInChangedList tells if a tile
+    //! is already in the list
+    std::vector<Tile*> mTilesChanged;
+    BitVector mIsTileInChangedList;
+
+    //! \brief Tiles claimed by an enemy during this turn. They are set visible until the next sendVisibleTiles
+    //! so that the player is notified about the loss
+    std::vector<Tile*> mTilesVisionForced;
+
     std::vector<Tile*> mVisualDebugEntityTiles;
 
     //! \brief Index of the team in the gamemap (from 0 to N). Must be set when the seat is added to the gamemap
@@ -374,6 +420,14 @@ private:
     //! \brief Counter for skill points
     int32_t mSkillPoints;
 
+    //! \brief Rooms and traps owned by this seat indexed by type (see addRoom/addTrap)
+    std::vector<std::vector<Room*>> mRoomsByType;
+    std::vector<std::vector<Trap*>> mTrapsByType;
+
+    //! \brief Sums of getTotalGoldStored/getTotalGoldStorage of the rooms in mRoomsByType
+    int mGoldStored;
+    int mGoldStorage;
+
     //! \brief Currently researched Skill. This pointer is external and should not be deleted
     const Skill* mCurrentSkill;
 
@@ -56,6 +56,9 @@ public:
     inline void incrementNumClaimedTiles()
     { ++mNumClaimedTiles; }
 
+    inline void decrementNumClaimedTiles()
+    { --mNumClaimedTiles; }
+
     void setTeamId(int teamId);
 
     inline const std::vector<int>& getAvailableTeamIds() const
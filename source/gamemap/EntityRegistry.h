@@ -0,0 +1,72 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENTITYREGISTRY_H
+#define ENTITYREGISTRY_H
+
+#include <string>
+#include <unordered_map>
+
+/*! \brief Index by name of the registered entities. Getting an entity by name does not depend
+ * on the number of entities.
+ * T should provide getName(). The entity is not owned by the registry.
+ * Note that the names are supposed to be unique. If an entity is added with the name of an
+ * already registered entity, getByName will still return the first one.
+ */
+template<typename T>
+class EntityRegistry
+{
+public:
+    EntityRegistry()
+    {}
+
+    //! \brief Indexes the entity by its name. Returns false if another entity has the same name
+    bool add(T* entity)
+    {
+        return mEntitiesByName.emplace(entity->getName(), entity).second;
+    }
+
+    //! \brief Returns false if the entity was not registered
+    bool remove(T* entity)
+    {
+        auto it = mEntitiesByName.find(entity->getName());
+        if((it == mEntitiesByName.end()) || (it->second != entity))
+            return false;
+
+        mEntitiesByName.erase(it);
+        return true;
+    }
+
+    T* getByName(const std::string& name) const
+    {
+        auto it = mEntitiesByName.find(name);
+        if(it == mEntitiesByName.end())
+            return nullptr;
+
+        return it->second;
+    }
+
+    void clear()
+    {
+        mEntitiesByName.clear();
+    }
+
+private:
+    std::unordered_map<std::string, T*> mEntitiesByName;
+};
+
+#endif // ENTITYREGISTRY_H
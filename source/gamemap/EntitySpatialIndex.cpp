@@ -0,0 +1,199 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/EntitySpatialIndex.h"
+
+#include "entities/Building.h"
+#include "entities/GameEntity.h"
+#include "game/Seat.h"
+#include "gamemap/TileHotState.h"
+#include "utils/Helper.h"
+#include "utils/LogManager.h"
+
+#include <algorithm>
+
+EntitySpatialIndex::EntitySpatialIndex() :
+    mMapSizeX(0),
+    mMapSizeY(0),
+    mNbCellsX(0),
+    mNbCellsY(0)
+{
+}
+
+void EntitySpatialIndex::resize(int mapSizeX, int mapSizeY)
+{
+    clear();
+    mMapSizeX = mapSizeX;
+    mMapSizeY = mapSizeY;
+    mNbCellsX = (mapSizeX + CELL_SIZE - 1) / CELL_SIZE;
+    mNbCellsY = (mapSizeY + CELL_SIZE - 1) / CELL_SIZE;
+    mCells.resize(mNbCellsX * mNbCellsY);
+}
+
+void EntitySpatialIndex::clear()
+{
+    mMapSizeX = 0;
+    mMapSizeY = 0;
+    mNbCellsX = 0;
+    mNbCellsY = 0;
+    mCells.clear();
+}
+
+EntitySpatialIndex::Cell& EntitySpatialIndex::getCell(uint32_t tileIndex)
+{
+    int xx = static_cast<int>(tileIndex) % mMapSizeX;
+    int yy = static_cast<int>(tileIndex) / mMapSizeX;
+    return mCells[(xx / CELL_SIZE) + (yy / CELL_SIZE) * mNbCellsX];
+}
+
+void EntitySpatialIndex::addCreature(GameEntity* creature, uint32_t tileIndex)
+{
+    if(tileIndex >= static_cast<uint32_t>(mMapSizeX * mMapSizeY))
+    {
+        OD_LOG_ERR("creature=" + creature->getName() + ", tileIndex=" + Helper::toString(tileIndex));
+        return;
+    }
+
+    getCell(tileIndex).mCreatures.push_back(std::make_pair(creature, tileIndex));
+}
+
+void EntitySpatialIndex::removeCreature(GameEntity* creature, uint32_t tileIndex)
+{
+    if(tileIndex >= static_cast<uint32_t>(mMapSizeX * mMapSizeY))
+    {
+        OD_LOG_ERR("creature=" + creature->getName() + ", tileIndex=" + Helper::toString(tileIndex));
+        return;
+    }
+
+    // The order of the creatures in the cell does not matter
+    std::vector<std::pair<GameEntity*, uint32_t>>& creatures = getCell(tileIndex).mCreatures;
+    auto it = std::find(creatures.begin(), creatures.end(), std::make_pair(creature, tileIndex));
+    if(it == creatures.end())
+    {
+        OD_LOG_ERR("creature=" + creature->getName() + ", tileIndex=" + Helper::toString(tileIndex));
+        return;
+    }
+
+    *it = creatures.back();
+    creatures.pop_back();
+}
+
+void EntitySpatialIndex::addBuildingTile(uint32_t tileIndex)
+{
+    if(tileIndex >= static_cast<uint32_t>(mMapSizeX * mMapSizeY))
+    {
+        OD_LOG_ERR("tileIndex=" + Helper::toString(tileIndex));
+        return;
+    }
+
+    getCell(tileIndex).mBuildingTiles.push_back(tileIndex);
+}
+
+void EntitySpatialIndex::removeBuildingTile(uint32_t tileIndex)
+{
+    if(tileIndex >= static_cast<uint32_t>(mMapSizeX * mMapSizeY))
+    {
+        OD_LOG_ERR("tileIndex=" + Helper::toString(tileIndex));
+        return;
+    }
+
+    std::vector<uint32_t>& buildingTiles = getCell(tileIndex).mBuildingTiles;
+    auto it = std::find(buildingTiles.begin(), buildingTiles.end(), tileIndex);
+    if(it == buildingTiles.end())
+    {
+        OD_LOG_ERR("tileIndex=" + Helper::toString(tileIndex));
+        return;
+    }
+
+    *it = buildingTiles.back();
+    buildingTiles.pop_back();
+}
+
+bool EntitySpatialIndex::isSeatWanted(const Seat* entitySeat, const Seat* seat, bool enemy)
+{
+    if(entitySeat == nullptr)
+        return false;
+
+    return entitySeat->isAlliedSeat(seat) != enemy;
+}
+
+uint32_t EntitySpatialIndex::markTiles(int xMin, int yMin, int xMax, int yMax, const Seat* seat, bool enemy,
+    bool withBuildings, const TileHotState& tileHotState, TileMarks& tileMarks) const
+{
+    std::vector<uint32_t>& marks = tileMarks.mMarks;
+    uint32_t& currentMark = tileMarks.mCurrentMark;
+    if(marks.size() != static_cast<uint32_t>(mMapSizeX * mMapSizeY))
+    {
+        // First use of these marks or the map has been resized
+        marks.assign(mMapSizeX * mMapSizeY, 0);
+        tileMarks.mEntityMarks.assign(mMapSizeX * mMapSizeY, 0);
+        currentMark = 0;
+    }
+
+    ++currentMark;
+    if(currentMark == 0)
+    {
+        // After a wrap around, old marks could be taken for the new ones
+        std::fill(marks.begin(), marks.end(), 0);
+        std::fill(tileMarks.mEntityMarks.begin(), tileMarks.mEntityMarks.end(), 0);
+        currentMark = 1;
+    }
+
+    xMin = std::max(xMin, 0);
+    yMin = std::max(yMin, 0);
+    xMax = std::min(xMax, mMapSizeX - 1);
+    yMax = std::min(yMax, mMapSizeY - 1);
+    uint32_t nbMarked = 0;
+    for(int cellY = yMin / CELL_SIZE; cellY <= yMax / CELL_SIZE; ++cellY)
+    {
+        for(int cellX = xMin / CELL_SIZE; cellX <= xMax / CELL_SIZE; ++cellX)
+        {
+            const Cell& cell = mCells[cellX + cellY * mNbCellsX];
+            for(const std::pair<GameEntity*, uint32_t>& creature : cell.mCreatures)
+            {
+                if(!isSeatWanted(creature.first->getSeat(), seat, enemy))
+                    continue;
+
+                if(marks[creature.second] == currentMark)
+                    continue;
+
+                marks[creature.second] = currentMark;
+                ++nbMarked;
+            }
+
+            if(!withBuildings)
+                continue;
+
+            for(uint32_t tileIndex : cell.mBuildingTiles)
+            {
+                Building* building = tileHotState.getCoveringBuilding(tileIndex);
+                if(building == nullptr)
+                    continue;
+
+                if(!isSeatWanted(building->getSeat(), seat, enemy))
+                    continue;
+
+                if(marks[tileIndex] == currentMark)
+                    continue;
+
+                marks[tileIndex] = currentMark;
+                ++nbMarked;
+            }
+        }
+    }
+    return nbMarked;
+}
@@ -0,0 +1,120 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENTITYSPATIALINDEX_H
+#define ENTITYSPATIALINDEX_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class GameEntity;
+class Seat;
+class TileHotState;
+
+/*! \brief Uniform grid of cells of CELL_SIZE x CELL_SIZE tiles. Each cell knows the creatures standing
+ * on its tiles (kept up to date by Tile::addEntity/removeEntity) and its tiles covered by a building
+ * (kept up to date by Tile::setCoveringBuilding).
+ * It is used to find quickly the tiles of an area that may hold an allied or enemy creature or building
+ * without looking at every tile of the area. The seats are checked when the tiles are marked because
+ * creatures and buildings can change seat while on a tile.
+ * The marks are kept in a TileMarks given by the caller so that several threads can mark tiles at the same
+ * time (each with its own TileMarks) as long as the index is not changed meanwhile.
+ */
+class EntitySpatialIndex
+{
+public:
+    //! \brief Size in tiles of the side of a cell
+    static const int CELL_SIZE = 8;
+
+    //! \brief Tiles marked by markTiles. A tile is marked if its value is mCurrentMark. mCurrentMark
+    //! is incremented at each call to markTiles so that the marks do not have to be cleared
+    class TileMarks
+    {
+    public:
+        TileMarks() :
+            mCurrentMark(0)
+        {}
+
+        inline bool isMarked(uint32_t tileIndex) const
+        { return mMarks[tileIndex] == mCurrentMark; }
+
+        //! \brief Used by the caller to remember the entities found since the last call to markTiles
+        //! (like a building covering several tiles). The entity is identified by the index of one of its
+        //! tiles. Returns false if it was already marked
+        inline bool markEntity(uint32_t tileIndex)
+        {
+            if(mEntityMarks[tileIndex] == mCurrentMark)
+                return false;
+
+            mEntityMarks[tileIndex] = mCurrentMark;
+            return true;
+        }
+
+    private:
+        friend class EntitySpatialIndex;
+
+        std::vector<uint32_t> mMarks;
+        std::vector<uint32_t> mEntityMarks;
+        uint32_t mCurrentMark;
+    };
+
+    EntitySpatialIndex();
+
+    void resize(int mapSizeX, int mapSizeY);
+
+    void clear();
+
+    //! \brief Called when a creature enters/leaves the tile with the given index
+    void addCreature(GameEntity* creature, uint32_t tileIndex);
+    void removeCreature(GameEntity* creature, uint32_t tileIndex);
+
+    //! \brief Called when the tile with the given index gets/loses its covering building
+    void addBuildingTile(uint32_t tileIndex);
+    void removeBuildingTile(uint32_t tileIndex);
+
+    /*! \brief Marks the tiles within the given rectangle holding a creature allied with the given seat
+     * (or not allied if enemy is true). If withBuildings is true, the tiles covered by such a building are
+     * also marked in tileMarks. The marks of the previous call with the same tileMarks are forgotten.
+     * Returns the number of tiles marked.
+     * Marked tiles may hold creatures the caller is not interested in (like dead ones): they only
+     * tell where to look.
+     */
+    uint32_t markTiles(int xMin, int yMin, int xMax, int yMax, const Seat* seat, bool enemy,
+        bool withBuildings, const TileHotState& tileHotState, TileMarks& tileMarks) const;
+
+private:
+    struct Cell
+    {
+        //! \brief Creatures with the index of the tile they are on
+        std::vector<std::pair<GameEntity*, uint32_t>> mCreatures;
+        std::vector<uint32_t> mBuildingTiles;
+    };
+
+    Cell& getCell(uint32_t tileIndex);
+
+    //! \brief Returns true if an entity owned by entitySeat is wanted
+    static bool isSeatWanted(const Seat* entitySeat, const Seat* seat, bool enemy);
+
+    int mMapSizeX;
+    int mMapSizeY;
+    int mNbCellsX;
+    int mNbCellsY;
+    std::vector<Cell> mCells;
+};
+
+#endif // ENTITYSPATIALINDEX_H
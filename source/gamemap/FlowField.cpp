@@ -0,0 +1,172 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/FlowField.h"
+
+#include "creatureaction/CreatureAction.h"
+#include "entities/Creature.h"
+#include "entities/Tile.h"
+#include "game/Seat.h"
+#include "gamemap/TileContainer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+static const double INFINITE_DIST = std::numeric_limits<double>::max();
+
+FlowField::FlowField() :
+    mMapSizeX(0),
+    mMapSizeY(0)
+{
+}
+
+void FlowField::compute(const TileContainer& tileContainer, const std::vector<Tile*>& destinations, const Creature& creature)
+{
+    mMapSizeX = tileContainer.getMapSizeX();
+    mMapSizeY = tileContainer.getMapSizeY();
+    uint32_t nbTiles = static_cast<uint32_t>(mMapSizeX * mMapSizeY);
+    mDist.assign(nbTiles, INFINITE_DIST);
+    mNext.assign(nbTiles, -1);
+
+    typedef std::pair<double, uint32_t> OpenEntry;
+    std::greater<OpenEntry> compare;
+    std::vector<OpenEntry> openList;
+    for(Tile* tile : destinations)
+    {
+        uint32_t index = static_cast<uint32_t>(tile->getX() + tile->getY() * mMapSizeX);
+        mDist[index] = 0.0;
+        openList.push_back(OpenEntry(0.0, index));
+    }
+    std::make_heap(openList.begin(), openList.end(), compare);
+
+    // Moves are reversed compared to GameMap::path: when a tile is popped, we look for the
+    // neighbors that can walk to it. The weight of a move depends on the tile we come from
+    static const int MOVES[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+    while(!openList.empty())
+    {
+        std::pop_heap(openList.begin(), openList.end(), compare);
+        OpenEntry entry = openList.back();
+        openList.pop_back();
+        if(entry.first > mDist[entry.second])
+            continue;
+
+        int currentX = static_cast<int>(entry.second) % mMapSizeX;
+        int currentY = static_cast<int>(entry.second) / mMapSizeX;
+        for(uint32_t i = 0; i < 8; ++i)
+        {
+            int neighborX = currentX + MOVES[i][0];
+            int neighborY = currentY + MOVES[i][1];
+            Tile* neighborTile = tileContainer.getTile(neighborX, neighborY);
+            if(neighborTile == nullptr)
+                continue;
+
+            // Diagonal moves are only allowed if both tiles adjacent to the 2 tiles are passable
+            if((i >= 4) &&
+               (!creature.canGoThroughTile(tileContainer.getTile(currentX, neighborY)) ||
+                !creature.canGoThroughTile(tileContainer.getTile(neighborX, currentY))))
+            {
+                continue;
+            }
+
+            double speed;
+            if(neighborTile->getFullness() == 0)
+                speed = creature.getMoveSpeed(neighborTile);
+            else
+                speed = creature.getMoveSpeedGround();
+
+            if(speed <= 0.0)
+                continue;
+
+            uint32_t neighborIndex = static_cast<uint32_t>(neighborX + neighborY * mMapSizeX);
+            double dist = entry.first + static_cast<double>(std::abs(MOVES[i][0]) + std::abs(MOVES[i][1])) / speed;
+            if(dist >= mDist[neighborIndex])
+                continue;
+
+            mDist[neighborIndex] = dist;
+            mNext[neighborIndex] = static_cast<int32_t>(entry.second);
+
+            // A tile creatures cannot go through can be a start tile (for example a creature
+            // on a closed door) but we cannot walk through it
+            if(!creature.canGoThroughTile(neighborTile))
+                continue;
+
+            openList.push_back(OpenEntry(dist, neighborIndex));
+            std::push_heap(openList.begin(), openList.end(), compare);
+        }
+    }
+}
+
+bool FlowField::buildPath(const TileContainer& tileContainer, Tile* start, std::list<Tile*>& path) const
+{
+    uint32_t startIndex = static_cast<uint32_t>(start->getX() + start->getY() * mMapSizeX);
+    if((startIndex >= mDist.size()) || (mDist[startIndex] == INFINITE_DIST))
+        return false;
+
+    path.clear();
+    for(int32_t index = static_cast<int32_t>(startIndex); index >= 0; index = mNext[index])
+        path.push_back(tileContainer.getTile(index % mMapSizeX, index / mMapSizeX));
+
+    return true;
+}
+
+bool FlowFieldCache::Key::operator<(const Key& other) const
+{
+    if(mDestIndices != other.mDestIndices)
+        return mDestIndices < other.mDestIndices;
+    if(mSeatId != other.mSeatId)
+        return mSeatId < other.mSeatId;
+    if(mSpeedGround != other.mSpeedGround)
+        return mSpeedGround < other.mSpeedGround;
+    if(mSpeedWater != other.mSpeedWater)
+        return mSpeedWater < other.mSpeedWater;
+    if(mSpeedLava != other.mSpeedLava)
+        return mSpeedLava < other.mSpeedLava;
+
+    return mCanCrossEnemyDoors < other.mCanCrossEnemyDoors;
+}
+
+const FlowField& FlowFieldCache::getFlowField(const TileContainer& tileContainer, const std::vector<Tile*>& destinations,
+    const Creature& creature)
+{
+    Key key;
+    key.mDestIndices.reserve(destinations.size());
+    for(Tile* tile : destinations)
+        key.mDestIndices.push_back(static_cast<uint32_t>(tile->getX() + tile->getY() * tileContainer.getMapSizeX()));
+    std::sort(key.mDestIndices.begin(), key.mDestIndices.end());
+    key.mDestIndices.erase(std::unique(key.mDestIndices.begin(), key.mDestIndices.end()), key.mDestIndices.end());
+    key.mSpeedGround = creature.getMoveSpeedGround();
+    key.mSpeedWater = creature.getMoveSpeedWater();
+    key.mSpeedLava = creature.getMoveSpeedLava();
+    key.mSeatId = (creature.getSeat() == nullptr) ? -1 : creature.getSeat()->getId();
+    key.mCanCrossEnemyDoors = !creature.isActionInList(CreatureActionType::fight) &&
+        !creature.isActionInList(CreatureActionType::flee);
+
+    auto it = mFlowFields.find(key);
+    if(it != mFlowFields.end())
+        return it->second;
+
+    FlowField& flowField = mFlowFields[key];
+    flowField.compute(tileContainer, destinations, creature);
+    return flowField;
+}
+
+void FlowFieldCache::clear()
+{
+    mFlowFields.clear();
+}
@@ -0,0 +1,96 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <vector>
+
+class Creature;
+class Tile;
+class TileContainer;
+
+/*! \brief Distance to a set of destination tiles for every tile of the map, with the next tile
+ * to walk to.
+ *
+ * It is computed once with a reverse Dijkstra search starting from the destinations, using the
+ * same moves and weights as GameMap::path. Then, the path from any tile is found by following
+ * the next tiles, which is useful when many creatures go to the same place.
+ */
+class FlowField
+{
+public:
+    FlowField();
+
+    //! \brief Computes the field for the given creature passability (speeds, seat, ...)
+    void compute(const TileContainer& tileContainer, const std::vector<Tile*>& destinations, const Creature& creature);
+
+    //! \brief Fills path with the tiles from start to the closest destination (both included).
+    //! Returns false and leaves path untouched if no destination can be reached from start
+    bool buildPath(const TileContainer& tileContainer, Tile* start, std::list<Tile*>& path) const;
+
+private:
+    int mMapSizeX;
+    int mMapSizeY;
+
+    //! \brief Cost to reach the closest destination for each tile
+    std::vector<double> mDist;
+
+    //! \brief Index of the next tile to walk to. -1 for destinations and unreachable tiles
+    std::vector<int32_t> mNext;
+};
+
+/*! \brief Flow fields shared by the creatures going to the same destinations.
+ *
+ * Flow fields are keyed by the destinations and by the creature passability (move speeds,
+ * seat and whether it can cross enemy doors). They are meant to be cleared at each turn and
+ * when tile passability changes.
+ */
+class FlowFieldCache
+{
+public:
+    //! \brief Returns the flow field to the given destinations for the given creature. It is
+    //! computed if needed
+    const FlowField& getFlowField(const TileContainer& tileContainer, const std::vector<Tile*>& destinations,
+        const Creature& creature);
+
+    void clear();
+
+    inline uint32_t getNbFlowFields() const
+    { return static_cast<uint32_t>(mFlowFields.size()); }
+
+private:
+    struct Key
+    {
+        //! \brief Sorted indexes of the destination tiles
+        std::vector<uint32_t> mDestIndices;
+        double mSpeedGround;
+        double mSpeedWater;
+        double mSpeedLava;
+        int mSeatId;
+        bool mCanCrossEnemyDoors;
+
+        bool operator<(const Key& other) const;
+    };
+
+    std::map<Key, FlowField> mFlowFields;
+};
+
+#endif // FLOWFIELD_H
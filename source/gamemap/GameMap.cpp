@@ -39,7 +39,6 @@
 #include "game/SkillType.h"
 #include "game/Seat.h"
 #include "gamemap/MapHandler.h"
-#include "gamemap/Pathfinding.h"
 #include "gamemap/TileSet.h"
 #include "goals/Goal.h"
 #include "modes/ModeManager.h"
@@ -68,87 +67,15 @@
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 
 const std::string DEFAULT_NICK = "You";
 
-using namespace std;
-
-/*! \brief A helper class for the A* search in the GameMap::path function.
-*
-* This class stores the requisite information about a tile which is placed in
-* the search queue for the A-star, or A*, algorithm which is used to
-* calculate paths in the path function.
-*
-* The A* description can be found here:
-* http://en.wikipedia.org/wiki/A*_search_algorithm
-*/
-class AstarEntry
-{
-public:
-    AstarEntry() :
-        tile    (nullptr),
-        parent  (nullptr),
-        g       (0.0),
-        h       (0.0)
-    {}
-
-    AstarEntry(Tile* tile, int x1, int y1, int x2, int y2) :
-        tile    (tile),
-        parent  (nullptr),
-        g       (0.0),
-        h       (0.0),
-        mHasBeenProcessed (false)
-    {
-        h = computeHeuristic(x1, y1, x2, y2);
-    }
-
-    static double computeHeuristic(const int& x1, const int& y1, const int& x2, const int& y2)
-    {
-        return fabs(static_cast<double>(x2 - x1)) + fabs(static_cast<double>(y2 - y1));
-    }
-
-    void setHeuristic(const int& x1, const int& y1, const int& x2, const int& y2)
-    {
-        h = fabs(static_cast<double>(x2 - x1)) + fabs(static_cast<double>(y2 - y1));
-    }
-
-    inline double fCost() const
-    { return g + h; }
-
-    inline Tile* getTile() const
-    { return tile; }
-
-    inline bool getHasBeenProcessed() const
-    { return mHasBeenProcessed; }
-
-    inline void setHasBeenProcessed()
-    { mHasBeenProcessed = true; }
-
-    inline void setTile(Tile* newTile)
-    { tile = newTile; }
-
-    inline AstarEntry* getParent() const
-    { return parent; }
-
-    inline void setParent(AstarEntry* newParent)
-    { parent = newParent; }
-
-    inline const double& getG() const
-    { return g; }
-
-    inline void setG(const double& newG)
-    { g = newG; }
-
-private:
-    Tile*       tile;
-    AstarEntry* parent;
-    double      g;
-    double      h;
-    bool        mHasBeenProcessed;
-};
+const uint32_t GameMap::CREATURES_PER_SENSE_TASK = 8;
 
+using namespace std;
 
 GameMap::GameMap(bool isServerGameMap) :
         TileContainer(isServerGameMap ? 15 : 0),
@@ -159,8 +86,11 @@ GameMap::GameMap(bool isServerGameMap) :
         mIsPaused(false),
         mTimePayDay(0),
         mFloodFillEnabled(false),
+        mNbFloodFillTeams(0),
         mIsFOWActivated(true),
         mNumCallsTo_path(0),
+        mThreadPool(isServerGameMap ? ResourceManager::getSingleton().getNbSimulationThreads() : 0),
+        mPathJobQueue(mThreadPool),
         mAiManager(*this),
         mTileSet(nullptr)
 {
@@ -223,17 +153,18 @@ bool GameMap::loadLevel(const std::string& levelFilepath)
 
 bool GameMap::createNewMap(int sizeX, int sizeY)
 {
-    if (!allocateMapMemory(sizeX, sizeY))
+    // The former tiles are freed by allocateMapMemory
+    clearTileCaches();
+    if (!allocateMapMemory(this, sizeX, sizeY))
         return false;
 
     for (int jj = 0; jj < mMapSizeY; ++jj)
     {
         for (int ii = 0; ii < mMapSizeX; ++ii)
         {
-            Tile* tile = new Tile(this, ii, jj);
+            Tile* tile = getTile(ii, jj);
             tile->setName(Tile::buildName(ii, jj));
             tile->setType(TileType::dirt);
-            addTile(tile);
         }
     }
 
@@ -242,6 +173,15 @@ bool GameMap::createNewMap(int sizeX, int sizeY)
     return true;
 }
 
+void GameMap::clearTileCaches()
+{
+    mPathJobQueue.clear();
+    mVisionMap.clear();
+    mHierarchicalPathfinder.clear();
+    mPathCache.clear();
+    mFlowFieldCache.clear();
+}
+
 void GameMap::setAllFullnessAndNeighbors()
 {
     for (int ii = 0; ii < mMapSizeX; ++ii)
@@ -270,6 +210,7 @@ void GameMap::clearAll()
 
     processDeletionQueues();
 
+    clearTileCaches();
     clearTiles();
     processDeletionQueues();
 
@@ -336,6 +277,7 @@ void GameMap::clearCreatures()
     }
 
     mCreatures.clear();
+    mCreatureRegistry.clear();
 }
 
 void GameMap::clearAiManager()
@@ -382,6 +324,7 @@ void GameMap::clearRenderedMovableEntities()
     }
 
     mRenderedMovableEntities.clear();
+    mRenderedMovableEntityRegistry.clear();
 }
 
 void GameMap::clearPlayers()
@@ -400,7 +343,11 @@ void GameMap::resetUniqueNumbers()
     mUniqueNumberRenderedMovableEntity = 0;
     mUniqueNumberTrap = 0;
     mUniqueNumberMapLight = 0;
+    mUniqueNumberNetworkId = 0;
     mUniqueFloodFillValue = 0;
+    mFloodFillRegions.clear();
+    mFloodFillValues.clear();
+    mNbFloodFillTeams = 0;
 }
 
 void GameMap::addClassDescription(const CreatureDefinition *c)
@@ -489,7 +436,12 @@ void GameMap::addCreature(Creature *cc)
     OD_LOG_INF(serverStr() + "Adding Creature " + cc->getName()
         + ", seatId=" + (cc->getSeat() != nullptr ? Helper::toString(cc->getSeat()->getId()) : std::string("null")));
 
+    if(!mCreatureRegistry.add(cc))
+        OD_LOG_ERR("Duplicated creature name=" + cc->getName());
+
+    addNetworkEntity(cc);
     mCreatures.push_back(cc);
+    cc->updateSeatCounters();
 }
 
 void GameMap::removeCreature(Creature *c)
@@ -503,6 +455,10 @@ void GameMap::removeCreature(Creature *c)
         return;
     }
 
+    mCreatureRegistry.remove(c);
+    c->updateSeatCounters();
+    removeNetworkEntity(c);
+    mVisionMap.removeSource(*c);
     mCreatures.erase(it);
 }
 
@@ -819,19 +775,31 @@ void GameMap::removeAnimatedObject(MovableGameEntity *a)
 
 MovableGameEntity* GameMap::getAnimatedObject(const std::string& name) const
 {
-    for (MovableGameEntity* mge : mAnimatedObjects)
-    {
-        if (mge->getName().compare(name) == 0)
-            return mge;
-    }
+    // Animated objects are creatures, rendered movable entities, spells or map lights. We
+    // look for the name in their registries
+    MovableGameEntity* mge = mCreatureRegistry.getByName(name);
+    if(mge != nullptr)
+        return mge;
 
-    return nullptr;
+    mge = mRenderedMovableEntityRegistry.getByName(name);
+    if(mge != nullptr)
+        return mge;
+
+    mge = mSpellRegistry.getByName(name);
+    if(mge != nullptr)
+        return mge;
+
+    return mMapLightRegistry.getByName(name);
 }
 
 void GameMap::addRenderedMovableEntity(RenderedMovableEntity *obj)
 {
     OD_LOG_INF(serverStr() + "Adding rendered object " + obj->getName()
         + ",MeshName=" + obj->getMeshName());
+    if(!mRenderedMovableEntityRegistry.add(obj))
+        OD_LOG_ERR("Duplicated rendered object name=" + obj->getName());
+
+    addNetworkEntity(obj);
     mRenderedMovableEntities.push_back(obj);
 }
 
@@ -846,17 +814,14 @@ void GameMap::removeRenderedMovableEntity(RenderedMovableEntity *obj)
         return;
     }
 
+    mRenderedMovableEntityRegistry.remove(obj);
+    removeNetworkEntity(obj);
     mRenderedMovableEntities.erase(it);
 }
 
 RenderedMovableEntity* GameMap::getRenderedMovableEntity(const std::string& name)
 {
-    for(RenderedMovableEntity* renderedMovableEntity : mRenderedMovableEntities)
-    {
-        if(name.compare(renderedMovableEntity->getName()) == 0)
-            return renderedMovableEntity;
-    }
-    return nullptr;
+    return mRenderedMovableEntityRegistry.getByName(name);
 }
 
 void GameMap::addActiveObject(GameEntity *a)
@@ -1064,18 +1029,21 @@ void GameMap::destroyAllEntities()
 
 Creature* GameMap::getCreature(const std::string& cName) const
 {
-    for (Creature* creature : mCreatures)
-    {
-        if (creature->getName().compare(cName) == 0)
-            return creature;
-    }
-    return nullptr;
+    return mCreatureRegistry.getByName(cName);
 }
 
 void GameMap::doTurn(double timeSinceLastTurn)
 {
     OD_LOG_INF("Computing turn " + Helper::toString(mTurnNumber) + ", timeSinceLastTurn=" + Helper::toString(timeSinceLastTurn));
     unsigned int numCallsTo_path_atStart = mNumCallsTo_path;
+    uint32_t pathCacheHitsAtStart = mPathCache.getNbHits();
+    uint32_t pathCacheMissesAtStart = mPathCache.getNbMisses();
+
+    // Flow fields are only shared by the creatures moving during the same turn
+    mFlowFieldCache.clear();
+
+    // The paths requested during the previous turn are now ready
+    mPathJobQueue.deliverResults(*this);
 
     uint32_t miscUpkeepTime = doMiscUpkeep(timeSinceLastTurn);
 
@@ -1088,7 +1056,12 @@ void GameMap::doTurn(double timeSinceLastTurn)
     }
 
     OD_LOG_INF("During this turn there were " + Helper::toString(mNumCallsTo_path - numCallsTo_path_atStart)
-        + " calls to GameMap::path(), miscUpkeepTime=" + Helper::toString(miscUpkeepTime));
+        + " calls to GameMap::path() (cache hits=" + Helper::toString(mPathCache.getNbHits() - pathCacheHitsAtStart)
+        + ", misses=" + Helper::toString(mPathCache.getNbMisses() - pathCacheMissesAtStart)
+        + "), miscUpkeepTime=" + Helper::toString(miscUpkeepTime));
+
+    // The paths requested during this turn are computed until the next one
+    mPathJobQueue.startJobs();
 }
 
 void GameMap::doPlayerAITurn(double timeSinceLastTurn)
@@ -1098,7 +1071,6 @@ void GameMap::doPlayerAITurn(double timeSinceLastTurn)
 
 unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
 {
-    Tile *tempTile;
     Ogre::Timer stopwatch;
     unsigned long int timeTaken;
 
@@ -1116,20 +1088,7 @@ unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
                 continue;
 
             // We notify the player if he owns a fighter only
-            bool isCreatureSeat = false;
-            for(Creature* creature : mCreatures)
-            {
-                if(creature->getSeat() != player->getSeat())
-                    continue;
-
-                if(creature->getDefinition()->isWorker())
-                    continue;
-
-                isCreatureSeat = true;
-                break;
-            }
-
-            if(!isCreatureSeat)
+            if(player->getSeat()->getNumCreaturesFighters() <= 0)
                 continue;
 
             ServerNotification *serverNotification = new ServerNotification(
@@ -1159,62 +1118,18 @@ unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
         if (seat->checkAllGoals() == 0 && seat->numFailedGoals() == 0)
             addWinningSeat(seat);
 
+        // The number of workers/fighters is kept up to date by the creatures (see Creature::updateSeatCounters)
         seat->mNumCreaturesFightersMax = getMaxNumberCreatures(seat);
-
-        // Set the creatures count to 0. It will be reset by the next count in doTurn()
-        seat->mNumCreaturesFighters = 0;
-        seat->mNumCreaturesWorkers = 0;
-    }
-
-    // Count how many creatures the player controls
-    for(Creature* creature : mCreatures)
-    {
-        // Check to see if the creature has died.
-        if (!creature->isAlive())
-            continue;
-
-        Seat *tempSeat = creature->getSeat();
-        if(tempSeat == nullptr)
-            continue;
-
-        // We only count fighters
-        if (creature->getDefinition()->isWorker())
-            ++(tempSeat->mNumCreaturesWorkers);
-        else
-            ++(tempSeat->mNumCreaturesFighters);
     }
 
-    // At each upkeep, we re-compute tiles with vision
-    for (Seat* seat : mSeats)
-        seat->clearTilesWithVision();
-
-    for (int jj = 0; jj < getMapSizeY(); ++jj)
-    {
-        for (int ii = 0; ii < getMapSizeX(); ++ii)
-        {
-            getTile(ii,jj)->clearVision();
-        }
-    }
+#ifdef OD_DEBUG
+    auditSeatCounters();
+#endif
 
     // Compute vision. We need to compute every seats including AI because
-    // a human can be allied with an AI and they would share vision
-    for (int jj = 0; jj < getMapSizeY(); ++jj)
-    {
-        for (int ii = 0; ii < getMapSizeX(); ++ii)
-        {
-            getTile(ii,jj)->computeVisibleTiles();
-        }
-    }
-
-    for (Creature* creature : mCreatures)
-    {
-        creature->computeVisibleTiles();
-    }
-
-    for (Spell* spell : mSpells)
-    {
-        spell->computeVisibleTiles();
-    }
+    // a human can be allied with an AI and they would share vision. Only the
+    // sources that moved or changed since the last turn are recomputed
+    mVisionMap.update(*this);
 
     for (Seat* seat : mSeats)
     {
@@ -1228,6 +1143,9 @@ unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
     for (Seat* seat : mSeats)
         seat->sendVisibleTiles();
 
+    // The creatures look around them before the upkeep round (see senseCreaturesObjects)
+    senseCreaturesObjects();
+
     // Carry out the upkeep round of all the active objects in the game.
     // Here, we work on a copy of the active objects list because they might
     // try to remove themselves which would break the iterator
@@ -1260,41 +1178,92 @@ unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
         }
 
         // Update the count on how much gold is available in all of the treasuries claimed by the given seat.
-        seat->mGold = 0;
-        seat->mGoldMax = 0;
-        for (Room* room : getRooms())
-        {
-            if(room->getSeat() != seat)
-                continue;
+        // The totals are kept up to date by the rooms
+        seat->mGold = seat->getGoldStored();
+        seat->mGoldMax = seat->getGoldStorage();
+    }
 
-            seat->mGold += room->getTotalGoldStored();
-            seat->mGoldMax += room->getTotalGoldStorage();
-        }
+    // The number of tiles claimed by each seat is kept up to date by the tiles (see Tile::refreshHotState)
+
+    timeTaken = stopwatch.getMicroseconds();
+    return timeTaken;
+}
+
+void GameMap::senseCreaturesObjects()
+{
+    std::vector<Creature*> creatures;
+    for(Creature* creature : mCreatures)
+    {
+        if(!creature->isSensingObjects())
+            continue;
+
+        creatures.push_back(creature);
     }
 
-    // Determine the number of tiles claimed by each seat.
-    // Begin by setting the number of claimed tiles for each seat to 0.
-    for (Seat* seat : mSeats)
-        seat->setNumClaimedTiles(0);
+    if(mSenseWorkersTileMarks.size() < mThreadPool.getNbSlots())
+        mSenseWorkersTileMarks.resize(mThreadPool.getNbSlots());
 
-    // Now loop over all of the tiles, if the tile is claimed increment the given seats count.
-    for (int jj = 0; jj < getMapSizeY(); ++jj)
+    mThreadPool.parallelFor(0, static_cast<uint32_t>(creatures.size()), CREATURES_PER_SENSE_TASK,
+        [this, &creatures](uint32_t begin, uint32_t end)
     {
-        for (int ii = 0; ii < getMapSizeX(); ++ii)
-        {
-            tempTile = getTile(ii,jj);
+        EntitySpatialIndex::TileMarks& workerTileMarks = mSenseWorkersTileMarks[mThreadPool.getCurrentSlot()];
+        for(uint32_t index = begin; index < end; ++index)
+            creatures[index]->senseObjects(workerTileMarks);
+    });
+}
 
-            // Check to see if the current tile is claimed by anyone.
-            if (tempTile->isClaimed())
-            {
-                // Increment the count of the seat who owns the tile.
-                tempTile->getSeat()->incrementNumClaimedTiles();
-            }
-        }
+void GameMap::auditSeatCounters() const
+{
+    // Full recount of the counters the seats keep up to date
+    std::map<const Seat*, unsigned int> numClaimedTiles;
+    const TileHotState& hotState = getTileHotState();
+    uint32_t nbTiles = hotState.getNbTiles();
+    for (uint32_t index = 0; index < nbTiles; ++index)
+    {
+        if (hotState.isClaimed(index))
+            ++numClaimedTiles[hotState.getSeat(index)];
     }
 
-    timeTaken = stopwatch.getMicroseconds();
-    return timeTaken;
+    std::map<const Seat*, int> numWorkers;
+    std::map<const Seat*, int> numFighters;
+    for(Creature* creature : mCreatures)
+    {
+        if (!creature->isAlive())
+            continue;
+
+        if(creature->getSeat() == nullptr)
+            continue;
+
+        if (creature->getDefinition()->isWorker())
+            ++numWorkers[creature->getSeat()];
+        else
+            ++numFighters[creature->getSeat()];
+    }
+
+    std::map<const Seat*, int> goldStored;
+    std::map<const Seat*, int> goldStorage;
+    for (Room* room : mRooms)
+    {
+        goldStored[room->getSeat()] += room->getTotalGoldStored();
+        goldStorage[room->getSeat()] += room->getTotalGoldStorage();
+    }
+
+    for (const Seat* seat : mSeats)
+    {
+        if((seat->getNumClaimedTiles() != numClaimedTiles[seat]) ||
+           (seat->getNumCreaturesWorkers() != numWorkers[seat]) ||
+           (seat->getNumCreaturesFighters() != numFighters[seat]) ||
+           (seat->getGoldStored() != goldStored[seat]) ||
+           (seat->getGoldStorage() != goldStorage[seat]))
+        {
+            OD_LOG_ERR("Wrong counters for seatId=" + Helper::toString(seat->getId())
+                + ", claimedTiles=" + Helper::toString(seat->getNumClaimedTiles()) + "/" + Helper::toString(numClaimedTiles[seat])
+                + ", workers=" + Helper::toString(seat->getNumCreaturesWorkers()) + "/" + Helper::toString(numWorkers[seat])
+                + ", fighters=" + Helper::toString(seat->getNumCreaturesFighters()) + "/" + Helper::toString(numFighters[seat])
+                + ", goldStored=" + Helper::toString(seat->getGoldStored()) + "/" + Helper::toString(goldStored[seat])
+                + ", goldStorage=" + Helper::toString(seat->getGoldStorage()) + "/" + Helper::toString(goldStorage[seat]));
+        }
+    }
 }
 
 void GameMap::updateAnimations(Ogre::Real timeSinceLastFrame)
@@ -1342,74 +1311,80 @@ std::list<Tile*> GameMap::findBestPath(const Creature* creature, Tile* tileStart
     if(possibleDests.empty())
         return returnList;
 
-    // We start by sorting the vector
-    std::vector<Tile*> possibleDestsTmp = possibleDests;
-    std::sort(possibleDestsTmp.begin(), possibleDestsTmp.end(), [this, &tileStart](Tile* tile1, Tile* tile2){
-              int d1 = Pathfinding::squaredDistanceTile(*tile1, *tileStart);
-              int d2 = Pathfinding::squaredDistanceTile(*tile2, *tileStart);
-              return d1 < d2;
-        });
-
-    double magic = 2.0;
-    for(Tile* tile : possibleDestsTmp)
+    // We only keep the destinations the creature can reach. Then, one search from the start tile
+    // is enough to find the closest one
+    std::vector<Tile*> reachableDests;
+    reachableDests.reserve(possibleDests.size());
+    for(Tile* tile : possibleDests)
     {
         if(!pathExists(creature, tileStart, tile))
             continue;
 
-        // The first reachable tile is the best by default
-        Ogre::Real dist = std::hypotf(tile->getX() - tileStart->getX(), tile->getY() - tileStart->getY());
-        if(chosenTile == nullptr)
-        {
-            chosenTile = tile;
-            returnList = path(tileStart, tile, creature, creature->getSeat(), false);
-            continue;
-        }
+        reachableDests.push_back(tile);
+    }
 
-        // We compute the path only if walkableDist < (dist * magic).
-        double walkableDist = static_cast<double>(returnList.size());
-        if(walkableDist < (dist * magic))
-            continue;
+    if(reachableDests.empty())
+        return returnList;
 
-        std::list<Tile*> pathTmp = path(tileStart, tile, creature, creature->getSeat(), false);
-        if(pathTmp.size() < returnList.size())
-        {
-            // The path is shorter
-            chosenTile = tile;
-            returnList = pathTmp;
-        }
-    }
+    ++mNumCallsTo_path;
+    mPathfindingContext.findPathToClosest(*this, tileStart, reachableDests, *creature, creature->getSeat(),
+        returnList, chosenTile);
     return returnList;
 }
 
-bool GameMap::pathExists(const Creature* creature, Tile* tileStart, Tile* tileEnd)
+std::list<Tile*> GameMap::pathFromFlowField(const Creature* creature, Tile* tileStart, const std::vector<Tile*>& possibleDests)
 {
-    // If floodfill is not enabled, we cannot check if the path exists so we return true
-    if(!mFloodFillEnabled)
-        return true;
+    std::list<Tile*> returnList;
+    if((creature == nullptr) || (tileStart == nullptr) || possibleDests.empty())
+        return returnList;
 
-    // We check if the tile we are heading to is walkable. We don't do the same for the start tile because it might
-    //not be the case if a creature is on a door tile while it is closed
-    if(creature == nullptr)
-        return false;
+    // Flow fields are only invalidated on server side
+    if(!mIsServerGameMap)
+    {
+        Tile* chosenTile = nullptr;
+        return findBestPath(creature, tileStart, possibleDests, chosenTile);
+    }
+
+    ++mNumCallsTo_path;
+    const FlowField& flowField = mFlowFieldCache.getFlowField(*this, possibleDests, *creature);
+    flowField.buildPath(*this, tileStart, returnList);
+    return returnList;
+}
 
+FloodFillType GameMap::getFloodFillTypeForCreature(const Creature& creature) const
+{
     FloodFillType floodFill = FloodFillType::ground;
-    if((creature->getMoveSpeedGround() > 0.0) &&
-        (creature->getMoveSpeedWater() > 0.0) &&
-        (creature->getMoveSpeedLava() > 0.0))
+    if((creature.getMoveSpeedGround() > 0.0) &&
+        (creature.getMoveSpeedWater() > 0.0) &&
+        (creature.getMoveSpeedLava() > 0.0))
     {
         floodFill = FloodFillType::groundWaterLava;
     }
-    if((creature->getMoveSpeedGround() > 0.0) &&
-        (creature->getMoveSpeedWater() > 0.0))
+    if((creature.getMoveSpeedGround() > 0.0) &&
+        (creature.getMoveSpeedWater() > 0.0))
     {
         floodFill = FloodFillType::groundWater;
     }
-    if((creature->getMoveSpeedGround() > 0.0) &&
-        (creature->getMoveSpeedLava() > 0.0))
+    if((creature.getMoveSpeedGround() > 0.0) &&
+        (creature.getMoveSpeedLava() > 0.0))
     {
         floodFill = FloodFillType::groundLava;
     }
+    return floodFill;
+}
 
+bool GameMap::pathExists(const Creature* creature, Tile* tileStart, Tile* tileEnd)
+{
+    // If floodfill is not enabled, we cannot check if the path exists so we return true
+    if(!mFloodFillEnabled)
+        return true;
+
+    // We check if the tile we are heading to is walkable. We don't do the same for the start tile because it might
+    //not be the case if a creature is on a door tile while it is closed
+    if(creature == nullptr)
+        return false;
+
+    FloodFillType floodFill = getFloodFillTypeForCreature(*creature);
     if(creature->getDefinition()->isWorker())
     {
         // Workers can go on a tile if and only if the path is open for any creature. If it is closed, that
@@ -1454,199 +1429,122 @@ std::list<Tile*> GameMap::path(int x1, int y1, int x2, int y2, const Creature* c
     if (!throughDiggableTiles && !pathExists(creature, start, destination))
         return returnList;
 
-    AstarEntry *currentEntry = new AstarEntry(start, x1, y1, x2, y2);
-    AstarEntry neighbor;
-
-    std::vector<AstarEntry*> openList;
-    openList.push_back(currentEntry);
-
-    // This list will contain the processed and the to process entries
-    // allowing to quickly know if a tile has been processed or not
-    std::vector<std::vector<AstarEntry*>> processList(getMapSizeX(), std::vector<AstarEntry*>(getMapSizeY(), nullptr));
-    processList[currentEntry->getTile()->getX()][currentEntry->getTile()->getY()] = currentEntry;
-    AstarEntry* destinationEntry = nullptr;
-    while (true)
+    // Paths are only cached on server side where the tile changes are notified
+    bool useCache = !throughDiggableTiles && mIsServerGameMap;
+    PathCache::Key cacheKey;
+    if(useCache)
     {
-        // if the openList is empty we failed to find a path
-        if (openList.empty())
-            break;
-
-        // openList being sorted, the last element is the smallest
-        AstarEntry* smallestAstar = *openList.rbegin();
-        openList.pop_back();
+        mPathCache.setMapSize(getMapSizeX(), getMapSizeY());
+        cacheKey = getPathCacheKey(x1, y1, x2, y2, *creature);
+        if(mPathCache.getPath(cacheKey, returnList))
+            return returnList;
+    }
 
-        currentEntry = smallestAstar;
-        currentEntry->setHasBeenProcessed();
+    computePath(start, destination, *creature, seat, throughDiggableTiles, returnList);
 
-        // We found the path, break out of the search loop
-        if (currentEntry->getTile() == destination)
-        {
-            destinationEntry = currentEntry;
-            break;
-        }
-
-        // Check the tiles surrounding the current square
-        bool areTilesPassable[4] = {false, false, false, false};
-        // Note : to disable diagonals, process tiles from 0 to 3. To allow them, process tiles from 0 to 7
-        for (unsigned int i = 0; i < 8; ++i)
-        {
-            Tile* neighborTile = nullptr;
-            switch(i)
-            {
-                // We process the 4 adjacent tiles
-                case 0:
-                    neighborTile = getTile(currentEntry->getTile()->getX() - 1, currentEntry->getTile()->getY());
-                    break;
-                case 1:
-                    neighborTile = getTile(currentEntry->getTile()->getX() + 1, currentEntry->getTile()->getY());
-                    break;
-                case 2:
-                    neighborTile = getTile(currentEntry->getTile()->getX(), currentEntry->getTile()->getY() - 1);
-                    break;
-                case 3:
-                    neighborTile = getTile(currentEntry->getTile()->getX(), currentEntry->getTile()->getY() + 1);
-                    break;
-                // We process the 4 diagonal tiles. We only process a diagonal tile if the 2 tiles adjacent to the original one are
-                // passable.
-                case 4:
-                    if(areTilesPassable[0] && areTilesPassable[2])
-                        neighborTile = getTile(currentEntry->getTile()->getX() - 1, currentEntry->getTile()->getY() - 1);
-                    break;
-                case 5:
-                    if(areTilesPassable[0] && areTilesPassable[3])
-                        neighborTile = getTile(currentEntry->getTile()->getX() - 1, currentEntry->getTile()->getY() + 1);
-                    break;
-                case 6:
-                    if(areTilesPassable[1] && areTilesPassable[2])
-                        neighborTile = getTile(currentEntry->getTile()->getX() + 1, currentEntry->getTile()->getY() - 1);
-                    break;
-                case 7:
-                    if(areTilesPassable[1] && areTilesPassable[3])
-                        neighborTile = getTile(currentEntry->getTile()->getX() + 1, currentEntry->getTile()->getY() + 1);
-                    break;
-                default:
-                    break;
-            }
-            if(neighborTile == nullptr)
-                continue;
+    if(useCache)
+        mPathCache.addPath(cacheKey, returnList);
 
-            neighbor.setTile(neighborTile);
+    return returnList;
+}
 
-            bool processNeighbor = false;
-            // We process the tile if the creature can go through. But if it is the first tile that is
-            // not passable, we also process it. That happens if a door is closed
-            if((creature->canGoThroughTile(neighbor.getTile())) ||
-               (neighbor.getTile() == start))
-            {
-                processNeighbor = true;
-                // We set passability for the 4 adjacent tiles only
-                if(i < 4)
-                    areTilesPassable[i] = true;
-             }
-            else if(throughDiggableTiles && neighbor.getTile()->isDiggable(seat))
-                processNeighbor = true;
-
-            if (!processNeighbor)
-                continue;
+PathCache::Key GameMap::getPathCacheKey(int x1, int y1, int x2, int y2, const Creature& creature) const
+{
+    PathCache::Key cacheKey;
+    cacheKey.mStartIndex = static_cast<uint32_t>(x1 + y1 * getMapSizeX());
+    cacheKey.mDestIndex = static_cast<uint32_t>(x2 + y2 * getMapSizeX());
+    cacheKey.mSpeedGround = creature.getMoveSpeedGround();
+    cacheKey.mSpeedWater = creature.getMoveSpeedWater();
+    cacheKey.mSpeedLava = creature.getMoveSpeedLava();
+    cacheKey.mSeatId = (creature.getSeat() == nullptr) ? -1 : creature.getSeat()->getId();
+    cacheKey.mCanCrossEnemyDoors = !creature.isActionInList(CreatureActionType::fight) &&
+        !creature.isActionInList(CreatureActionType::flee);
+    return cacheKey;
+}
 
-            // See if the neighbor has already been processed
-            AstarEntry* neighborEntry = processList[neighbor.getTile()->getX()][neighbor.getTile()->getY()];
-            if ((neighborEntry != nullptr) && (neighborEntry->getHasBeenProcessed()))
-                continue;
+std::shared_ptr<PathRequest> GameMap::requestPath(const Creature* creature, Tile* tileDest)
+{
+    Tile* tileStart = (creature == nullptr) ? nullptr : creature->getPositionTile();
+    if((tileStart == nullptr) || (tileDest == nullptr))
+        return std::make_shared<PathRequest>(std::list<Tile*>());
 
-            // If the neighbor is not in the open list
-            if (neighborEntry == nullptr)
-            {
-                double weightToParent = AstarEntry::computeHeuristic(neighbor.getTile()->getX(), neighbor.getTile()->getY(),
-                    currentEntry->getTile()->getX(), currentEntry->getTile()->getY());
-
-                if(currentEntry->getTile()->getFullness() == 0)
-                    weightToParent /= creature->getMoveSpeed(currentEntry->getTile());
-                else
-                    weightToParent /= creature->getMoveSpeedGround();
-                neighbor.setG(currentEntry->getG() + weightToParent);
-
-                // Use the manhattan distance for the heuristic
-                neighbor.setHeuristic(neighbor.getTile()->getX(), neighbor.getTile()->getY(), x2, y2);
-                neighbor.setParent(currentEntry);
-
-                AstarEntry* entry = new AstarEntry(neighbor);
-                auto itr = openList.begin();
-                while((itr != openList.end()) &&
-                      ((*itr)->fCost() > entry->fCost()))
-                {
-                    ++itr;
-                }
+    // Paths are only computed in the background on server side
+    if(!mIsServerGameMap || isInEditorMode())
+        return std::make_shared<PathRequest>(path(creature, tileDest));
 
-                openList.insert(itr, entry);
-                processList[neighbor.getTile()->getX()][neighbor.getTile()->getY()] = entry;
-            }
-            else
-            {
-                // If this path to the given neighbor tile is a shorter path than the
-                // one already given, make this the new parent.
-                double weightToParent = AstarEntry::computeHeuristic(neighbor.getTile()->getX(), neighbor.getTile()->getY(),
-                    currentEntry->getTile()->getX(), currentEntry->getTile()->getY());
+    // If we already know the answer, no need to wait
+    if(!pathExists(creature, tileStart, tileDest))
+        return std::make_shared<PathRequest>(std::list<Tile*>());
 
-                if(currentEntry->getTile()->getFullness() == 0)
-                    weightToParent /= creature->getMoveSpeed(currentEntry->getTile());
-                else
-                    weightToParent /= creature->getMoveSpeedGround();
+    std::list<Tile*> returnList;
+    mPathCache.setMapSize(getMapSizeX(), getMapSizeY());
+    if(mPathCache.getPath(getPathCacheKey(tileStart->getX(), tileStart->getY(), tileDest->getX(), tileDest->getY(), *creature), returnList))
+        return std::make_shared<PathRequest>(returnList);
 
-                if (currentEntry->getG() + weightToParent < neighborEntry->getG())
-                {
-                    neighborEntry->setG(currentEntry->getG() + weightToParent);
-                    neighborEntry->setParent(currentEntry);
+    ++mNumCallsTo_path;
+    return mPathJobQueue.queueRequest(*this, tileStart, tileDest, *creature);
+}
 
-                    // The cost changed. We need to re-order openList
-                    auto itr = std::find(openList.begin(), openList.end(), neighborEntry);
-                    if(itr == openList.end())
-                    {
-                        OD_LOG_ERR("Unexpected entry not found tileStart=" + Tile::displayAsString(start)
-                            + ", tileDest=" + Tile::displayAsString(destination)
-                            + ", tile=" + Tile::displayAsString(neighborEntry->getTile()));
-                    }
-                    else
-                    {
-                        itr = openList.erase(itr);
-                        // We look for the new location
-                        while((itr != openList.end()) &&
-                              ((*itr)->fCost() > neighborEntry->fCost()))
-                        {
-                            ++itr;
-                        }
-
-                        openList.insert(itr, neighborEntry);
-                    }
-                }
-            }
+void GameMap::computePath(Tile* start, Tile* destination, const Creature& creature, Seat* seat,
+    bool throughDiggableTiles, std::list<Tile*>& returnList)
+{
+    // For long paths, we first try to find a path in the abstract graph. If it fails (for example
+    // because of a closed door), we do a full search
+    int distance = std::abs(destination->getX() - start->getX()) + std::abs(destination->getY() - start->getY());
+    if(!throughDiggableTiles && mIsServerGameMap && !isInEditorMode() &&
+       (distance > HierarchicalPathfinder::MIN_DISTANCE))
+    {
+        if(mHierarchicalPathfinder.findPath(*this, mPathfindingContext, start, destination, creature,
+            getFloodFillTypeForCreature(creature), seat, returnList))
+        {
+            return;
         }
     }
 
-    if (destinationEntry != nullptr)
-    {
-        // Follow the parent chain back the the starting tile
-        AstarEntry* curEntry = destinationEntry;
-        do
-        {
-            if (curEntry->getTile() != nullptr)
-            {
-                returnList.push_front(curEntry->getTile());
-                curEntry = curEntry->getParent();
-            }
+    mPathfindingContext.findPath(*this, start, destination, creature, seat, throughDiggableTiles, returnList);
+}
 
-        } while (curEntry != nullptr);
-    }
+void GameMap::notifyTilePassabilityChanged(Tile& tile, TilePassabilityChange change)
+{
+    if(!mIsServerGameMap)
+        return;
 
-    // Clean up the memory we allocated by deleting the astarEntries.  Note that
-    // processList contains all the created entries so it is enough to clean it.
-    for (std::vector<AstarEntry*>& column : processList)
+    // A building can be a bridge (that opens paths when added and blocks them when removed) or a
+    // door (the opposite). Its owner also matters for doors so both ways are possible
+    bool mayOpenPaths = false;
+    bool mayBlockPaths = false;
+    switch(change)
     {
-        for (AstarEntry* entry : column)
-            delete entry;
+        case TilePassabilityChange::dug:
+        case TilePassabilityChange::doorUnlocked:
+            mayOpenPaths = true;
+            break;
+        case TilePassabilityChange::filled:
+        case TilePassabilityChange::doorLocked:
+            mayBlockPaths = true;
+            break;
+        case TilePassabilityChange::coveringBuilding:
+            mayOpenPaths = true;
+            mayBlockPaths = true;
+            break;
     }
 
-    return returnList;
+    mHierarchicalPathfinder.notifyTileChanged(tile);
+
+    // Every change notified here changes the speed of some creatures on the tile so the flow
+    // fields of the turn cannot be kept
+    mFlowFieldCache.clear();
+    mPathJobQueue.notifyTilePassabilityChanged(*this, tile, mayBlockPaths);
+
+    // The tile may block (or stop blocking) the sight of the creatures around
+    mVisionMap.notifyTileVisionChanged(tile);
+
+    // If the tile can now be walked through (or faster), a shorter path may exist for any
+    // cached path. Otherwise, only the paths going through the tile are affected
+    if(mayOpenPaths)
+        mPathCache.clear();
+    else
+        mPathCache.invalidateTile(tile);
 }
 
 bool GameMap::addPlayer(Player* player)
@@ -1702,9 +1600,52 @@ Player* GameMap::getPlayerBySeat(Seat* seat) const
     return nullptr;
 }
 
-std::vector<GameEntity*> GameMap::getVisibleForce(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemyForce)
+uint32_t GameMap::markVisibleEntitiesTiles(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemy, bool withBuildings,
+    EntitySpatialIndex::TileMarks& tileMarks) const
 {
-    std::vector<GameEntity*> returnList;
+    if(visibleTiles.empty())
+        return 0;
+
+    // We compute the area covered by the visible tiles from their index so that we do not
+    // have to read them
+    int xMin = getMapSizeX();
+    int yMin = getMapSizeY();
+    int xMax = -1;
+    int yMax = -1;
+    for(Tile* tile : visibleTiles)
+    {
+        if(tile == nullptr)
+            continue;
+
+        uint32_t index = getTileIndex(tile);
+        int xx = static_cast<int>(index) % getMapSizeX();
+        int yy = static_cast<int>(index) / getMapSizeX();
+        xMin = std::min(xMin, xx);
+        yMin = std::min(yMin, yy);
+        xMax = std::max(xMax, xx);
+        yMax = std::max(yMax, yy);
+    }
+
+    if(xMax < 0)
+        return 0;
+
+    return getEntitySpatialIndex().markTiles(xMin, yMin, xMax, yMax, seat, enemy, withBuildings, getTileHotState(), tileMarks);
+}
+
+void GameMap::getVisibleForce(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemyForce,
+    std::vector<GameEntity*>& forces)
+{
+    getVisibleForce(visibleTiles, seat, enemyForce, mTileMarks, forces);
+}
+
+void GameMap::getVisibleForce(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemyForce,
+    EntitySpatialIndex::TileMarks& tileMarks, std::vector<GameEntity*>& forces) const
+{
+    forces.clear();
+
+    // Most of the time, there is nothing to look for around. In this case, we can avoid looking at the tiles
+    if(markVisibleEntitiesTiles(visibleTiles, seat, enemyForce, true, tileMarks) == 0)
+        return;
 
     // Loop over the visible tiles
     for (Tile* tile : visibleTiles)
@@ -1715,38 +1656,43 @@ std::vector<GameEntity*> GameMap::getVisibleForce(const std::vector<Tile*>& visi
             continue;
         }
 
+        if(!tileMarks.isMarked(getTileIndex(tile)))
+            continue;
+
+        // A building covering several visible tiles is only added once. It is identified by its first tile
         if(enemyForce)
         {
-            tile->fillWithEntities(returnList, SelectionEntityWanted::creatureAliveEnemyAttackable, seat->getPlayer());
+            tile->fillWithEntities(forces, SelectionEntityWanted::creatureAliveEnemyAttackable, seat->getPlayer());
             Building* building = tile->getCoveringBuilding();
             if((building != nullptr) &&
                (!building->getSeat()->isAlliedSeat(seat)) &&
                (building->isAttackable(tile, seat)) &&
-               (std::find(returnList.begin(), returnList.end(), building) == returnList.end()))
+               (tileMarks.markEntity(getTileIndex(building->getCoveredTile(0)))))
             {
-                returnList.push_back(building);
+                forces.push_back(building);
             }
         }
         else
         {
-            tile->fillWithEntities(returnList, SelectionEntityWanted::creatureAliveAllied, seat->getPlayer());
+            tile->fillWithEntities(forces, SelectionEntityWanted::creatureAliveAllied, seat->getPlayer());
             Building* building = tile->getCoveringBuilding();
             if((building != nullptr) &&
                (building->getSeat()->isAlliedSeat(seat)) &&
-               (std::find(returnList.begin(), returnList.end(), building) == returnList.end()))
+               (tileMarks.markEntity(getTileIndex(building->getCoveredTile(0)))))
             {
-                returnList.push_back(building);
+                forces.push_back(building);
             }
         }
     }
-
-    return returnList;
 }
 
 std::vector<GameEntity*> GameMap::getVisibleCreatures(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemyCreatures)
 {
     std::vector<GameEntity*> returnList;
 
+    if(markVisibleEntitiesTiles(visibleTiles, seat, enemyCreatures, false, mTileMarks) == 0)
+        return returnList;
+
     // Loop over the visible tiles
     for (Tile* tile : visibleTiles)
     {
@@ -1756,6 +1702,9 @@ std::vector<GameEntity*> GameMap::getVisibleCreatures(const std::vector<Tile*>&
             continue;
         }
 
+        if(!mTileMarks.isMarked(getTileIndex(tile)))
+            continue;
+
         if(enemyCreatures)
         {
             tile->fillWithEntities(returnList, SelectionEntityWanted::creatureAliveEnemyAttackable, seat->getPlayer());
@@ -1799,6 +1748,7 @@ void GameMap::clearRooms()
     }
 
     mRooms.clear();
+    mRoomRegistry.clear();
 }
 
 void GameMap::addRoom(Room *r)
@@ -1811,7 +1761,11 @@ void GameMap::addRoom(Room *r)
         OD_LOG_INF(serverStr() + "Adding room " + r->getName() + ", tile=" + Tile::displayAsString(tile));
     }
 
+    if(!mRoomRegistry.add(r))
+        OD_LOG_ERR("Duplicated room name=" + r->getName());
+
     mRooms.push_back(r);
+    r->getSeat()->addRoom(r);
 }
 
 void GameMap::removeRoom(Room *r)
@@ -1826,7 +1780,18 @@ void GameMap::removeRoom(Room *r)
         return;
     }
 
+    mRoomRegistry.remove(r);
     mRooms.erase(it);
+    r->getSeat()->removeRoom(r);
+}
+
+void GameMap::notifyRoomSeatChanged(Room* room, Seat* oldSeat)
+{
+    if(oldSeat == room->getSeat())
+        return;
+
+    oldSeat->removeRoom(room);
+    room->getSeat()->addRoom(room);
 }
 
 std::vector<Room*> GameMap::getRoomsByType(RoomType type) const
@@ -1844,9 +1809,12 @@ std::vector<Room*> GameMap::getRoomsByType(RoomType type) const
 std::vector<Room*> GameMap::getRoomsByTypeAndSeat(RoomType type, const Seat* seat)
 {
     std::vector<Room*> returnList;
-    for (Room* room : mRooms)
+    if(seat == nullptr)
+        return returnList;
+
+    for (Room* room : seat->getRooms(type))
     {
-        if (room->getType() == type && room->getSeat() == seat && room->getHP(nullptr) > 0.0)
+        if (room->getHP(nullptr) > 0.0)
             returnList.push_back(room);
     }
 
@@ -1856,9 +1824,12 @@ std::vector<Room*> GameMap::getRoomsByTypeAndSeat(RoomType type, const Seat* sea
 std::vector<const Room*> GameMap::getRoomsByTypeAndSeat(RoomType type, const Seat* seat) const
 {
     std::vector<const Room*> returnList;
-    for (const Room* room : mRooms)
+    if(seat == nullptr)
+        return returnList;
+
+    for (const Room* room : seat->getRooms(type))
     {
-        if (room->getType() == type && room->getSeat() == seat && room->getHP(nullptr) > 0.0)
+        if (room->getHP(nullptr) > 0.0)
             returnList.push_back(room);
     }
 
@@ -1868,9 +1839,12 @@ std::vector<const Room*> GameMap::getRoomsByTypeAndSeat(RoomType type, const Sea
 unsigned int GameMap::numRoomsByTypeAndSeat(RoomType type, const Seat* seat) const
 {
     int cptRooms = 0;
-    for (Room* room : mRooms)
+    if(seat == nullptr)
+        return cptRooms;
+
+    for (Room* room : seat->getRooms(type))
     {
-        if (room->getType() == type && room->getSeat() == seat && room->getHP(nullptr) > 0.0)
+        if (room->getHP(nullptr) > 0.0)
             ++cptRooms;
     }
     return cptRooms;
@@ -1932,24 +1906,12 @@ std::vector<Building*> GameMap::getReachableBuildingsPerSeat(Seat* seat,
 
 Room* GameMap::getRoomByName(const std::string& name)
 {
-    for (Room* room : mRooms)
-    {
-        if(room->getName().compare(name) == 0)
-            return room;
-    }
-
-    return nullptr;
+    return mRoomRegistry.getByName(name);
 }
 
 Trap* GameMap::getTrapByName(const std::string& name)
 {
-    for (Trap* trap : mTraps)
-    {
-        if(trap->getName().compare(name) == 0)
-            return trap;
-    }
-
-    return nullptr;
+    return mTrapRegistry.getByName(name);
 }
 
 void GameMap::clearTraps()
@@ -1963,6 +1925,7 @@ void GameMap::clearTraps()
     }
 
     mTraps.clear();
+    mTrapRegistry.clear();
 }
 
 void GameMap::addTrap(Trap *trap)
@@ -1971,7 +1934,11 @@ void GameMap::addTrap(Trap *trap)
     OD_LOG_INF(serverStr() + "Adding trap " + trap->getName() + ", nbTiles="
         + Helper::toString(nbTiles) + ", seatId=" + Helper::toString(trap->getSeat()->getId()));
 
+    if(!mTrapRegistry.add(trap))
+        OD_LOG_ERR("Duplicated trap name=" + trap->getName());
+
     mTraps.push_back(trap);
+    trap->getSeat()->addTrap(trap);
 }
 
 void GameMap::removeTrap(Trap *t)
@@ -1984,7 +1951,9 @@ void GameMap::removeTrap(Trap *t)
         return;
     }
 
+    mTrapRegistry.remove(t);
     mTraps.erase(it);
+    t->getSeat()->removeTrap(t);
 }
 
 bool GameMap::withdrawFromTreasuries(int gold, Seat* seat)
@@ -1995,11 +1964,8 @@ bool GameMap::withdrawFromTreasuries(int gold, Seat* seat)
 
     // Loop over the treasuries withdrawing gold until the full amount has been withdrawn.
     int goldStillNeeded = gold;
-    for (Room* room : getRooms())
+    for (Room* room : seat->getRooms(RoomType::treasury))
     {
-        if(room->getSeat() != seat)
-            continue;
-
         int goldTaken = room->withdrawGold(goldStillNeeded);
         goldStillNeeded -= goldTaken;
         if(goldStillNeeded <= 0)
@@ -2020,11 +1986,16 @@ void GameMap::clearMapLights()
     }
 
     mMapLights.clear();
+    mMapLightRegistry.clear();
 }
 
 void GameMap::addMapLight(MapLight *m)
 {
     OD_LOG_INF(serverStr() + "Adding MapLight " + m->getName());
+    if(!mMapLightRegistry.add(m))
+        OD_LOG_ERR("Duplicated MapLight name=" + m->getName());
+
+    addNetworkEntity(m);
     mMapLights.push_back(m);
 }
 
@@ -2039,18 +2010,14 @@ void GameMap::removeMapLight(MapLight *m)
         return;
     }
 
+    mMapLightRegistry.remove(m);
+    removeNetworkEntity(m);
     mMapLights.erase(it);
 }
 
 MapLight* GameMap::getMapLight(const std::string& name) const
 {
-    for (MapLight* mapLight : mMapLights)
-    {
-        if (mapLight->getName() == name)
-            return mapLight;
-    }
-
-    return nullptr;
+    return mMapLightRegistry.getByName(name);
 }
 
 void GameMap::clearSeats()
@@ -2203,17 +2170,89 @@ bool GameMap::doFloodFill(Seat* seat, Tile* tile)
 
 void GameMap::replaceFloodFill(Seat* seat, FloodFillType floodFillType, uint32_t colorOld, uint32_t colorNew)
 {
-    for (int jj = 0; jj < getMapSizeY(); ++jj)
+    uint32_t teamIndex = seat->getTeamIndex();
+    uint32_t intType = static_cast<uint32_t>(floodFillType);
+    if((teamIndex >= mFloodFillRegions.size()) ||
+       (intType >= mFloodFillRegions[teamIndex].size()))
     {
-        for (int ii = 0; ii < getMapSizeX(); ++ii)
+        static bool logMsg = false;
+        if(!logMsg)
         {
-            Tile* tile = getTile(ii,jj);
-            if(tile->getFloodFillValue(seat, floodFillType) != colorOld)
-                continue;
+            logMsg = true;
+            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
+                + ", seatIndex=" + Helper::toString(teamIndex) + ", intType=" + Helper::toString(intType));
+        }
+        return;
+    }
+
+    // Instead of repainting every tile colored with colorOld, we merge the regions
+    mFloodFillRegions[teamIndex][intType].merge(colorOld, colorNew);
+}
+
+uint32_t GameMap::getFloodFillRegion(uint32_t teamIndex, FloodFillType floodFillType, uint32_t value) const
+{
+    uint32_t intType = static_cast<uint32_t>(floodFillType);
+    if((teamIndex >= mFloodFillRegions.size()) ||
+       (intType >= mFloodFillRegions[teamIndex].size()))
+    {
+        return value;
+    }
+
+    return mFloodFillRegions[teamIndex][intType].find(value);
+}
 
-            tile->replaceFloodFill(seat, floodFillType, colorNew);
+bool GameMap::getFloodFillOffset(uint32_t teamIndex, FloodFillType floodFillType, uint32_t& offset) const
+{
+    uint32_t intType = static_cast<uint32_t>(floodFillType);
+    uint32_t nbTypes = static_cast<uint32_t>(FloodFillType::nbValues);
+    if((teamIndex >= mNbFloodFillTeams) || (intType >= nbTypes))
+    {
+        static bool logMsg = false;
+        if(!logMsg)
+        {
+            logMsg = true;
+            OD_LOG_ERR("Wrong floodfill seat index seatIndex=" + Helper::toString(teamIndex)
+                + ", nbTeams=" + Helper::toString(mNbFloodFillTeams) + ", intType=" + Helper::toString(intType));
         }
+        return false;
     }
+
+    offset = (teamIndex * nbTypes + intType) * getNbTiles();
+    return true;
+}
+
+uint32_t GameMap::getFloodFillValue(uint32_t teamIndex, FloodFillType floodFillType, uint32_t tileIndex) const
+{
+    uint32_t offset;
+    if(!getFloodFillOffset(teamIndex, floodFillType, offset))
+        return Tile::NO_FLOODFILL;
+
+    // Regions may have been merged since this tile was painted
+    return getFloodFillRegion(teamIndex, floodFillType, mFloodFillValues[offset + tileIndex]);
+}
+
+void GameMap::setFloodFillValue(uint32_t teamIndex, FloodFillType floodFillType, uint32_t tileIndex, uint32_t value)
+{
+    uint32_t offset;
+    if(!getFloodFillOffset(teamIndex, floodFillType, offset))
+        return;
+
+    mFloodFillValues[offset + tileIndex] = value;
+}
+
+bool GameMap::isSameFloodFill(uint32_t teamIndex, FloodFillType floodFillType, uint32_t tileIndex1, uint32_t tileIndex2) const
+{
+    uint32_t offset;
+    if(!getFloodFillOffset(teamIndex, floodFillType, offset))
+        return true;
+
+    uint32_t value1 = mFloodFillValues[offset + tileIndex1];
+    uint32_t value2 = mFloodFillValues[offset + tileIndex2];
+    if(value1 == value2)
+        return true;
+
+    // The tiles may have been painted before their regions got merged
+    return getFloodFillRegion(teamIndex, floodFillType, value1) == getFloodFillRegion(teamIndex, floodFillType, value2);
 }
 
 void GameMap::refreshFloodFill(Seat* seat, Tile* tile)
@@ -2278,13 +2317,9 @@ void GameMap::enableFloodFill()
 {
     // Carry out a flood fill of the whole level to make sure everything is good.
     // Start by setting the flood fill color for every tile on the map to -1.
-    for (int jj = 0; jj < getMapSizeY(); ++jj)
-    {
-        for (int ii = 0; ii < getMapSizeX(); ++ii)
-        {
-            getTile(ii,jj)->resetFloodFill();
-        }
-    }
+    std::fill(mFloodFillValues.begin(), mFloodFillValues.end(), Tile::NO_FLOODFILL);
+    mFloodFillRegions.assign(mTeamIds.size(),
+        std::vector<DisjointSets>(static_cast<uint32_t>(FloodFillType::nbValues)));
 
     // The algorithm used to find a path is efficient when the path exists but not if it doesn't.
     // To improve path finding, we tag the contiguous tiles to know if a path exists between 2 tiles or not.
@@ -2562,11 +2597,8 @@ int GameMap::addGoldToSeat(int gold, int seatId)
     if(seat == nullptr)
         return gold;
 
-    for (Room* room : getRooms())
+    for (Room* room : seat->getRooms(RoomType::treasury))
     {
-        if(room->getSeat() != seat)
-            continue;
-
         if(room->numCoveredTiles() == 0)
             continue;
 
@@ -2707,6 +2739,37 @@ GameEntity* GameMap::getEntityFromTypeAndName(GameEntityType entityType,
     return nullptr;
 }
 
+MovableGameEntity* GameMap::getEntityFromNetworkId(uint32_t networkId) const
+{
+    auto it = mEntitiesByNetworkId.find(networkId);
+    if(it == mEntitiesByNetworkId.end())
+        return nullptr;
+
+    return it->second;
+}
+
+void GameMap::addNetworkEntity(MovableGameEntity* entity)
+{
+    // On client side, the id is received from the server. Entities created locally have none
+    if(isServerGameMap() && (entity->getNetworkId() == 0))
+        entity->setNetworkId(++mUniqueNumberNetworkId);
+
+    if(entity->getNetworkId() == 0)
+        return;
+
+    if(!mEntitiesByNetworkId.emplace(entity->getNetworkId(), entity).second)
+        OD_LOG_ERR("Duplicated network id=" + Helper::toString(entity->getNetworkId()) + ", name=" + entity->getName());
+}
+
+void GameMap::removeNetworkEntity(MovableGameEntity* entity)
+{
+    auto it = mEntitiesByNetworkId.find(entity->getNetworkId());
+    if((it == mEntitiesByNetworkId.end()) || (it->second != entity))
+        return;
+
+    mEntitiesByNetworkId.erase(it);
+}
+
 void GameMap::logFloodFileTiles()
 {
     for(int yy = 0; yy < getMapSizeY(); ++yy)
@@ -2830,6 +2893,10 @@ void GameMap::addSpell(Spell *spell)
 {
     OD_LOG_INF(serverStr() + "Adding spell " + spell->getName()
         + ",MeshName=" + spell->getMeshName());
+    if(!mSpellRegistry.add(spell))
+        OD_LOG_ERR("Duplicated spell name=" + spell->getName());
+
+    addNetworkEntity(spell);
     mSpells.push_back(spell);
 }
 
@@ -2844,17 +2911,15 @@ void GameMap::removeSpell(Spell *spell)
         return;
     }
 
+    mSpellRegistry.remove(spell);
+    removeNetworkEntity(spell);
+    mVisionMap.removeSource(*spell);
     mSpells.erase(it);
 }
 
 Spell* GameMap::getSpell(const std::string& name) const
 {
-    for(Spell* spell : mSpells)
-    {
-        if(name.compare(spell->getName()) == 0)
-            return spell;
-    }
-    return nullptr;
+    return mSpellRegistry.getByName(name);
 }
 
 void GameMap::clearSpells()
@@ -2868,6 +2933,7 @@ void GameMap::clearSpells()
     }
 
     mSpells.clear();
+    mSpellRegistry.clear();
 }
 
 std::vector<Spell*> GameMap::getSpellsBySeatAndType(Seat* seat, SpellType type) const
@@ -3058,6 +3124,8 @@ void GameMap::clientUpKeep(int64_t turnNumber)
 
 void GameMap::doorLock(Tile* tileDoor, Seat* seat, bool locked)
 {
+    notifyTilePassabilityChanged(*tileDoor, locked ? TilePassabilityChange::doorLocked : TilePassabilityChange::doorUnlocked);
+
     if(!locked)
     {
         // When a door is unlocked, we check all its neighboors to find a floodfill value for each possible
@@ -3233,18 +3301,11 @@ void GameMap::notifySeatsConfigured()
         seat->setTeamIndex(teamIndex);
     }
 
-    uint32_t nbTeams = mTeamIds.size();
-    for(int xxx = 0; xxx < getMapSizeX(); ++xxx)
-    {
-        for(int yyy = 0; yyy < getMapSizeY(); ++yyy)
-        {
-            Tile* tile = getTile(xxx, yyy);
-            if(tile == nullptr)
-                continue;
-
-            tile->setTeamsNumber(nbTeams);
-        }
-    }
+    // The floodfill values of every team are stored in a single block. The number of teams
+    // includes the rogue team
+    mNbFloodFillTeams = static_cast<uint32_t>(mTeamIds.size());
+    mFloodFillValues.assign(static_cast<size_t>(mNbFloodFillTeams) * static_cast<size_t>(FloodFillType::nbValues) * getNbTiles(),
+        Tile::NO_FLOODFILL);
     // Now that team ids are set and tiles are configured, we can compute floodfill
     enableFloodFill();
 }
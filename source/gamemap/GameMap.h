@@ -18,10 +18,20 @@
 #ifndef GAMEMAP_H
 #define GAMEMAP_H
 
+#include "gamemap/EntityRegistry.h"
+#include "gamemap/FlowField.h"
+#include "gamemap/HierarchicalPathfinder.h"
+#include "gamemap/PathCache.h"
+#include "gamemap/PathJobQueue.h"
+#include "gamemap/PathfindingContext.h"
 #include "gamemap/TileContainer.h"
+#include "gamemap/VisionMap.h"
 
 #include "ai/AIManager.h"
 
+#include "utils/DisjointSets.h"
+#include "utils/ThreadPool.h"
+
 #ifdef __MINGW32__
 #ifndef mode_t
 #include <sys/types.h>
@@ -32,6 +42,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include <OgreVector3.h>
 
@@ -85,6 +96,16 @@ enum class SelectionEntityWanted
     creatureAliveEnemyAttackable
 };
 
+//! \brief What changed on a tile that may change whether creatures can go through it
+enum class TilePassabilityChange
+{
+    dug,                // The tile is not full anymore
+    filled,             // The tile became full
+    coveringBuilding,   // A building (bridge, door, ...) was added, removed or claimed on the tile
+    doorLocked,
+    doorUnlocked
+};
+
 /*! \brief The class which stores the entire game state on the server and a subset of this on each client.
  *
  * This class is one of the key classes in the OpenDungeons game.  The map
@@ -157,6 +178,14 @@ public:
     inline bool getIsFOWActivated() const
     { return mIsFOWActivated; }
 
+    //! \brief Tiles each seat has vision on. Updated at each turn on server side
+    inline VisionMap& getVisionMap()
+    { return mVisionMap; }
+
+    //! \brief Thread pool shared by the subsystems updating the game map. On client side, it has no worker
+    inline ThreadPool& getThreadPool()
+    { return mThreadPool; }
+
     //! \brief Returns a vector containing all the creatures controlled by the given seat.
     std::vector<Creature*> getCreaturesByAlliedSeat(const Seat* seat) const;
     std::vector<Creature*> getCreaturesBySeat(const Seat* seat) const;
@@ -240,6 +269,10 @@ public:
     Room* getRoomByName(const std::string& name);
     Trap* getTrapByName(const std::string& name);
 
+    //! \brief Called when a room on the gamemap is claimed by another seat so that
+    //! the rooms of each seat are kept up to date
+    void notifyRoomSeatChanged(Room* room, Seat* oldSeat);
+
     //! \brief Traps related functions.
     void clearTraps();
     void addTrap(Trap *t);
@@ -346,16 +379,35 @@ public:
     //! \brief Tells whether a path exists between two tiles for the given creature.
     bool pathExists(const Creature* creature, Tile* tileStart, Tile* tileEnd);
 
+    //! \brief Should be called each time something that may change whether creatures can go through
+    //! the given tile happens (tile dug or filled, bridge built or destroyed, door locked, ...)
+    //! Claiming a tile without building does not change its passability so it should not be notified.
+    //! The hot state of the tile should be refreshed before
+    void notifyTilePassabilityChanged(Tile& tile, TilePassabilityChange change);
+
     /*! \brief Calculates the walkable path between tileStart and one of the possibleDests. This function
      * will choose the closest tile in possibleDests and return the path between tileStart and it.
      * If a path is found, it is returned and chosenTile is set to the chosen tile. If no path is found,
      * an empty list will be returned and chosenTile will be set to nullptr
-     * Note that this function will use some magic numbers to avoid computing paths that are likely to be
-     * further
+     * Note that all the destinations are searched at once so the cost does not grow with the number
+     * of possible destinations
      */
     std::list<Tile*> findBestPath(const Creature* creature, Tile* tileStart, const std::vector<Tile*> possibleDests,
         Tile*& chosenTile);
 
+    /*! \brief Same as findBestPath but meant to be used when many creatures go to the same destinations (call
+     * to war, pay day, ...). The path is built from a flow field computed once per turn and shared by
+     * every creature with the same seat and move speeds going to possibleDests.
+     * Returns an empty list if no destination can be reached.
+     */
+    std::list<Tile*> pathFromFlowField(const Creature* creature, Tile* tileStart, const std::vector<Tile*>& possibleDests);
+
+    /*! \brief Same as path but the path is computed in the background. It will be ready at the start of
+     * the next turn. If the path is already known or cannot be computed in the background (client side,
+     * editor), the returned request is ready right away.
+     */
+    std::shared_ptr<PathRequest> requestPath(const Creature* creature, Tile* tileDest);
+
     /*! \brief Calculates the walkable path between tiles (x1, y1) and (x2, y2).
      *
      * The search is carried out using the A-star search algorithm.
@@ -374,9 +426,15 @@ public:
     //! \note Returns a path for the given creature to the given destination.
     std::list<Tile*> path(const Creature* creature, Tile* destination, bool throughDiggableTiles = false);
 
-    //! \brief Loops over the visibleTiles and returns any creature/room/trap in those tiles allied with the given seat
-    //! (or if enemyForce is true, is not allied)
-    std::vector<GameEntity*> getVisibleForce(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemyForce);
+    //! \brief Fills forces with any creature/room/trap in the visibleTiles allied with the given seat
+    //! (or if enemyForce is true, not allied). forces is cleared first so that the caller can reuse it
+    void getVisibleForce(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemyForce,
+        std::vector<GameEntity*>& forces);
+
+    //! \brief Same as getVisibleForce but marks the tiles to look at in the given tileMarks. It only reads the
+    //! gamemap so it can be called from several threads at the same time if each one uses its own tileMarks
+    void getVisibleForce(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemyForce,
+        EntitySpatialIndex::TileMarks& tileMarks, std::vector<GameEntity*>& forces) const;
 
     //! \brief Loops over the visibleTiles and returns any creature in those tiles allied with the given seat.
     //! (or if enemyCreatures is true, is not allied)
@@ -390,8 +448,28 @@ public:
     //! already know that no path exists.
     bool doFloodFill(Seat* seat, Tile* tile);
     void refreshFloodFill(Seat* seat, Tile* tile);
+    //! \brief Merges the floodfill region colorOld into colorNew for the given seat team. Tiles are not
+    //! changed: their floodfill values are resolved with getFloodFillRegion
     void replaceFloodFill(Seat* seat, FloodFillType floodFillType, uint32_t colorOld, uint32_t colorNew);
 
+    //! \brief Returns the floodfill region the given floodfill value belongs to for the given team index
+    uint32_t getFloodFillRegion(uint32_t teamIndex, FloodFillType floodFillType, uint32_t value) const;
+
+    //! \brief Returns the floodfill value of the tile with the given index for the given team index,
+    //! resolved with the merged regions. Returns Tile::NO_FLOODFILL if the team index is not valid
+    uint32_t getFloodFillValue(uint32_t teamIndex, FloodFillType floodFillType, uint32_t tileIndex) const;
+
+    //! \brief Sets the floodfill value of the tile with the given index for the given team index
+    void setFloodFillValue(uint32_t teamIndex, FloodFillType floodFillType, uint32_t tileIndex, uint32_t value);
+
+    //! \brief Returns true if the tiles with the given indexes are in the same floodfill region. It does not
+    //! modify the game map so it can be called by the AIs while they decide (see AIManager::doTurn)
+    bool isSameFloodFill(uint32_t teamIndex, FloodFillType floodFillType, uint32_t tileIndex1, uint32_t tileIndex2) const;
+
+    //! \brief Number of teams floodfill values are stored for. This number includes the rogue team.
+    inline uint32_t getNbFloodFillTeams() const
+    { return mNbFloodFillTeams; }
+
     //! \brief Temporarily disables the flood fill computations on this game map.
     void disableFloodFill()
     { mFloodFillEnabled = false; }
@@ -473,6 +551,9 @@ public:
     void clearRenderedMovableEntities();
     GameEntity* getEntityFromTypeAndName(GameEntityType entityType,
         const std::string& entityName);
+    //! \brief Returns the entity with the given network id or nullptr if there is none. Only the
+    //! entities sent with addEntity (creatures, rendered movable entities, spells and map lights) have one
+    MovableGameEntity* getEntityFromNetworkId(uint32_t networkId) const;
 
     //! brief Functions to add/remove/get Spells
     inline const std::vector<Spell*>& getSpells() const
@@ -578,6 +659,20 @@ private:
 
     std::vector<Creature*> mCreatures;
 
+    //! \brief Name indexes of the entities. The vectors are kept to iterate in the order the entities
+    //! have been added
+    EntityRegistry<Creature> mCreatureRegistry;
+    EntityRegistry<Room> mRoomRegistry;
+    EntityRegistry<Trap> mTrapRegistry;
+    EntityRegistry<MapLight> mMapLightRegistry;
+    EntityRegistry<RenderedMovableEntity> mRenderedMovableEntityRegistry;
+    EntityRegistry<Spell> mSpellRegistry;
+
+    //! \brief Entities that can be addressed by network id. On server side, the ids are given when the
+    //! entities are added for the first time and are never reused
+    std::unordered_map<uint32_t, MovableGameEntity*> mEntitiesByNetworkId;
+    uint32_t mUniqueNumberNetworkId;
+
     //! \brief The creature definition data. We use a pair to be able to make the difference between the original
     //! data from the global creature definition file and the specific data from the level file. With this trick,
     //! we will be able to compare and write the differences in the level file.
@@ -607,6 +702,19 @@ private:
     //! \brief Tells whether the map color flood filling is enabled.
     bool mFloodFillEnabled;
 
+    //! \brief Floodfill regions merged together, indexed by team index and floodfill type. When
+    //! regions get connected, they are merged here instead of repainting every tile
+    std::vector<std::vector<DisjointSets>> mFloodFillRegions;
+
+    //! \brief Floodfill values of every tile in a single block indexed by [team index][floodfill type][tile index].
+    //! The values of a team and type are contiguous so that pathExists only has to load 2 values
+    std::vector<uint32_t> mFloodFillValues;
+    uint32_t mNbFloodFillTeams;
+
+    //! \brief Sets offset to the position of the values for the given team index and type in mFloodFillValues.
+    //! Returns false if the team index is not valid
+    bool getFloodFillOffset(uint32_t teamIndex, FloodFillType floodFillType, uint32_t& offset) const;
+
     //! When true, fog of war will work normally. When false, every connected client will see the whole map
     bool mIsFOWActivated;
 
@@ -618,6 +726,36 @@ private:
     //! \brief Debug member used to know how many call to pathfinding has been made within the same turn.
     unsigned int mNumCallsTo_path;
 
+    //! \brief Working memory reused by every call to path(). It is sized once for the map
+    PathfindingContext mPathfindingContext;
+
+    //! \brief Abstract graph used to speed up long paths on the server game map
+    HierarchicalPathfinder mHierarchicalPathfinder;
+
+    //! \brief Paths computed on the server game map. Invalidated by notifyTilePassabilityChanged
+    PathCache mPathCache;
+
+    //! \brief Flow fields computed during the current turn. Cleared at each turn and when a tile
+    //! is dug, filled, covered by a building or when a door is locked or unlocked
+    FlowFieldCache mFlowFieldCache;
+
+    //! \brief Workers used by the simulation. Declared before the members using it so that it is
+    //! destroyed after them
+    ThreadPool mThreadPool;
+
+    //! \brief Paths requested with requestPath. Solved between turns
+    PathJobQueue mPathJobQueue;
+
+    //! \brief Vision given by the claimed tiles, creatures and spells. Only the sources that changed
+    //! are recomputed at each turn
+    VisionMap mVisionMap;
+
+    //! \brief Marks used by the spatial index queries run on the main thread
+    EntitySpatialIndex::TileMarks mTileMarks;
+
+    //! \brief Marks used by each slot of the thread pool during the sense phase (see senseCreaturesObjects)
+    std::vector<EntitySpatialIndex::TileMarks> mSenseWorkersTileMarks;
+
     std::vector<RenderedMovableEntity*> mRenderedMovableEntities;
 
     std::vector<Spell*> mSpells;
@@ -635,8 +773,46 @@ private:
     //! Updates active objects (creatures, rooms, ...), goals, count each team Workers, gold, mana and claimed tiles.
     unsigned long int doMiscUpkeep(double timeSinceLastTurn);
 
+    //! \brief Number of creatures sensing in each task of the thread pool
+    static const uint32_t CREATURES_PER_SENSE_TASK;
+
+    /*! \brief Sense phase of the creatures upkeep. Before the active objects do their upkeep, the creatures
+     * compute the objects they see (see Creature::senseObjects). As it only reads the gamemap, the creatures
+     * are split between the threads of the thread pool. Each creature only writes its own data so that the result does not
+     * depend on the number of workers. The creatures then use what they sensed when they do their upkeep
+     * one after the other on the main thread.
+     */
+    void senseCreaturesObjects();
+
+    PathCache::Key getPathCacheKey(int x1, int y1, int x2, int y2, const Creature& creature) const;
+
+    //! \brief Computes the path from start to destination without using the cache
+    void computePath(Tile* start, Tile* destination, const Creature& creature, Seat* seat,
+        bool throughDiggableTiles, std::list<Tile*>& returnList);
+
+    //! \brief Returns the floodfill type to use to check paths for the given creature
+    FloodFillType getFloodFillTypeForCreature(const Creature& creature) const;
+
     //! \brief Resets the unique numbers
     void resetUniqueNumbers();
+
+    //! \brief Clears the pathfinding and vision caches. They keep pointers to the tiles so this has
+    //! to be called before the tiles are freed
+    void clearTileCaches();
+
+    //! \brief Called when an entity sent with addEntity is added/removed. On server side, gives a
+    //! network id to the entity if it has none
+    void addNetworkEntity(MovableGameEntity* entity);
+    void removeNetworkEntity(MovableGameEntity* entity);
+
+    //! \brief Marks in tileMarks the visibleTiles that may hold a creature (or a building if withBuildings
+    //! is true) allied with the given seat (or not allied if enemy is true). Returns the number of tiles marked
+    uint32_t markVisibleEntitiesTiles(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemy, bool withBuildings,
+        EntitySpatialIndex::TileMarks& tileMarks) const;
+
+    //! \brief Debug builds only. Recounts the claimed tiles, creatures and treasury gold of each seat and
+    //! logs an error if they differ from the counters kept up to date by the seats
+    void auditSeatCounters() const;
 };
 
 #endif // GAMEMAP_H
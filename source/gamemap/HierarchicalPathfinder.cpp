@@ -0,0 +1,677 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/HierarchicalPathfinder.h"
+
+#include "entities/Creature.h"
+#include "entities/Tile.h"
+#include "gamemap/PathfindingContext.h"
+#include "gamemap/TileContainer.h"
+#include "rooms/Room.h"
+#include "rooms/RoomType.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+const int HierarchicalPathfinder::CLUSTER_SIZE = 10;
+const int HierarchicalPathfinder::MIN_DISTANCE = 2 * HierarchicalPathfinder::CLUSTER_SIZE;
+
+//! \brief Entrances on a border opening longer than that are created at both ends of the opening
+//! instead of only in the middle
+static const int LONG_OPENING = 6;
+
+static const double INFINITE_DIST = std::numeric_limits<double>::max();
+
+static inline double manhattanDistance(int x1, int y1, int x2, int y2)
+{
+    return static_cast<double>(std::abs(x2 - x1) + std::abs(y2 - y1));
+}
+
+//! \brief Bridges allow to walk on water and lava as if it was ground
+static bool isBridge(const Tile& tile)
+{
+    Room* room = tile.getCoveringRoom();
+    return (room != nullptr) &&
+        ((room->getType() == RoomType::bridgeWooden) ||
+         (room->getType() == RoomType::bridgeStone));
+}
+
+HierarchicalPathfinder::HierarchicalPathfinder() :
+    mMapSizeX(0),
+    mMapSizeY(0),
+    mNbClustersX(0),
+    mNbClustersY(0),
+    mGeneration(0)
+{
+}
+
+void HierarchicalPathfinder::clear()
+{
+    mMapSizeX = 0;
+    mMapSizeY = 0;
+    mNbClustersX = 0;
+    mNbClustersY = 0;
+    mTilePassability.clear();
+    mTileTerrain.clear();
+    mGraphs.clear();
+}
+
+uint8_t HierarchicalPathfinder::computePassability(const Tile& tile)
+{
+    if(tile.getFullness() > 0.0)
+        return 0;
+
+    if(isBridge(tile))
+        return (1 << static_cast<uint32_t>(FloodFillType::nbValues)) - 1;
+
+    uint8_t passability = 0;
+    for(uint32_t type = 0; type < static_cast<uint32_t>(FloodFillType::nbValues); ++type)
+    {
+        if(tile.isFloodFillPossible(nullptr, static_cast<FloodFillType>(type)))
+            passability |= (1 << type);
+    }
+    return passability;
+}
+
+uint8_t HierarchicalPathfinder::computeTerrain(const Tile& tile)
+{
+    if(isBridge(tile))
+        return Ground;
+
+    switch(tile.getTileVisual())
+    {
+        case TileVisual::waterGround:
+            return Water;
+        case TileVisual::lavaGround:
+            return Lava;
+        default:
+            return Ground;
+    }
+}
+
+double HierarchicalPathfinder::computeCost(const TerrainDistances& distances, const double* speeds)
+{
+    double cost = 0.0;
+    for(uint32_t terrain = 0; terrain < NbTerrains; ++terrain)
+    {
+        if(distances.mDistances[terrain] == 0.0)
+            continue;
+
+        // The creature cannot walk on this terrain
+        if(speeds[terrain] <= 0.0)
+            return INFINITE_DIST;
+
+        cost += distances.mDistances[terrain] / speeds[terrain];
+    }
+    return cost;
+}
+
+void HierarchicalPathfinder::build(const TileContainer& tileContainer)
+{
+    mMapSizeX = tileContainer.getMapSizeX();
+    mMapSizeY = tileContainer.getMapSizeY();
+    mNbClustersX = (mMapSizeX + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    mNbClustersY = (mMapSizeY + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+    uint32_t nbTiles = static_cast<uint32_t>(mMapSizeX * mMapSizeY);
+    mTilePassability.assign(nbTiles, 0);
+    mTileTerrain.assign(nbTiles, Ground);
+    for(int yy = 0; yy < mMapSizeY; ++yy)
+    {
+        for(int xx = 0; xx < mMapSizeX; ++xx)
+        {
+            const Tile& tile = *tileContainer.getTile(xx, yy);
+            mTilePassability[xx + yy * mMapSizeX] = computePassability(tile);
+            mTileTerrain[xx + yy * mMapSizeX] = computeTerrain(tile);
+        }
+    }
+
+    mGraphs.assign(static_cast<uint32_t>(FloodFillType::nbValues), AbstractGraph());
+    for(AbstractGraph& graph : mGraphs)
+    {
+        graph.mClusters.resize(static_cast<uint32_t>(mNbClustersX * mNbClustersY));
+        for(int cy = 0; cy < mNbClustersY; ++cy)
+        {
+            for(int cx = 0; cx < mNbClustersX; ++cx)
+            {
+                Cluster& cluster = graph.mClusters[clusterIndex(cx, cy)];
+                cluster.mDirtyEast = (cx < mNbClustersX - 1);
+                cluster.mDirtySouth = (cy < mNbClustersY - 1);
+                cluster.mDirtyIntra = true;
+            }
+        }
+        graph.mHasDirtyClusters = true;
+    }
+
+    mAbstractGeneration.assign(nbTiles, 0);
+    mAbstractG.assign(nbTiles, 0.0);
+    mAbstractParent.assign(nbTiles, -1);
+    mAbstractClosed.assign(nbTiles, false);
+    mGeneration = 0;
+}
+
+void HierarchicalPathfinder::notifyTileChanged(const Tile& tile)
+{
+    // If the graph is not built yet, it will be computed from the current map state
+    if(mTilePassability.empty())
+        return;
+
+    int xx = tile.getX();
+    int yy = tile.getY();
+    if((xx < 0) || (yy < 0) || (xx >= mMapSizeX) || (yy >= mMapSizeY))
+        return;
+
+    uint8_t& passability = mTilePassability[xx + yy * mMapSizeX];
+    uint8_t& terrain = mTileTerrain[xx + yy * mMapSizeX];
+    uint8_t newPassability = computePassability(tile);
+    uint8_t newTerrain = computeTerrain(tile);
+    uint8_t changed = passability ^ newPassability;
+    // If the terrain changes (like a bridge built on water), the cost of the edges going through
+    // the tile changes for the types it is passable for
+    if(terrain != newTerrain)
+        changed |= newPassability;
+
+    passability = newPassability;
+    terrain = newTerrain;
+    if(changed == 0)
+        return;
+
+    int cx = xx / CLUSTER_SIZE;
+    int cy = yy / CLUSTER_SIZE;
+    int localX = xx % CLUSTER_SIZE;
+    int localY = yy % CLUSTER_SIZE;
+    for(uint32_t type = 0; type < mGraphs.size(); ++type)
+    {
+        if((changed & (1 << type)) == 0)
+            continue;
+
+        AbstractGraph& graph = mGraphs[type];
+        graph.mHasDirtyClusters = true;
+        graph.mClusters[clusterIndex(cx, cy)].mDirtyIntra = true;
+
+        // Borders are stored in the cluster on the west/north side
+        if((localX == 0) && (cx > 0))
+            graph.mClusters[clusterIndex(cx - 1, cy)].mDirtyEast = true;
+        if((localX == CLUSTER_SIZE - 1) && (cx < mNbClustersX - 1))
+            graph.mClusters[clusterIndex(cx, cy)].mDirtyEast = true;
+        if((localY == 0) && (cy > 0))
+            graph.mClusters[clusterIndex(cx, cy - 1)].mDirtySouth = true;
+        if((localY == CLUSTER_SIZE - 1) && (cy < mNbClustersY - 1))
+            graph.mClusters[clusterIndex(cx, cy)].mDirtySouth = true;
+    }
+}
+
+void HierarchicalPathfinder::repair(uint32_t type)
+{
+    AbstractGraph& graph = mGraphs[type];
+    if(!graph.mHasDirtyClusters)
+        return;
+
+    // Borders first because they change the entrances (and thus the intra edges) of both clusters
+    for(int cy = 0; cy < mNbClustersY; ++cy)
+    {
+        for(int cx = 0; cx < mNbClustersX; ++cx)
+        {
+            Cluster& cluster = graph.mClusters[clusterIndex(cx, cy)];
+            if(cluster.mDirtyEast)
+                rebuildBorder(type, cx, cy, East);
+            if(cluster.mDirtySouth)
+                rebuildBorder(type, cx, cy, South);
+        }
+    }
+
+    for(int cy = 0; cy < mNbClustersY; ++cy)
+    {
+        for(int cx = 0; cx < mNbClustersX; ++cx)
+        {
+            if(graph.mClusters[clusterIndex(cx, cy)].mDirtyIntra)
+                computeIntraEdges(type, cx, cy);
+        }
+    }
+
+    graph.mHasDirtyClusters = false;
+}
+
+void HierarchicalPathfinder::removeEntrances(Cluster& cluster, BorderSide side)
+{
+    for(AbstractNode& node : cluster.mNodes)
+    {
+        node.mInterEdges.erase(std::remove_if(node.mInterEdges.begin(), node.mInterEdges.end(),
+            [side](const AbstractEdge& edge) { return edge.mSide == side; }), node.mInterEdges.end());
+        node.mSides &= ~(1 << side);
+    }
+
+    cluster.mNodes.erase(std::remove_if(cluster.mNodes.begin(), cluster.mNodes.end(),
+        [](const AbstractNode& node) { return node.mSides == 0; }), cluster.mNodes.end());
+}
+
+void HierarchicalPathfinder::addEntrance(Cluster& cluster, uint32_t tileIndex, BorderSide side, uint32_t otherTileIndex)
+{
+    // Tiles in the corner of a cluster can be an entrance for 2 borders
+    AbstractNode* entrance = nullptr;
+    for(AbstractNode& node : cluster.mNodes)
+    {
+        if(node.mTileIndex != tileIndex)
+            continue;
+
+        entrance = &node;
+        break;
+    }
+
+    if(entrance == nullptr)
+    {
+        cluster.mNodes.push_back(AbstractNode());
+        entrance = &cluster.mNodes.back();
+        entrance->mTileIndex = tileIndex;
+        entrance->mSides = 0;
+    }
+
+    entrance->mSides |= (1 << side);
+    // Crossing the border is a single step from the entrance
+    TerrainDistances distances = {{0.0, 0.0, 0.0}};
+    distances.mDistances[mTileTerrain[tileIndex]] = 1.0;
+    entrance->mInterEdges.push_back(AbstractEdge{otherTileIndex, distances, static_cast<uint8_t>(side)});
+}
+
+void HierarchicalPathfinder::rebuildBorder(uint32_t type, int clusterX, int clusterY, BorderSide side)
+{
+    AbstractGraph& graph = mGraphs[type];
+    Cluster& cluster = graph.mClusters[clusterIndex(clusterX, clusterY)];
+    bool isEast = (side == East);
+    Cluster& neighbor = isEast ? graph.mClusters[clusterIndex(clusterX + 1, clusterY)]
+        : graph.mClusters[clusterIndex(clusterX, clusterY + 1)];
+    BorderSide neighborSide = isEast ? West : North;
+
+    removeEntrances(cluster, side);
+    removeEntrances(neighbor, neighborSide);
+
+    // For the east border, we walk along the last column of the cluster. For the south one,
+    // along the last row
+    int borderStart = isEast ? clusterY * CLUSTER_SIZE : clusterX * CLUSTER_SIZE;
+    int borderEnd = isEast ? std::min(borderStart + CLUSTER_SIZE, mMapSizeY) : std::min(borderStart + CLUSTER_SIZE, mMapSizeX);
+    int line = isEast ? (clusterX + 1) * CLUSTER_SIZE - 1 : (clusterY + 1) * CLUSTER_SIZE - 1;
+    int openingStart = -1;
+    for(int pos = borderStart; pos <= borderEnd; ++pos)
+    {
+        bool isOpened = false;
+        if(pos < borderEnd)
+        {
+            if(isEast)
+                isOpened = isPassable(type, line, pos) && isPassable(type, line + 1, pos);
+            else
+                isOpened = isPassable(type, pos, line) && isPassable(type, pos, line + 1);
+        }
+
+        if(isOpened)
+        {
+            if(openingStart < 0)
+                openingStart = pos;
+            continue;
+        }
+
+        if(openingStart < 0)
+            continue;
+
+        int openingEnd = pos - 1;
+        std::vector<int> entrances;
+        if(openingEnd - openingStart + 1 < LONG_OPENING)
+        {
+            entrances.push_back((openingStart + openingEnd) / 2);
+        }
+        else
+        {
+            entrances.push_back(openingStart);
+            entrances.push_back(openingEnd);
+        }
+
+        for(int entrancePos : entrances)
+        {
+            uint32_t tileIndex;
+            uint32_t otherTileIndex;
+            if(isEast)
+            {
+                tileIndex = static_cast<uint32_t>(line + entrancePos * mMapSizeX);
+                otherTileIndex = tileIndex + 1;
+            }
+            else
+            {
+                tileIndex = static_cast<uint32_t>(entrancePos + line * mMapSizeX);
+                otherTileIndex = tileIndex + static_cast<uint32_t>(mMapSizeX);
+            }
+            addEntrance(cluster, tileIndex, side, otherTileIndex);
+            addEntrance(neighbor, otherTileIndex, neighborSide, tileIndex);
+        }
+        openingStart = -1;
+    }
+
+    if(isEast)
+        cluster.mDirtyEast = false;
+    else
+        cluster.mDirtySouth = false;
+
+    cluster.mDirtyIntra = true;
+    neighbor.mDirtyIntra = true;
+}
+
+void HierarchicalPathfinder::clusterDijkstra(uint32_t type, int clusterX, int clusterY, uint32_t sourceTileIndex, bool toSource)
+{
+    int minX = clusterX * CLUSTER_SIZE;
+    int minY = clusterY * CLUSTER_SIZE;
+    int maxX = std::min(minX + CLUSTER_SIZE, mMapSizeX) - 1;
+    int maxY = std::min(minY + CLUSTER_SIZE, mMapSizeY) - 1;
+
+    mLocalDist.assign(static_cast<uint32_t>(CLUSTER_SIZE * CLUSTER_SIZE), INFINITE_DIST);
+    mLocalTerrainDist.assign(static_cast<uint32_t>(CLUSTER_SIZE * CLUSTER_SIZE), TerrainDistances{{0.0, 0.0, 0.0}});
+    mLocalOpen.clear();
+
+    typedef std::pair<double, uint32_t> LocalEntry;
+    std::greater<LocalEntry> compare;
+    mLocalDist[localIndex(sourceTileIndex)] = 0.0;
+    mLocalOpen.push_back(LocalEntry(0.0, sourceTileIndex));
+    while(!mLocalOpen.empty())
+    {
+        std::pop_heap(mLocalOpen.begin(), mLocalOpen.end(), compare);
+        LocalEntry entry = mLocalOpen.back();
+        mLocalOpen.pop_back();
+        if(entry.first > mLocalDist[localIndex(entry.second)])
+            continue;
+
+        int currentX = static_cast<int>(entry.second) % mMapSizeX;
+        int currentY = static_cast<int>(entry.second) / mMapSizeX;
+        // Same moves as in the A* search: diagonals are only allowed if both adjacent tiles are passable
+        static const int MOVES[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+        bool areTilesPassable[4] = {false, false, false, false};
+        for(uint32_t i = 0; i < 8; ++i)
+        {
+            if((i == 4) && !(areTilesPassable[0] && areTilesPassable[2]))
+                continue;
+            if((i == 5) && !(areTilesPassable[0] && areTilesPassable[3]))
+                continue;
+            if((i == 6) && !(areTilesPassable[1] && areTilesPassable[2]))
+                continue;
+            if((i == 7) && !(areTilesPassable[1] && areTilesPassable[3]))
+                continue;
+
+            int xx = currentX + MOVES[i][0];
+            int yy = currentY + MOVES[i][1];
+            if((xx < minX) || (xx > maxX) || (yy < minY) || (yy > maxY))
+                continue;
+
+            if(!isPassable(type, xx, yy))
+                continue;
+
+            if(i < 4)
+                areTilesPassable[i] = true;
+
+            uint32_t tileIndex = static_cast<uint32_t>(xx + yy * mMapSizeX);
+            double step = (i < 4 ? 1.0 : 2.0);
+            double dist = entry.first + step;
+            double& localDist = mLocalDist[localIndex(tileIndex)];
+            if(dist >= localDist)
+                continue;
+
+            localDist = dist;
+            // The step is walked from the tile left. When going to the source, it is the reached tile
+            TerrainDistances& terrainDist = mLocalTerrainDist[localIndex(tileIndex)];
+            terrainDist = mLocalTerrainDist[localIndex(entry.second)];
+            terrainDist.mDistances[mTileTerrain[toSource ? tileIndex : entry.second]] += step;
+            mLocalOpen.push_back(LocalEntry(dist, tileIndex));
+            std::push_heap(mLocalOpen.begin(), mLocalOpen.end(), compare);
+        }
+    }
+}
+
+void HierarchicalPathfinder::computeIntraEdges(uint32_t type, int clusterX, int clusterY)
+{
+    Cluster& cluster = mGraphs[type].mClusters[clusterIndex(clusterX, clusterY)];
+    for(AbstractNode& node : cluster.mNodes)
+    {
+        node.mIntraEdges.clear();
+        clusterDijkstra(type, clusterX, clusterY, node.mTileIndex, false);
+        for(const AbstractNode& other : cluster.mNodes)
+        {
+            if(other.mTileIndex == node.mTileIndex)
+                continue;
+
+            if(mLocalDist[localIndex(other.mTileIndex)] == INFINITE_DIST)
+                continue;
+
+            node.mIntraEdges.push_back(AbstractEdge{other.mTileIndex, mLocalTerrainDist[localIndex(other.mTileIndex)], 0});
+        }
+    }
+    cluster.mDirtyIntra = false;
+}
+
+const HierarchicalPathfinder::AbstractNode* HierarchicalPathfinder::findNode(const Cluster& cluster, uint32_t tileIndex) const
+{
+    for(const AbstractNode& node : cluster.mNodes)
+    {
+        if(node.mTileIndex == tileIndex)
+            return &node;
+    }
+    return nullptr;
+}
+
+bool HierarchicalPathfinder::findPath(const TileContainer& tileContainer, PathfindingContext& context, Tile* start, Tile* destination,
+    const Creature& creature, FloodFillType floodFillType, Seat* seat, std::list<Tile*>& path)
+{
+    if((mMapSizeX != tileContainer.getMapSizeX()) ||
+       (mMapSizeY != tileContainer.getMapSizeY()) ||
+       mTilePassability.empty())
+    {
+        build(tileContainer);
+    }
+
+    uint32_t type = static_cast<uint32_t>(floodFillType);
+    if(type >= mGraphs.size())
+        return false;
+
+    // Same cost function as PathfindingContext: the distance divided by the speed on the tile left.
+    // The heuristic uses the fastest speed so that it never overestimates
+    const double speeds[NbTerrains] = {creature.getMoveSpeedGround(), creature.getMoveSpeedWater(), creature.getMoveSpeedLava()};
+    double maxSpeed = std::max(speeds[Ground], std::max(speeds[Water], speeds[Lava]));
+    if(maxSpeed <= 0.0)
+        return false;
+
+    repair(type);
+    const AbstractGraph& graph = mGraphs[type];
+
+    uint32_t startIndex = static_cast<uint32_t>(start->getX() + start->getY() * mMapSizeX);
+    uint32_t destIndex = static_cast<uint32_t>(destination->getX() + destination->getY() * mMapSizeX);
+    uint32_t startCluster = clusterIndexOfTile(startIndex);
+    uint32_t destCluster = clusterIndexOfTile(destIndex);
+    int destX = destination->getX();
+    int destY = destination->getY();
+
+    // Costs from the entrances of the destination cluster to the destination. Moves are symmetrical
+    // so we can compute them from the destination
+    clusterDijkstra(type, destination->getX() / CLUSTER_SIZE, destination->getY() / CLUSTER_SIZE, destIndex, true);
+    std::vector<std::pair<uint32_t, double>> destEntrances;
+    for(const AbstractNode& node : graph.mClusters[destCluster].mNodes)
+    {
+        if(mLocalDist[localIndex(node.mTileIndex)] == INFINITE_DIST)
+            continue;
+
+        double cost = computeCost(mLocalTerrainDist[localIndex(node.mTileIndex)], speeds);
+        if(cost != INFINITE_DIST)
+            destEntrances.push_back(std::pair<uint32_t, double>(node.mTileIndex, cost));
+    }
+
+    double bestCost = INFINITE_DIST;
+    int32_t bestLastEntrance = -1;
+    if((startCluster == destCluster) && (mLocalDist[localIndex(startIndex)] != INFINITE_DIST))
+        bestCost = computeCost(mLocalTerrainDist[localIndex(startIndex)], speeds);
+
+    if(destEntrances.empty() && (bestCost == INFINITE_DIST))
+        return false;
+
+    ++mGeneration;
+    if(mGeneration == 0)
+    {
+        std::fill(mAbstractGeneration.begin(), mAbstractGeneration.end(), 0);
+        mGeneration = 1;
+    }
+
+    typedef std::pair<double, uint32_t> OpenEntry;
+    std::greater<OpenEntry> compare;
+    std::vector<OpenEntry> openList;
+
+    // The start tile is linked to the entrances of its cluster
+    clusterDijkstra(type, start->getX() / CLUSTER_SIZE, start->getY() / CLUSTER_SIZE, startIndex, false);
+    for(const AbstractNode& node : graph.mClusters[startCluster].mNodes)
+    {
+        if(mLocalDist[localIndex(node.mTileIndex)] == INFINITE_DIST)
+            continue;
+
+        double cost = computeCost(mLocalTerrainDist[localIndex(node.mTileIndex)], speeds);
+        if(cost == INFINITE_DIST)
+            continue;
+
+        mAbstractGeneration[node.mTileIndex] = mGeneration;
+        mAbstractG[node.mTileIndex] = cost;
+        mAbstractParent[node.mTileIndex] = -1;
+        mAbstractClosed[node.mTileIndex] = false;
+        double h = manhattanDistance(static_cast<int>(node.mTileIndex) % mMapSizeX, static_cast<int>(node.mTileIndex) / mMapSizeX, destX, destY) / maxSpeed;
+        openList.push_back(OpenEntry(cost + h, node.mTileIndex));
+        std::push_heap(openList.begin(), openList.end(), compare);
+    }
+
+    while(!openList.empty())
+    {
+        std::pop_heap(openList.begin(), openList.end(), compare);
+        OpenEntry entry = openList.back();
+        openList.pop_back();
+
+        // Since the heuristic never overestimates, no better path can be found
+        if(entry.first >= bestCost)
+            break;
+
+        uint32_t current = entry.second;
+        if(mAbstractClosed[current])
+            continue;
+
+        mAbstractClosed[current] = true;
+        double currentG = mAbstractG[current];
+
+        uint32_t currentCluster = clusterIndexOfTile(current);
+        if(currentCluster == destCluster)
+        {
+            for(const std::pair<uint32_t, double>& destEntrance : destEntrances)
+            {
+                if(destEntrance.first != current)
+                    continue;
+
+                if(currentG + destEntrance.second < bestCost)
+                {
+                    bestCost = currentG + destEntrance.second;
+                    bestLastEntrance = static_cast<int32_t>(current);
+                }
+                break;
+            }
+        }
+
+        const AbstractNode* node = findNode(graph.mClusters[currentCluster], current);
+        if(node == nullptr)
+            continue;
+
+        for(const std::vector<AbstractEdge>* edges : {&node->mInterEdges, &node->mIntraEdges})
+        {
+            for(const AbstractEdge& edge : *edges)
+            {
+                double edgeCost = computeCost(edge.mDistances, speeds);
+                if(edgeCost == INFINITE_DIST)
+                    continue;
+
+                double g = currentG + edgeCost;
+                uint32_t next = edge.mTileIndex;
+                if(mAbstractGeneration[next] == mGeneration)
+                {
+                    if(mAbstractClosed[next] || (g >= mAbstractG[next]))
+                        continue;
+                }
+                else
+                {
+                    mAbstractGeneration[next] = mGeneration;
+                    mAbstractClosed[next] = false;
+                }
+
+                mAbstractG[next] = g;
+                mAbstractParent[next] = static_cast<int32_t>(current);
+                double h = manhattanDistance(static_cast<int>(next) % mMapSizeX, static_cast<int>(next) / mMapSizeX, destX, destY) / maxSpeed;
+                openList.push_back(OpenEntry(g + h, next));
+                std::push_heap(openList.begin(), openList.end(), compare);
+            }
+        }
+    }
+
+    if(bestCost == INFINITE_DIST)
+        return false;
+
+    // We build the list of waypoints. If bestLastEntrance is not set, the best path
+    // is inside the cluster
+    std::vector<uint32_t> waypoints;
+    for(int32_t index = bestLastEntrance; index >= 0; index = mAbstractParent[index])
+        waypoints.push_back(static_cast<uint32_t>(index));
+    if(waypoints.empty() || (waypoints.back() != startIndex))
+        waypoints.push_back(startIndex);
+    std::reverse(waypoints.begin(), waypoints.end());
+    if(waypoints.back() != destIndex)
+        waypoints.push_back(destIndex);
+
+    // Each step is refined for the creature with a search restricted to the cluster it is in (or to the
+    // 2 tiles for steps crossing a border)
+    std::list<Tile*> result;
+    for(uint32_t i = 0; i + 1 < waypoints.size(); ++i)
+    {
+        int x1 = static_cast<int>(waypoints[i]) % mMapSizeX;
+        int y1 = static_cast<int>(waypoints[i]) / mMapSizeX;
+        int x2 = static_cast<int>(waypoints[i + 1]) % mMapSizeX;
+        int y2 = static_cast<int>(waypoints[i + 1]) / mMapSizeX;
+        PathfindingBounds bounds;
+        if(clusterIndexOfTile(waypoints[i]) == clusterIndexOfTile(waypoints[i + 1]))
+        {
+            bounds.mMinX = (x1 / CLUSTER_SIZE) * CLUSTER_SIZE;
+            bounds.mMinY = (y1 / CLUSTER_SIZE) * CLUSTER_SIZE;
+            bounds.mMaxX = bounds.mMinX + CLUSTER_SIZE - 1;
+            bounds.mMaxY = bounds.mMinY + CLUSTER_SIZE - 1;
+        }
+        else
+        {
+            bounds.mMinX = std::min(x1, x2);
+            bounds.mMinY = std::min(y1, y2);
+            bounds.mMaxX = std::max(x1, x2);
+            bounds.mMaxY = std::max(y1, y2);
+        }
+
+        std::list<Tile*> step;
+        if(!context.findPath(tileContainer, tileContainer.getTile(x1, y1), tileContainer.getTile(x2, y2),
+            creature, seat, false, step, &bounds))
+        {
+            return false;
+        }
+
+        if(!result.empty())
+            step.pop_front();
+
+        result.splice(result.end(), step);
+    }
+
+    path.swap(result);
+    return true;
+}
@@ -0,0 +1,210 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HIERARCHICALPATHFINDER_H
+#define HIERARCHICALPATHFINDER_H
+
+#include <cstdint>
+#include <list>
+#include <utility>
+#include <vector>
+
+class Creature;
+class PathfindingContext;
+class Seat;
+class Tile;
+class TileContainer;
+
+enum class FloodFillType;
+
+/*! \brief Abstract graph used to plan long paths (HPA*).
+ *
+ * The map is cut in square clusters. Where two adjacent clusters share passable border tiles,
+ * entrances are created and linked together. Entrances of the same cluster are linked by
+ * the shortest path between them inside the cluster. There is one graph per FloodFillType
+ * since each of them has its own passable tiles.
+ * The edges remember the distance walked on each terrain (ground, water and lava). That way,
+ * their cost for a given creature is computed like in PathfindingContext: the distance divided
+ * by the creature speed on the tile left. The path linking 2 entrances is chosen as the shortest
+ * one in tiles, which may not be the fastest one for every creature.
+ * A long path is first searched on this graph. Then, each step is refined with a regular
+ * A* restricted to the cluster it crosses, which keeps every search small.
+ *
+ * The graph is built on the first query. When a tile passability changes, notifyTileChanged
+ * marks the concerned cluster and borders as dirty and they are rebuilt on the next query.
+ * Passability here does not depend on seats (doors are considered as opened). If a refined
+ * step cannot be walked by the creature, findPath fails and the caller should fall back on a
+ * full search.
+ * See: http://webdocs.cs.ualberta.ca/~mmueller/ps/hpastar.pdf
+ */
+class HierarchicalPathfinder
+{
+public:
+    HierarchicalPathfinder();
+
+    //! \brief Size of the side of a cluster in tiles
+    static const int CLUSTER_SIZE;
+
+    //! \brief Paths shorter than this manhattan distance are not worth an abstract search
+    static const int MIN_DISTANCE;
+
+    //! \brief Forgets the abstract graphs. They will be rebuilt from scratch on the next query
+    void clear();
+
+    //! \brief Should be called when something that may change the tile passability happens
+    //! (tile dug, bridge built or removed, ...). If the passability changed for some
+    //! FloodFillType, the corresponding clusters will be repaired on the next query.
+    void notifyTileChanged(const Tile& tile);
+
+    //! \brief Computes a path between start and destination using the graph corresponding to floodFillType
+    //! and refining it for the given creature. Returns true and fills path if a path could be found.
+    //! Returns false if no path was found. In this case, the caller should use a full search because
+    //! a path may exist anyway (for example if passability is specific to the creature seat).
+    bool findPath(const TileContainer& tileContainer, PathfindingContext& context, Tile* start, Tile* destination,
+        const Creature& creature, FloodFillType floodFillType, Seat* seat, std::list<Tile*>& path);
+
+private:
+    enum BorderSide
+    {
+        West = 0,
+        East = 1,
+        North = 2,
+        South = 3
+    };
+
+    enum Terrain
+    {
+        Ground = 0,
+        Water = 1,
+        Lava = 2,
+        NbTerrains = 3
+    };
+
+    //! \brief Distance walked from tiles of each Terrain
+    struct TerrainDistances
+    {
+        double mDistances[NbTerrains];
+    };
+
+    struct AbstractEdge
+    {
+        uint32_t mTileIndex;
+        TerrainDistances mDistances;
+        //! \brief For inter cluster edges, side of the border crossed. Unused for intra cluster edges
+        uint8_t mSide;
+    };
+
+    struct AbstractNode
+    {
+        uint32_t mTileIndex;
+        //! \brief Bitmask of the BorderSide this entrance belongs to
+        uint8_t mSides;
+        std::vector<AbstractEdge> mInterEdges;
+        std::vector<AbstractEdge> mIntraEdges;
+    };
+
+    struct Cluster
+    {
+        std::vector<AbstractNode> mNodes;
+        //! \brief The border with the cluster on the east/south has to be rebuilt
+        bool mDirtyEast;
+        bool mDirtySouth;
+        //! \brief Intra cluster edges have to be recomputed
+        bool mDirtyIntra;
+    };
+
+    struct AbstractGraph
+    {
+        std::vector<Cluster> mClusters;
+        //! \brief At least one cluster has to be repaired
+        bool mHasDirtyClusters;
+    };
+
+    //! \brief Builds the passability of every tile and marks every cluster as dirty
+    void build(const TileContainer& tileContainer);
+
+    //! \brief Rebuilds the dirty borders and intra cluster edges for the given type
+    void repair(uint32_t type);
+
+    void rebuildBorder(uint32_t type, int clusterX, int clusterY, BorderSide side);
+    void removeEntrances(Cluster& cluster, BorderSide side);
+    void addEntrance(Cluster& cluster, uint32_t tileIndex, BorderSide side, uint32_t otherTileIndex);
+    void computeIntraEdges(uint32_t type, int clusterX, int clusterY);
+
+    //! \brief Dijkstra restricted to the given cluster from the given tile. The distances are
+    //! stored in mLocalDist and the distances per terrain in mLocalTerrainDist, indexed by the
+    //! position in the cluster. If toSource is true, mLocalTerrainDist is computed for the paths
+    //! going from each tile to the source tile instead of from the source tile
+    void clusterDijkstra(uint32_t type, int clusterX, int clusterY, uint32_t sourceTileIndex, bool toSource);
+
+    //! \brief Computes the passability mask (one bit per FloodFillType) of the given tile
+    static uint8_t computePassability(const Tile& tile);
+
+    //! \brief Computes the Terrain of the given tile
+    static uint8_t computeTerrain(const Tile& tile);
+
+    //! \brief Cost of walking the given distances with the given speeds (indexed by Terrain)
+    static double computeCost(const TerrainDistances& distances, const double* speeds);
+
+    inline bool isPassable(uint32_t type, int x, int y) const
+    { return (mTilePassability[x + y * mMapSizeX] & (1 << type)) != 0; }
+
+    inline uint32_t clusterIndex(int clusterX, int clusterY) const
+    { return static_cast<uint32_t>(clusterX + clusterY * mNbClustersX); }
+
+    inline uint32_t clusterIndexOfTile(uint32_t tileIndex) const
+    {
+        return clusterIndex((static_cast<int>(tileIndex) % mMapSizeX) / CLUSTER_SIZE,
+            (static_cast<int>(tileIndex) / mMapSizeX) / CLUSTER_SIZE);
+    }
+
+    inline uint32_t localIndex(uint32_t tileIndex) const
+    {
+        return static_cast<uint32_t>((static_cast<int>(tileIndex) % mMapSizeX) % CLUSTER_SIZE
+            + ((static_cast<int>(tileIndex) / mMapSizeX) % CLUSTER_SIZE) * CLUSTER_SIZE);
+    }
+
+    const AbstractNode* findNode(const Cluster& cluster, uint32_t tileIndex) const;
+
+    int mMapSizeX;
+    int mMapSizeY;
+    int mNbClustersX;
+    int mNbClustersY;
+
+    //! \brief Passability mask per tile (one bit per FloodFillType)
+    std::vector<uint8_t> mTilePassability;
+
+    //! \brief Terrain per tile
+    std::vector<uint8_t> mTileTerrain;
+
+    std::vector<AbstractGraph> mGraphs;
+
+    //! \brief Scratch memory for cluster searches
+    std::vector<double> mLocalDist;
+    std::vector<TerrainDistances> mLocalTerrainDist;
+    std::vector<std::pair<double, uint32_t>> mLocalOpen;
+
+    //! \brief Scratch memory for the abstract search, indexed by tile index and
+    //! invalidated with mGeneration
+    std::vector<uint32_t> mAbstractGeneration;
+    std::vector<double> mAbstractG;
+    std::vector<int32_t> mAbstractParent;
+    std::vector<bool> mAbstractClosed;
+    uint32_t mGeneration;
+};
+
+#endif // HIERARCHICALPATHFINDER_H
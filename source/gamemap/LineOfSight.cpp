@@ -0,0 +1,444 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/LineOfSight.h"
+
+#include <algorithm>
+
+// We will process the 1/8 parts of the square in this order (c being the center):
+// 514
+// 2c0
+// 637
+const int LineOfSight::OCTANT_TRANSFORMS[8][4] =
+{
+    { 1,  0,  0,  1},
+    { 0,  1, -1,  0},
+    {-1,  0,  0, -1},
+    { 0, -1,  1,  0},
+    { 0,  1,  1,  0},
+    { 1,  0,  0, -1},
+    { 0, -1, -1,  0},
+    {-1,  0,  0,  1}
+};
+
+const uint32_t LineOfSight::MAX_MEMO_ENTRIES = 4096;
+
+void TileDistance::computeTileDistances(double coefNorth, double coefSouth, const TileDistance& tileDistance,
+    uint32_t indexTileDistance)
+{
+    // A tile can only hide tiles behind (x > tile.x and y > tile.y)
+    if(tileDistance.getDiffX() < getDiffX())
+        return;
+    if(tileDistance.getDiffY() < getDiffY())
+        return;
+
+    // We don't want a tile to hide itself
+    if((tileDistance.getDiffX() == getDiffX()) &&
+       (tileDistance.getDiffY() == getDiffY()))
+    {
+        return;
+    }
+
+    if(getType() == TileDistance::TileDistanceType::Horizontal)
+    {
+        // For horizontal tiles, we hide following tiles (x > tile.x). But we process
+        // north tiles normally
+        if(tileDistance.getType() == TileDistance::TileDistanceType::Horizontal)
+        {
+            addHiddenTileSouth(indexTileDistance, 1.0);
+            return;
+        }
+
+        double xTileDeb = static_cast<double>(tileDistance.getDiffX()) - 0.5;
+        double xTileEnd = xTileDeb + 1.0;
+        double yTileDeb = static_cast<double>(tileDistance.getDiffY()) - 0.5;
+        double yTileEnd = yTileDeb + 1.0;
+        double yHideDebNorth = coefNorth * xTileDeb;
+        double yHideEndNorth = coefNorth * xTileEnd;
+
+        // If the tile is over the North ray, it is not hidden
+        if(yHideEndNorth <= yTileDeb)
+            return;
+
+        // We check which part of the tile is hidden
+        if((yHideDebNorth >= yTileDeb) &&
+           (yHideEndNorth <= yTileEnd))
+        {
+            // The ray hits the left side of the tile and the right side.
+            // The south part is partially hidden
+            double hiddenArea = (yHideEndNorth - yHideDebNorth) / 2.0;
+            hiddenArea += yHideDebNorth - yTileDeb;
+            addHiddenTileSouth(indexTileDistance, hiddenArea);
+        }
+        else if((yHideDebNorth < yTileDeb) &&
+                (yHideEndNorth > yTileDeb))
+        {
+            // The ray hits the bottom side of the tile but hits the right side. We compute
+            // the south visible part
+            double xHit = yTileDeb / coefNorth;
+            double hiddenArea = (yHideEndNorth - yTileDeb) * (xTileEnd - xHit) / 2.0;
+            addHiddenTileSouth(indexTileDistance, hiddenArea);
+        }
+        else if((yHideDebNorth < yTileEnd) &&
+                (yHideEndNorth > yTileEnd))
+        {
+            // The ray hits the left side of the tile but is over the right side. We compute
+            // the hidden part on north.
+            double xHit = yTileEnd / coefNorth;
+            double visibleArea = (yTileEnd - yHideDebNorth) * (xHit - xTileDeb) / 2.0;
+            addHiddenTileSouth(indexTileDistance, 1.0 - visibleArea);
+        }
+        else
+        {
+            // The entire tile is hidden
+            addHiddenTileSouth(indexTileDistance, 1.0);
+        }
+
+        return;
+    }
+
+    double xTileDeb = static_cast<double>(tileDistance.getDiffX()) - 0.5;
+    double xTileEnd = xTileDeb + 1.0;
+    double yTileDeb = static_cast<double>(tileDistance.getDiffY()) - 0.5;
+    double yTileEnd = yTileDeb + 1.0;
+
+    // We check if the current tile is hidden by the tile. To consider that the
+    // tile is hidden by the south, as we know the angle will be between 0 and 45 degrees,
+    // we consider that the tile has to be hit by the ray passing through the hiding tile
+    // on the left side of the tile (otherwise, the hidden part will be too small).
+    double yHideDebSouth = coefSouth * xTileDeb;
+    double yHideEndSouth = coefSouth * xTileEnd;
+    double yHideDebNorth = coefNorth * xTileDeb;
+    double yHideEndNorth = coefNorth * xTileEnd;
+    // We check if at least a part of the tile is hidden
+    if((yHideDebSouth < yTileEnd) &&
+       (yHideEndNorth > yTileDeb))
+    {
+        // At least a part of this tile is hidden
+        if((yHideDebSouth >= yTileDeb) &&
+           (yHideEndSouth <= yTileEnd))
+        {
+            // The ray hits the left side of the tile and the right side.
+            // The south part is partially hidden
+            // The visible part is composed from a square between the tile inferior part and
+            // the triangle made by the ray
+            double visibleArea = (yHideEndSouth - yHideDebSouth) / 2.0;
+            visibleArea += yHideDebSouth - yTileDeb;
+            addHiddenTileNorth(indexTileDistance, 1.0 - visibleArea);
+        }
+        else if((yHideDebSouth < yTileDeb) &&
+                (yHideEndSouth > yTileDeb))
+        {
+            // The ray hits the bottom side of the tile but hits the right side. We compute
+            // the south visible part
+            double xHit = yTileDeb / coefSouth;
+            double visibleArea = (yHideEndSouth - yTileDeb) * (xTileEnd - xHit) / 2.0;
+            addHiddenTileNorth(indexTileDistance, 1.0 - visibleArea);
+        }
+        else if((yHideDebSouth < yTileEnd) &&
+                (yHideEndSouth > yTileEnd))
+        {
+            // The ray hits the left side of the tile but is over the right side. We compute
+            // the hidden part on north.
+            double xHit = yTileEnd / coefSouth;
+            double hiddenArea = (yTileEnd - yHideDebSouth) * (xHit - xTileDeb) / 2.0;
+            addHiddenTileNorth(indexTileDistance, hiddenArea);
+
+        }
+        else if((yHideDebNorth >= yTileDeb) &&
+           (yHideEndNorth <= yTileEnd))
+        {
+            double hiddenArea = (yHideEndNorth - yHideDebNorth) / 2.0;
+            hiddenArea += yHideDebNorth - yTileDeb;
+            addHiddenTileSouth(indexTileDistance, hiddenArea);
+        }
+        else if((yHideDebNorth < yTileDeb) &&
+                (yHideEndNorth > yTileDeb))
+        {
+            // The ray hits the bottom side of the tile but hits the right side. We compute
+            // the south visible part
+            double xHit = yTileDeb / coefNorth;
+            double hiddenArea = (yHideEndNorth - yTileDeb) * (xTileEnd - xHit) / 2.0;
+            addHiddenTileSouth(indexTileDistance, hiddenArea);
+        }
+        else if((yHideDebNorth < yTileEnd) &&
+                (yHideEndNorth > yTileEnd))
+        {
+            // The ray hits the left side of the tile but is over the right side. We compute
+            // the hidden part on north.
+            double xHit = yTileEnd / coefNorth;
+            double visibleArea = (yTileEnd - yHideDebNorth) * (xHit - xTileDeb) / 2.0;
+            addHiddenTileSouth(indexTileDistance, 1.0 - visibleArea);
+        }
+        else
+        {
+            // The entire tile is hidden
+            addHiddenTileSouth(indexTileDistance, 1.0);
+        }
+    }
+}
+
+static bool sortByDistSquared(const TileDistance& tileDist1, const TileDistance& tileDist2)
+{
+    return tileDist1.getDistSquared() < tileDist2.getDistSquared();
+}
+
+LineOfSight::LineOfSight(int initTileDistance) :
+    mTileDistanceComputed(0),
+    mIsMemoEnabled(true)
+{
+    buildTileDistance(initTileDistance);
+}
+
+void LineOfSight::buildTileDistance(int distance)
+{
+    if(mTileDistanceComputed >= distance)
+        return;
+
+    // We want to be able to fill a vector of tiles sorted beginning with the closest tile. If we look a grid (each letter
+    // represents a tile at the same distance from the center: a):
+    // jihghij
+    // ifedefi
+    // hecbceh
+    // gdbabdg
+    // hecbceh
+    // ifedefi
+    // jihghij
+    // We can see that there are 3 kind of tiles:
+    // - Vertical/Horizontal tiles (abdg): at each distance, there are 4 of them
+    // - Diagonal tiles (acfj): at each distance, there are 4 of them
+    // - Other tiles (ehi...): at each distance, there are 8 of them
+    // Moreover, we can see a symmetry. We can compute all tiles by computing only 1/8 tiles:
+    //    j
+    //   fi
+    //  ceh
+    // abdg
+
+    // If we compute only the minimum tiles needed, we have no vertical tiles (since each of them can be deduced from the horizontal)
+    // To compute tiles easily, we will compute the 1/8 tiles until distance. Then, we will sort the tiles to begin with
+    // closest distance until farthest
+    mTileDistance.clear();
+    for(int y = 0; y <= distance; ++y)
+    {
+        for(int x = y; x <= distance; ++x)
+        {
+            TileDistance::TileDistanceType type;
+            if(y == 0)
+            {
+                type = TileDistance::TileDistanceType::Horizontal;
+            }
+            else if(x == y)
+            {
+                type = TileDistance::TileDistanceType::Diagonal;
+            }
+            else
+            {
+                type = TileDistance::TileDistanceType::Other;
+            }
+            int distSquared = x * x + y * y;
+            mTileDistance.push_back(TileDistance(x, y, type, distSquared));
+        }
+    }
+
+    std::sort(mTileDistance.begin(), mTileDistance.end(), sortByDistSquared);
+
+    // We have filled the tile distance vector. Now, we fill how each tile hides the
+    // other ones when they mask vision to help calculate visible tiles
+    for(TileDistance& tileDistance : mTileDistance)
+    {
+        // We don't process the first tile
+        if(tileDistance.getDiffX() == 0 && tileDistance.getDiffY() == 0)
+            continue;
+
+        // Other tiles can hide with their down side and their up side other tiles
+        // or diagonal tiles (but not Horizontal tiles)
+        // We compute the tiles hidden from the south. In this case, only tiles with
+        // x > tile.x can be hidden
+        double coefNorth = (static_cast<double>(tileDistance.getDiffY()) + 0.5) / (static_cast<double>(tileDistance.getDiffX()) - 0.5);
+        double coefSouth = (static_cast<double>(tileDistance.getDiffY()) - 0.5) / (static_cast<double>(tileDistance.getDiffX()) + 0.5);
+        for(uint32_t index = 0; index < mTileDistance.size(); ++index)
+        {
+            const TileDistance& tileDistance2 = mTileDistance[index];
+            tileDistance.computeTileDistances(coefNorth, coefSouth, tileDistance2, index);
+        }
+    }
+
+    mTileDistanceComputed = distance;
+
+    // Tiles at the same distance may have been sorted differently. The stencils have to be computed again
+    mStencils.clear();
+    mMemo.clear();
+}
+
+const LineOfSight::Stencil& LineOfSight::getStencil(int radius)
+{
+    if(radius < 0)
+        radius = 0;
+
+    if(radius > mTileDistanceComputed)
+        buildTileDistance(radius);
+
+    if(radius >= static_cast<int>(mStencils.size()))
+        mStencils.resize(radius + 1);
+
+    Stencil& stencil = mStencils[radius];
+    if(stencil.mNbTileDistances > 0)
+        return stencil;
+
+    // mTileDistance is sorted by distance so the tiles within radius are at the beginning
+    int radiusSquared = radius * radius;
+    uint32_t nbTiles = 0;
+    while((nbTiles < mTileDistance.size()) && (mTileDistance[nbTiles].getDistSquared() <= radiusSquared))
+        ++nbTiles;
+
+    // mTileDistance might be bigger than the stencil because it can include tiles
+    // farther than radius (for example if sight < computedSight). We only keep the hidden
+    // tiles within radius
+    stencil.mHiddenNorthBegin.reserve(nbTiles + 1);
+    stencil.mHiddenSouthBegin.reserve(nbTiles + 1);
+    for(uint32_t i = 0; i < nbTiles; ++i)
+    {
+        stencil.mHiddenNorthBegin.push_back(static_cast<uint32_t>(stencil.mHiddenNorth.size()));
+        for(const std::pair<uint32_t, double>& p : mTileDistance[i].getHiddenTilesNorth())
+        {
+            if(p.first < nbTiles)
+                stencil.mHiddenNorth.push_back(p);
+        }
+
+        stencil.mHiddenSouthBegin.push_back(static_cast<uint32_t>(stencil.mHiddenSouth.size()));
+        for(const std::pair<uint32_t, double>& p : mTileDistance[i].getHiddenTilesSouth())
+        {
+            if(p.first < nbTiles)
+                stencil.mHiddenSouth.push_back(p);
+        }
+    }
+    stencil.mHiddenNorthBegin.push_back(static_cast<uint32_t>(stencil.mHiddenNorth.size()));
+    stencil.mHiddenSouthBegin.push_back(static_cast<uint32_t>(stencil.mHiddenSouth.size()));
+    stencil.mNbTileDistances = nbTiles;
+    return stencil;
+}
+
+const std::vector<std::pair<int, int>>& LineOfSight::computeVisibleTiles(uint32_t centerKey, int radius,
+    const Stencil& stencil)
+{
+    uint32_t nbTiles = stencil.mNbTileDistances;
+    uint64_t hash = 0;
+    std::pair<uint32_t, int> memoKey(centerKey, radius);
+    if(mIsMemoEnabled)
+    {
+        // FNV-1a hash of the tiles around
+        hash = 14695981039346656037ULL;
+        for(TileState state : mTileStates)
+        {
+            hash ^= static_cast<uint64_t>(state);
+            hash *= 1099511628211ULL;
+        }
+
+        std::map<std::pair<uint32_t, int>, MemoEntry>::const_iterator it = mMemo.find(memoKey);
+        if((it != mMemo.end()) &&
+           (it->second.mHash == hash) &&
+           (it->second.mTileStates == mTileStates))
+        {
+            return it->second.mVisibleTiles;
+        }
+    }
+
+    // We apply the tiles hiding vision in each part of the square
+    mHiddenValuesNorth.assign(nbTiles * 8, 0.0);
+    mHiddenValuesSouth.assign(nbTiles * 8, 0.0);
+    for(uint32_t k = 0; k < 8; ++k)
+    {
+        uint32_t offset = k * nbTiles;
+        for(uint32_t i = 0; i < nbTiles; ++i)
+        {
+            if(mTileStates[offset + i] != TileState::blocksVision)
+                continue;
+
+            // We only keep the highest hidden value
+            for(uint32_t h = stencil.mHiddenNorthBegin[i]; h < stencil.mHiddenNorthBegin[i + 1]; ++h)
+            {
+                const std::pair<uint32_t, double>& p = stencil.mHiddenNorth[h];
+                double& value = mHiddenValuesNorth[offset + p.first];
+                value = std::max(value, p.second);
+            }
+            for(uint32_t h = stencil.mHiddenSouthBegin[i]; h < stencil.mHiddenSouthBegin[i + 1]; ++h)
+            {
+                const std::pair<uint32_t, double>& p = stencil.mHiddenSouth[h];
+                double& value = mHiddenValuesSouth[offset + p.first];
+                value = std::max(value, p.second);
+            }
+        }
+    }
+
+    // Now, we process all the tiles. Note that horizontal tiles are common for 2 consecutive
+    // parts and that diagonal tiles should be merged
+    mVisibleTiles.clear();
+    for(uint32_t i = 0; i < nbTiles; ++i)
+    {
+        const TileDistance& tileDist = mTileDistance[i];
+        for(uint32_t k = 0; k < 8; ++k)
+        {
+            uint32_t index = k * nbTiles + i;
+            if(mTileStates[index] == TileState::outsideMap)
+                continue;
+
+            // We avoid adding several times the center tile
+            if((k > 0) && (tileDist.getDistSquared() == 0))
+                continue;
+
+            // Because horizontal tiles are common, we don't process them for the 4 last parts.
+            // Diagonal tiles need to be merged (because south hiding and north hiding are not
+            // computed within the same part). They will be processed for k < 4
+            if((k > 3) &&
+               ((tileDist.getType() == TileDistance::TileDistanceType::Horizontal) ||
+                (tileDist.getType() == TileDistance::TileDistanceType::Diagonal)))
+            {
+                continue;
+            }
+
+            double hiddenNorth = mHiddenValuesNorth[index];
+            double hiddenSouth = mHiddenValuesSouth[index];
+            if(tileDist.getType() == TileDistance::TileDistanceType::Diagonal)
+            {
+                // Because they are inverted, south hidden value becomes north and vice-versa
+                uint32_t index2 = (k + 4) * nbTiles + i;
+                hiddenNorth = std::max(hiddenNorth, mHiddenValuesSouth[index2]);
+                hiddenSouth = std::max(hiddenSouth, mHiddenValuesNorth[index2]);
+            }
+
+            if((hiddenNorth + hiddenSouth) > 0.5)
+                continue;
+
+            const int* transform = OCTANT_TRANSFORMS[k];
+            mVisibleTiles.push_back(std::pair<int, int>(
+                transform[0] * tileDist.getDiffX() + transform[1] * tileDist.getDiffY(),
+                transform[2] * tileDist.getDiffX() + transform[3] * tileDist.getDiffY()));
+        }
+    }
+
+    if(!mIsMemoEnabled)
+        return mVisibleTiles;
+
+    if((mMemo.size() >= MAX_MEMO_ENTRIES) && (mMemo.count(memoKey) == 0))
+        mMemo.clear();
+
+    MemoEntry& entry = mMemo[memoKey];
+    entry.mHash = hash;
+    entry.mTileStates = mTileStates;
+    entry.mVisibleTiles = mVisibleTiles;
+    return mVisibleTiles;
+}
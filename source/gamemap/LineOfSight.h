@@ -0,0 +1,220 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LINEOFSIGHT_H
+#define LINEOFSIGHT_H
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+//! \brief Tile at (diffX, diffY) from the center of the 1/8 of the square computed by LineOfSight
+//! with the tiles it hides when it blocks vision
+class TileDistance
+{
+public:
+    enum TileDistanceType
+    {
+        Horizontal,
+        Diagonal,
+        Other
+    };
+
+    TileDistance(int diffX, int diffY, TileDistanceType type, int distSquared):
+        mDiffX(diffX),
+        mDiffY(diffY),
+        mType(type),
+        mDistSquared(distSquared)
+    {
+    }
+
+    inline int getDiffX() const
+    { return mDiffX; }
+
+    inline int getDiffY() const
+    { return mDiffY; }
+
+    inline TileDistanceType getType() const
+    { return mType; }
+
+    inline int getDistSquared() const
+    { return mDistSquared; }
+
+    void computeTileDistances(double coefNorth, double coefSouth, const TileDistance& tileDistance,
+        uint32_t indexTileDistance);
+
+    const std::vector<std::pair<uint32_t, double>>& getHiddenTilesNorth() const
+    {
+        return mHiddenTilesNorth;
+    }
+
+    const std::vector<std::pair<uint32_t, double>>& getHiddenTilesSouth() const
+    {
+        return mHiddenTilesSouth;
+    }
+
+private:
+    void addHiddenTileNorth(uint32_t indexTile, double hiddenPercent)
+    {
+        mHiddenTilesNorth.push_back(std::pair<uint32_t, double>(indexTile, hiddenPercent));
+    }
+
+    void addHiddenTileSouth(uint32_t indexTile, double hiddenPercent)
+    {
+        mHiddenTilesSouth.push_back(std::pair<uint32_t, double>(indexTile, hiddenPercent));
+    }
+
+    int mDiffX;
+    int mDiffY;
+    TileDistanceType mType;
+    int mDistSquared;
+    std::vector<std::pair<uint32_t, double>> mHiddenTilesNorth;
+    std::vector<std::pair<uint32_t, double>> mHiddenTilesSouth;
+};
+
+/*! \brief Computes the tiles visible from a center tile. It does not know about the map: the caller
+ * gives the state of the tiles around the center (TileState) and gets back the offsets of the visible
+ * tiles.
+ *
+ * For each radius, the tiles hidden by each tile of the 1/8 square are stored in a stencil so that
+ * computing the vision only walks flat arrays. The buffers used during the computation are kept
+ * between calls. The last result for each center and radius is also kept with the state of the tiles
+ * around: if the same center is computed again with the same tiles around (like creatures sharing a
+ * tile in a room), the result is reused.
+ * Note that this class is not thread safe.
+ */
+class LineOfSight
+{
+public:
+    enum class TileState : uint8_t
+    {
+        outsideMap,
+        permitsVision,
+        blocksVision
+    };
+
+    LineOfSight(int initTileDistance);
+
+    //! \brief Fills mTileDistance up to the given distance if not already done
+    void buildTileDistance(int distance);
+
+    inline int getTileDistanceComputed() const
+    { return mTileDistanceComputed; }
+
+    //! \brief 1/8 of the square around the center sorted from the closest tile to the furthest
+    inline const std::vector<TileDistance>& getTileDistances() const
+    { return mTileDistance; }
+
+    //! \brief Enables the memo of the last result computed for each center and radius
+    inline void setMemoEnabled(bool enabled)
+    {
+        mIsMemoEnabled = enabled;
+        mMemo.clear();
+    }
+
+    //! \brief Forgets every memorized result
+    inline void clearMemo()
+    { mMemo.clear(); }
+
+    /*! \brief Returns the offsets (diffX, diffY) from the center of the visible tiles within radius, ordered from
+     * the closest to the furthest.
+     * getTileState(diffX, diffY) should return the state of the tile at the given offset from the center.
+     * centerKey identifies the center (for example the tile index). It is only used for the memo.
+     * The returned vector is valid until the next call.
+     */
+    template<typename GetTileState>
+    const std::vector<std::pair<int, int>>& computeVisibleTiles(uint32_t centerKey, int radius,
+        GetTileState getTileState)
+    {
+        const Stencil& stencil = getStencil(radius);
+        uint32_t nbTiles = stencil.mNbTileDistances;
+        mTileStates.resize(nbTiles * 8);
+        for(uint32_t k = 0; k < 8; ++k)
+        {
+            const int* transform = OCTANT_TRANSFORMS[k];
+            TileState* states = &mTileStates[k * nbTiles];
+            for(uint32_t i = 0; i < nbTiles; ++i)
+            {
+                const TileDistance& tileDist = mTileDistance[i];
+                int diffX = transform[0] * tileDist.getDiffX() + transform[1] * tileDist.getDiffY();
+                int diffY = transform[2] * tileDist.getDiffX() + transform[3] * tileDist.getDiffY();
+                states[i] = getTileState(diffX, diffY);
+            }
+        }
+
+        return computeVisibleTiles(centerKey, radius, stencil);
+    }
+
+private:
+    //! \brief Tiles hidden by each tile within a given radius. The tiles hidden by the tile at index i in
+    //! mTileDistance are in mHiddenNorth/South between mHiddenNorth/SouthBegin[i] and mHiddenNorth/SouthBegin[i + 1]
+    struct Stencil
+    {
+        Stencil() :
+            mNbTileDistances(0)
+        {}
+
+        uint32_t mNbTileDistances;
+        std::vector<uint32_t> mHiddenNorthBegin;
+        std::vector<std::pair<uint32_t, double>> mHiddenNorth;
+        std::vector<uint32_t> mHiddenSouthBegin;
+        std::vector<std::pair<uint32_t, double>> mHiddenSouth;
+    };
+
+    struct MemoEntry
+    {
+        uint64_t mHash;
+        std::vector<TileState> mTileStates;
+        std::vector<std::pair<int, int>> mVisibleTiles;
+    };
+
+    //! \brief For each of the 8 parts of the square, how to compute the offset from the center
+    //! from a TileDistance: diffX = t[0] * x + t[1] * y and diffY = t[2] * x + t[3] * y
+    static const int OCTANT_TRANSFORMS[8][4];
+
+    //! \brief Maximum number of results kept in mMemo. When reached, the memo is cleared
+    static const uint32_t MAX_MEMO_ENTRIES;
+
+    const Stencil& getStencil(int radius);
+
+    //! \brief Computes the visible tiles once mTileStates is filled
+    const std::vector<std::pair<int, int>>& computeVisibleTiles(uint32_t centerKey, int radius,
+        const Stencil& stencil);
+
+    //! \brief Helper to compute tile distances more efficiently
+    std::vector<TileDistance> mTileDistance;
+
+    //! \brief Stores the highest distance computed. If a bigger distance is asked, mTileDistance will have to be updated by
+    //! calling buildTileDistance with the higher distance
+    int mTileDistanceComputed;
+
+    //! \brief Stencils indexed by radius. A stencil with mNbTileDistances == 0 is not computed yet
+    std::vector<Stencil> mStencils;
+
+    //! \brief Buffers used by computeVisibleTiles. They are indexed by k * nbTileDistances + i where k is the
+    //! 1/8 part of the square and i the index in mTileDistance
+    std::vector<TileState> mTileStates;
+    std::vector<double> mHiddenValuesNorth;
+    std::vector<double> mHiddenValuesSouth;
+    std::vector<std::pair<int, int>> mVisibleTiles;
+
+    bool mIsMemoEnabled;
+    std::map<std::pair<uint32_t, int>, MemoEntry> mMemo;
+};
+
+#endif // LINEOFSIGHT_H
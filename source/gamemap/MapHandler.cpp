@@ -232,12 +232,20 @@ bool readGameMapFromFile(const std::string& fileName, GameMap& gameMap)
         std::getline(levelFile, nextParam);
         entire_line += nextParam;
 
-        Tile* tile = new Tile(&gameMap, true);
+        // Tiles are allocated with the map. We load the one at the coordinates given in the line
+        std::vector<std::string> elems = Helper::split(entire_line, '\t');
+        Tile* tile = nullptr;
+        if(elems.size() >= 2)
+            tile = gameMap.getTile(Helper::toInt(elems[0]), Helper::toInt(elems[1]));
+
+        if(tile == nullptr)
+        {
+            OD_LOG_WRN("Invalid tile line:" + entire_line);
+            return false;
+        }
 
         Tile::loadFromLine(entire_line, tile);
         tile->computeTileVisual();
-
-        gameMap.addTile(tile);
     }
 
     gameMap.setAllFullnessAndNeighbors();
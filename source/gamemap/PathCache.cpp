@@ -0,0 +1,163 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/PathCache.h"
+
+#include "entities/Tile.h"
+
+#include <algorithm>
+
+const uint32_t PathCache::MAX_PATHS = 4096;
+
+bool PathCache::Key::operator<(const Key& other) const
+{
+    if(mStartIndex != other.mStartIndex)
+        return mStartIndex < other.mStartIndex;
+    if(mDestIndex != other.mDestIndex)
+        return mDestIndex < other.mDestIndex;
+    if(mSeatId != other.mSeatId)
+        return mSeatId < other.mSeatId;
+    if(mSpeedGround != other.mSpeedGround)
+        return mSpeedGround < other.mSpeedGround;
+    if(mSpeedWater != other.mSpeedWater)
+        return mSpeedWater < other.mSpeedWater;
+    if(mSpeedLava != other.mSpeedLava)
+        return mSpeedLava < other.mSpeedLava;
+
+    return mCanCrossEnemyDoors < other.mCanCrossEnemyDoors;
+}
+
+PathCache::PathCache() :
+    mMapSizeX(0),
+    mMapSizeY(0),
+    mNbHits(0),
+    mNbMisses(0)
+{
+}
+
+void PathCache::setMapSize(int mapSizeX, int mapSizeY)
+{
+    if((mapSizeX == mMapSizeX) && (mapSizeY == mMapSizeY))
+        return;
+
+    clear();
+    mMapSizeX = mapSizeX;
+    mMapSizeY = mapSizeY;
+    mSlotsByTile.clear();
+    mSlotsByTile.resize(static_cast<uint32_t>(mMapSizeX * mMapSizeY));
+}
+
+bool PathCache::getPath(const Key& key, std::list<Tile*>& path)
+{
+    auto it = mEntries.find(key);
+    if(it == mEntries.end())
+    {
+        ++mNbMisses;
+        return false;
+    }
+
+    ++mNbHits;
+    path = mSlots[it->second].mPath;
+    return true;
+}
+
+void PathCache::addPath(const Key& key, const std::list<Tile*>& path)
+{
+    if(path.empty())
+        return;
+
+    if(mEntries.size() >= MAX_PATHS)
+        clear();
+
+    auto result = mEntries.insert(std::pair<Key, uint32_t>(key, 0));
+    if(!result.second)
+        removeSlot(result.first->second);
+
+    uint32_t slot;
+    if(mFreeSlots.empty())
+    {
+        slot = static_cast<uint32_t>(mSlots.size());
+        mSlots.push_back(Slot());
+        mSlots.back().mGeneration = 0;
+    }
+    else
+    {
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    }
+
+    result.first->second = slot;
+    Slot& newSlot = mSlots[slot];
+    newSlot.mPath = path;
+    newSlot.mEntry = result.first;
+    newSlot.mIsUsed = true;
+
+    for(Tile* tile : path)
+    {
+        std::vector<SlotRef>& slotRefs = mSlotsByTile[tile->getX() + tile->getY() * mMapSizeX];
+        // We take the opportunity to forget the outdated references
+        slotRefs.erase(std::remove_if(slotRefs.begin(), slotRefs.end(), [this](const SlotRef& ref)
+            {
+                return !mSlots[ref.mSlot].mIsUsed || (mSlots[ref.mSlot].mGeneration != ref.mGeneration);
+            }), slotRefs.end());
+        slotRefs.push_back(SlotRef{slot, newSlot.mGeneration});
+    }
+}
+
+void PathCache::invalidateTile(const Tile& tile)
+{
+    if(mEntries.empty())
+        return;
+
+    int xx = tile.getX();
+    int yy = tile.getY();
+    if((xx < 0) || (yy < 0) || (xx >= mMapSizeX) || (yy >= mMapSizeY))
+        return;
+
+    std::vector<SlotRef>& slotRefs = mSlotsByTile[xx + yy * mMapSizeX];
+    for(const SlotRef& ref : slotRefs)
+    {
+        const Slot& slot = mSlots[ref.mSlot];
+        if(!slot.mIsUsed || (slot.mGeneration != ref.mGeneration))
+            continue;
+
+        mEntries.erase(slot.mEntry);
+        removeSlot(ref.mSlot);
+    }
+    slotRefs.clear();
+}
+
+void PathCache::clear()
+{
+    // Every reference is dropped so the slots can be forgotten too. The cached tiles are not read
+    // because this is also called when the tiles are about to be freed
+    for(std::vector<SlotRef>& slotRefs : mSlotsByTile)
+        slotRefs.clear();
+
+    mSlots.clear();
+    mFreeSlots.clear();
+    mEntries.clear();
+}
+
+void PathCache::removeSlot(uint32_t slot)
+{
+    Slot& oldSlot = mSlots[slot];
+    oldSlot.mPath.clear();
+    oldSlot.mIsUsed = false;
+    ++oldSlot.mGeneration;
+    mFreeSlots.push_back(slot);
+}
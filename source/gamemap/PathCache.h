@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PATHCACHE_H
+#define PATHCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <vector>
+
+class Tile;
+
+/*! \brief Cache of the paths computed by GameMap::path.
+ *
+ * Entries are keyed by start tile, destination tile, passability class of the creature (its
+ * move speeds and whether it can cross enemy doors) and seat. Each cached path is indexed by
+ * the tiles it goes through so that a tile change only drops the paths using this tile.
+ * A change that can make a tile walkable (or faster) may open a shorter path anywhere so, in
+ * this case, the whole cache is dropped.
+ */
+class PathCache
+{
+public:
+    //! \brief Everything the result of GameMap::path depends on
+    struct Key
+    {
+        uint32_t mStartIndex;
+        uint32_t mDestIndex;
+        double mSpeedGround;
+        double mSpeedWater;
+        double mSpeedLava;
+        int mSeatId;
+        //! \brief Enemy doors are passable for creatures that are not fighting or fleeing
+        bool mCanCrossEnemyDoors;
+
+        bool operator<(const Key& other) const;
+    };
+
+    PathCache();
+
+    //! \brief Sets the map size. The cache is cleared if it changed
+    void setMapSize(int mapSizeX, int mapSizeY);
+
+    //! \brief If a path is cached for key, copies it in path and returns true. Returns false otherwise.
+    //! Hits and misses are counted
+    bool getPath(const Key& key, std::list<Tile*>& path);
+
+    //! \brief Stores the given path. Empty paths are not cached
+    void addPath(const Key& key, const std::list<Tile*>& path);
+
+    //! \brief Drops the cached paths going through the given tile
+    void invalidateTile(const Tile& tile);
+
+    //! \brief Drops every cached path
+    void clear();
+
+    inline uint32_t getNbHits() const
+    { return mNbHits; }
+
+    inline uint32_t getNbMisses() const
+    { return mNbMisses; }
+
+    inline uint32_t getNbPaths() const
+    { return static_cast<uint32_t>(mEntries.size()); }
+
+    //! \brief When this number of paths is reached, the cache is cleared
+    static const uint32_t MAX_PATHS;
+
+private:
+    struct Slot
+    {
+        std::list<Tile*> mPath;
+        std::map<Key, uint32_t>::iterator mEntry;
+        //! \brief Incremented each time the slot is freed. Used to ignore outdated references
+        //! from the tiles the former path was going through
+        uint32_t mGeneration;
+        bool mIsUsed;
+    };
+
+    struct SlotRef
+    {
+        uint32_t mSlot;
+        uint32_t mGeneration;
+    };
+
+    void removeSlot(uint32_t slot);
+
+    int mMapSizeX;
+    int mMapSizeY;
+
+    std::map<Key, uint32_t> mEntries;
+    std::vector<Slot> mSlots;
+    std::vector<uint32_t> mFreeSlots;
+
+    //! \brief For each tile, the slots of the paths going through it
+    std::vector<std::vector<SlotRef>> mSlotsByTile;
+
+    uint32_t mNbHits;
+    uint32_t mNbMisses;
+};
+
+#endif // PATHCACHE_H
@@ -0,0 +1,207 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/PathJobQueue.h"
+
+#include "creatureaction/CreatureAction.h"
+#include "entities/Creature.h"
+#include "entities/Tile.h"
+#include "game/Seat.h"
+#include "gamemap/TileContainer.h"
+#include "utils/ThreadPool.h"
+
+#include <algorithm>
+
+const uint32_t PathJobQueue::REQUESTS_PER_TASK = 8;
+
+PathRequest::PathRequest(const std::list<Tile*>& path) :
+    mStartIndex(0),
+    mDestinationIndex(0),
+    mIsFound(!path.empty()),
+    mPath(path),
+    mIsReady(true)
+{
+}
+
+PathRequest::PathRequest(uint32_t startIndex, uint32_t destinationIndex, const std::shared_ptr<PathSnapshot>& snapshot) :
+    mStartIndex(startIndex),
+    mDestinationIndex(destinationIndex),
+    mSnapshot(snapshot),
+    mIsFound(false),
+    mIsReady(false)
+{
+}
+
+bool PathJobQueue::Key::operator<(const Key& other) const
+{
+    if(mSeatId != other.mSeatId)
+        return mSeatId < other.mSeatId;
+    if(mSpeedGround != other.mSpeedGround)
+        return mSpeedGround < other.mSpeedGround;
+    if(mSpeedWater != other.mSpeedWater)
+        return mSpeedWater < other.mSpeedWater;
+    if(mSpeedLava != other.mSpeedLava)
+        return mSpeedLava < other.mSpeedLava;
+
+    return mCanCrossEnemyDoors < other.mCanCrossEnemyDoors;
+}
+
+PathJobQueue::PathJobQueue(ThreadPool& threadPool) :
+    mThreadPool(threadPool),
+    mContexts(threadPool.getNbSlots())
+{
+}
+
+PathJobQueue::~PathJobQueue()
+{
+    waitJobs();
+}
+
+std::shared_ptr<PathRequest> PathJobQueue::queueRequest(const TileContainer& tileContainer, Tile* start, Tile* destination,
+    const Creature& creature)
+{
+    Key key;
+    key.mSpeedGround = creature.getMoveSpeedGround();
+    key.mSpeedWater = creature.getMoveSpeedWater();
+    key.mSpeedLava = creature.getMoveSpeedLava();
+    key.mSeatId = (creature.getSeat() == nullptr) ? -1 : creature.getSeat()->getId();
+    key.mCanCrossEnemyDoors = !creature.isActionInList(CreatureActionType::fight) &&
+        !creature.isActionInList(CreatureActionType::flee);
+
+    std::shared_ptr<PathSnapshot>& snapshot = mSnapshots[key];
+    if(snapshot == nullptr)
+    {
+        snapshot = std::make_shared<PathSnapshot>();
+        snapshot->mPassability.build(tileContainer, creature);
+        snapshot->mIsOutdated = false;
+    }
+
+    int mapSizeX = tileContainer.getMapSizeX();
+    std::shared_ptr<PathRequest> request = std::make_shared<PathRequest>(
+        static_cast<uint32_t>(start->getX() + start->getY() * mapSizeX),
+        static_cast<uint32_t>(destination->getX() + destination->getY() * mapSizeX), snapshot);
+    mPendingRequests.push_back(request);
+    return request;
+}
+
+void PathJobQueue::startJobs()
+{
+    // The tiles will change during the next turn so new snapshots will be needed
+    mSnapshots.clear();
+
+    waitJobs();
+    if(mPendingRequests.empty())
+        return;
+
+    mRunningRequests.insert(mRunningRequests.end(), mPendingRequests.begin(), mPendingRequests.end());
+    mPendingRequests.clear();
+
+    // The tasks are not waited for here: they run on the workers (and on the main thread when it
+    // waits for other tasks) until deliverResults is called
+    mTaskGroup.reset(new TaskGroup(mThreadPool));
+    uint32_t nbRequests = static_cast<uint32_t>(mRunningRequests.size());
+    for(uint32_t first = 0; first < nbRequests; first += REQUESTS_PER_TASK)
+    {
+        uint32_t last = std::min(first + REQUESTS_PER_TASK, nbRequests);
+        mTaskGroup->run([this, first, last]()
+        {
+            processJobs(first, last);
+        });
+    }
+}
+
+void PathJobQueue::processJobs(uint32_t firstRequest, uint32_t lastRequest)
+{
+    // A task does not wait for other tasks so only one task at a time uses the context of a slot
+    PathfindingContext& context = mContexts[mThreadPool.getCurrentSlot()];
+    for(uint32_t i = firstRequest; i < lastRequest; ++i)
+    {
+        PathRequest& request = *mRunningRequests[i];
+        request.mIsFound = context.findPath(request.mSnapshot->mPassability, request.mStartIndex,
+            request.mDestinationIndex, request.mPathIndexes);
+    }
+}
+
+void PathJobQueue::deliverResults(const TileContainer& tileContainer)
+{
+    waitJobs();
+
+    int mapSizeX = tileContainer.getMapSizeX();
+    for(std::shared_ptr<PathRequest>& request : mRunningRequests)
+    {
+        if(request->mIsFound)
+        {
+            for(uint32_t index : request->mPathIndexes)
+                request->mPath.push_back(tileContainer.getTile(static_cast<int>(index) % mapSizeX, static_cast<int>(index) / mapSizeX));
+        }
+        request->mPathIndexes.clear();
+        request->mIsReady = true;
+    }
+    mRunningRequests.clear();
+}
+
+void PathJobQueue::notifyTilePassabilityChanged(const TileContainer& tileContainer, const Tile& tile, bool mayBlockPaths)
+{
+    // The snapshots of the current turn are not used by the tasks before startJobs so we can
+    // update them in place. The requests already queued will then use the new passability.
+    // The passability of a tile covered by a building depends on the creature. That only happens
+    // for doors and bridges so we let the next requests build new snapshots in this case. The
+    // requests already queued keep the former ones
+    bool isPendingOutdated = false;
+    if(tile.getCoveringBuilding() != nullptr)
+    {
+        mSnapshots.clear();
+        isPendingOutdated = true;
+    }
+    else
+    {
+        const TileHotState& hotState = tileContainer.getTileHotState();
+        uint32_t index = tileContainer.getTileIndex(tile.getX(), tile.getY());
+        for(std::pair<const Key, std::shared_ptr<PathSnapshot>>& snapshot : mSnapshots)
+            snapshot.second->mPassability.refreshTile(hotState, index);
+    }
+
+    // If the tile can only be walked through more easily, the paths found are still valid
+    if(!mayBlockPaths)
+        return;
+
+    // The paths may go through the tile. Only the main thread reads mIsOutdated
+    if(isPendingOutdated)
+    {
+        for(std::shared_ptr<PathRequest>& request : mPendingRequests)
+            request->mSnapshot->mIsOutdated = true;
+    }
+    for(std::shared_ptr<PathRequest>& request : mRunningRequests)
+        request->mSnapshot->mIsOutdated = true;
+}
+
+void PathJobQueue::clear()
+{
+    waitJobs();
+    mSnapshots.clear();
+    mPendingRequests.clear();
+    mRunningRequests.clear();
+}
+
+void PathJobQueue::waitJobs()
+{
+    if(mTaskGroup == nullptr)
+        return;
+
+    mTaskGroup->wait();
+    mTaskGroup.reset();
+}
@@ -0,0 +1,152 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PATHJOBQUEUE_H
+#define PATHJOBQUEUE_H
+
+#include "gamemap/PathfindingContext.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+class Creature;
+class TaskGroup;
+class ThreadPool;
+class Tile;
+class TileContainer;
+
+//! \brief Passability snapshot shared by the requests of the creatures moving the same way
+struct PathSnapshot
+{
+    PassabilitySnapshot mPassability;
+    //! \brief Set when a tile became harder to go through after the snapshot was built. The
+    //! paths computed on it may not be valid anymore. Only used on the main thread
+    bool mIsOutdated;
+};
+
+/*! \brief Handle on a path computed in the background. It is given by PathJobQueue::queueRequest
+ * and becomes ready when the results are delivered.
+ */
+class PathRequest
+{
+public:
+    //! \brief Creates a request that is already ready with the given path
+    PathRequest(const std::list<Tile*>& path);
+
+    PathRequest(uint32_t startIndex, uint32_t destinationIndex, const std::shared_ptr<PathSnapshot>& snapshot);
+
+    inline bool isReady() const
+    { return mIsReady; }
+
+    //! \brief The path from start to destination (both included). Empty if no path was found.
+    //! Only meaningful when the request is ready
+    inline const std::list<Tile*>& getPath() const
+    { return mPath; }
+
+    //! \brief Returns true if some tiles became harder to go through since the path was computed.
+    //! In that case, it should be computed again
+    inline bool isOutdated() const
+    { return (mSnapshot != nullptr) && mSnapshot->mIsOutdated; }
+
+private:
+    friend class PathJobQueue;
+
+    uint32_t mStartIndex;
+    uint32_t mDestinationIndex;
+    std::shared_ptr<PathSnapshot> mSnapshot;
+    //! \brief Filled by the worker threads
+    std::vector<uint32_t> mPathIndexes;
+    bool mIsFound;
+    //! \brief Filled on the main thread when the results are delivered
+    std::list<Tile*> mPath;
+    bool mIsReady;
+};
+
+/*! \brief Computes the paths requested during a turn on the simulation thread pool.
+ *
+ * During the turn, queueRequest copies the passability of the tiles for the requesting creature
+ * in a snapshot (shared by the creatures with the same speeds and seat). At the end of the turn,
+ * startJobs queues tasks solving the requests that only read the snapshots. The game map can be
+ * updated meanwhile. At the start of the next turn, deliverResults waits for the tasks and makes
+ * the requests ready.
+ */
+class PathJobQueue
+{
+public:
+    PathJobQueue(ThreadPool& threadPool);
+    ~PathJobQueue();
+
+    //! \brief Queues the path computation from start to destination for the given creature
+    std::shared_ptr<PathRequest> queueRequest(const TileContainer& tileContainer, Tile* start, Tile* destination,
+        const Creature& creature);
+
+    //! \brief Starts solving the queued requests on the thread pool
+    void startJobs();
+
+    //! \brief Waits for the tasks and makes the requests they solved ready
+    void deliverResults(const TileContainer& tileContainer);
+
+    //! \brief Should be called when the passability of the given tile changes, after its hot state
+    //! has been refreshed. The snapshots of the current turn are updated. If mayBlockPaths is true,
+    //! the requests that do not use an updated snapshot are flagged as outdated
+    void notifyTilePassabilityChanged(const TileContainer& tileContainer, const Tile& tile, bool mayBlockPaths);
+
+    //! \brief Waits for the tasks and forgets every request
+    void clear();
+
+    //! \brief Number of requests solved by each task
+    static const uint32_t REQUESTS_PER_TASK;
+
+private:
+    struct Key
+    {
+        double mSpeedGround;
+        double mSpeedWater;
+        double mSpeedLava;
+        int mSeatId;
+        bool mCanCrossEnemyDoors;
+
+        bool operator<(const Key& other) const;
+    };
+
+    void waitJobs();
+
+    //! \brief Solves the running requests from firstRequest to lastRequest (excluded)
+    void processJobs(uint32_t firstRequest, uint32_t lastRequest);
+
+    //! \brief Snapshots built during the current turn
+    std::map<Key, std::shared_ptr<PathSnapshot>> mSnapshots;
+
+    //! \brief Requests queued since the last call to startJobs
+    std::vector<std::shared_ptr<PathRequest>> mPendingRequests;
+
+    //! \brief Requests being solved by the tasks. Only the tasks access them until they are done
+    std::vector<std::shared_ptr<PathRequest>> mRunningRequests;
+
+    ThreadPool& mThreadPool;
+
+    //! \brief Tasks solving mRunningRequests. Null when there is none
+    std::unique_ptr<TaskGroup> mTaskGroup;
+
+    //! \brief Working memory of the tasks for each slot of the thread pool
+    std::vector<PathfindingContext> mContexts;
+};
+
+#endif // PATHJOBQUEUE_H
@@ -0,0 +1,372 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/PathfindingContext.h"
+
+#include "entities/Creature.h"
+#include "entities/Tile.h"
+#include "gamemap/TileContainer.h"
+#include "gamemap/TileHotState.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+//! \brief Manhattan distance used both as heuristic and as base weight between neighbors
+static inline double manhattanDistance(int x1, int y1, int x2, int y2)
+{
+    return static_cast<double>(std::abs(x2 - x1) + std::abs(y2 - y1));
+}
+
+PathfindingContext::PathfindingContext() :
+    mMapSizeX(0),
+    mMapSizeY(0),
+    mGeneration(0),
+    mSequence(0)
+{
+}
+
+void PathfindingContext::startSearch(int mapSizeX, int mapSizeY)
+{
+    if((mapSizeX != mMapSizeX) || (mapSizeY != mMapSizeY))
+    {
+        mMapSizeX = mapSizeX;
+        mMapSizeY = mapSizeY;
+        mNodes.assign(static_cast<size_t>(mMapSizeX) * static_cast<size_t>(mMapSizeY), Node());
+        for(Node& node : mNodes)
+        {
+            node.mGeneration = 0;
+            node.mGoalGeneration = 0;
+        }
+
+        mGeneration = 0;
+    }
+
+    ++mGeneration;
+    // When the generation counter wraps, old stamps could be mistaken for current ones
+    if(mGeneration == 0)
+    {
+        for(Node& node : mNodes)
+        {
+            node.mGeneration = 0;
+            node.mGoalGeneration = 0;
+        }
+
+        mGeneration = 1;
+    }
+
+    mSequence = 0;
+    mOpenList.clear();
+}
+
+void PathfindingContext::pushOpen(uint32_t index, double fCost)
+{
+    Node& node = mNodes[index];
+    node.mSequence = ++mSequence;
+    mOpenList.push_back(OpenEntry{fCost, node.mSequence, index});
+    std::push_heap(mOpenList.begin(), mOpenList.end(), OpenEntryGreater());
+}
+
+namespace
+{
+//! \brief Passability read from the game tiles for the given creature
+class TilePassability
+{
+public:
+    TilePassability(const TileContainer& tileContainer, const Creature& creature, Seat* seat, bool throughDiggableTiles) :
+        mTileContainer(tileContainer),
+        mCreature(creature),
+        mSeat(seat),
+        mThroughDiggableTiles(throughDiggableTiles)
+    {}
+
+    inline int getMapSizeX() const
+    { return mTileContainer.getMapSizeX(); }
+
+    inline int getMapSizeY() const
+    { return mTileContainer.getMapSizeY(); }
+
+    //! \brief The weight to go from a tile to a neighbor only depends on the speed on the tile we leave
+    inline double getSpeedFrom(int x, int y) const
+    {
+        Tile* tile = mTileContainer.getTile(x, y);
+        if(tile->getFullness() == 0)
+            return mCreature.getMoveSpeed(tile);
+
+        return mCreature.getMoveSpeedGround();
+    }
+
+    inline bool canGoThrough(int x, int y) const
+    { return mCreature.canGoThroughTile(mTileContainer.getTile(x, y)); }
+
+    inline bool canDig(int x, int y) const
+    { return mThroughDiggableTiles && mTileContainer.getTile(x, y)->isDiggable(mSeat); }
+
+private:
+    const TileContainer& mTileContainer;
+    const Creature& mCreature;
+    Seat* mSeat;
+    bool mThroughDiggableTiles;
+};
+
+//! \brief Passability read from a snapshot
+class SnapshotPassability
+{
+public:
+    SnapshotPassability(const PassabilitySnapshot& snapshot) :
+        mSnapshot(snapshot)
+    {}
+
+    inline int getMapSizeX() const
+    { return mSnapshot.mMapSizeX; }
+
+    inline int getMapSizeY() const
+    { return mSnapshot.mMapSizeY; }
+
+    inline double getSpeedFrom(int x, int y) const
+    { return mSnapshot.mSpeedsFrom[x + y * mSnapshot.mMapSizeX]; }
+
+    inline bool canGoThrough(int x, int y) const
+    { return mSnapshot.mPassable[x + y * mSnapshot.mMapSizeX] != 0; }
+
+    inline bool canDig(int, int) const
+    { return false; }
+
+private:
+    const PassabilitySnapshot& mSnapshot;
+};
+}
+
+void PassabilitySnapshot::build(const TileContainer& tileContainer, const Creature& creature)
+{
+    mMapSizeX = tileContainer.getMapSizeX();
+    mMapSizeY = tileContainer.getMapSizeY();
+    uint32_t nbTiles = static_cast<uint32_t>(mMapSizeX * mMapSizeY);
+    mSpeedsFrom.resize(nbTiles);
+    mPassable.resize(nbTiles);
+    TilePassability passability(tileContainer, creature, nullptr, false);
+    const TileHotState& hotState = tileContainer.getTileHotState();
+    bool isOnServerMap = creature.getIsOnServerMap();
+    mSpeedGround = creature.getMoveSpeedGround();
+    mSpeedWater = creature.getMoveSpeedWater();
+    mSpeedLava = creature.getMoveSpeedLava();
+    for(int yy = 0; yy < mMapSizeY; ++yy)
+    {
+        for(int xx = 0; xx < mMapSizeX; ++xx)
+        {
+            uint32_t index = static_cast<uint32_t>(xx + yy * mMapSizeX);
+            // Tiles covered by a building (and client tiles) depend on more than the hot state
+            if(!isOnServerMap || (hotState.getCoveringBuilding(index) != nullptr))
+            {
+                mSpeedsFrom[index] = passability.getSpeedFrom(xx, yy);
+                mPassable[index] = passability.canGoThrough(xx, yy) ? 1 : 0;
+                continue;
+            }
+
+            refreshTile(hotState, index);
+        }
+    }
+}
+
+void PassabilitySnapshot::refreshTile(const TileHotState& hotState, uint32_t index)
+{
+    // Same as Creature::getMoveSpeed on a tile without building
+    double speed = TileHotState::getCreatureSpeed(hotState.getTileVisual(index), mSpeedGround, mSpeedWater, mSpeedLava);
+    mSpeedsFrom[index] = hotState.isFullTile(index) ? mSpeedGround : speed;
+    mPassable[index] = (speed > 0.0) ? 1 : 0;
+}
+
+bool PathfindingContext::findPath(const TileContainer& tileContainer, Tile* start, Tile* destination,
+    const Creature& creature, Seat* seat, bool throughDiggableTiles, std::list<Tile*>& path,
+    const PathfindingBounds* bounds)
+{
+    TilePassability passability(tileContainer, creature, seat, throughDiggableTiles);
+    startSearch(passability.getMapSizeX(), passability.getMapSizeY());
+    int32_t destinationIndex = search(passability, static_cast<uint32_t>(start->getX() + start->getY() * mMapSizeX),
+        destination->getX() + destination->getY() * mMapSizeX, bounds);
+    if(destinationIndex < 0)
+        return false;
+
+    buildPath(tileContainer, destinationIndex, path);
+    return true;
+}
+
+bool PathfindingContext::findPathToClosest(const TileContainer& tileContainer, Tile* start,
+    const std::vector<Tile*>& destinations, const Creature& creature, Seat* seat,
+    std::list<Tile*>& path, Tile*& chosenTile)
+{
+    TilePassability passability(tileContainer, creature, seat, false);
+    startSearch(passability.getMapSizeX(), passability.getMapSizeY());
+    for(Tile* tile : destinations)
+        mNodes[tile->getX() + tile->getY() * mMapSizeX].mGoalGeneration = mGeneration;
+
+    int32_t destinationIndex = search(passability, static_cast<uint32_t>(start->getX() + start->getY() * mMapSizeX),
+        -1, nullptr);
+    if(destinationIndex < 0)
+        return false;
+
+    buildPath(tileContainer, destinationIndex, path);
+    chosenTile = path.back();
+    return true;
+}
+
+bool PathfindingContext::findPath(const PassabilitySnapshot& snapshot, uint32_t startIndex, uint32_t destinationIndex,
+    std::vector<uint32_t>& path)
+{
+    SnapshotPassability passability(snapshot);
+    startSearch(passability.getMapSizeX(), passability.getMapSizeY());
+    int32_t foundIndex = search(passability, startIndex, static_cast<int32_t>(destinationIndex), nullptr);
+    if(foundIndex < 0)
+        return false;
+
+    path.clear();
+    for(int32_t index = foundIndex; index >= 0; index = mNodes[index].mParent)
+        path.push_back(static_cast<uint32_t>(index));
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+
+template<typename Passability>
+int32_t PathfindingContext::search(const Passability& passability, uint32_t startIndex, int32_t destinationIndex,
+    const PathfindingBounds* bounds)
+{
+    // Without destination, the heuristic is 0 and the search is a Dijkstra that stops on
+    // the first goal tile reached
+    const bool useHeuristic = (destinationIndex >= 0);
+    const int x2 = useHeuristic ? destinationIndex % mMapSizeX : 0;
+    const int y2 = useHeuristic ? destinationIndex / mMapSizeX : 0;
+    const int startX = static_cast<int>(startIndex) % mMapSizeX;
+    const int startY = static_cast<int>(startIndex) / mMapSizeX;
+
+    Node& startNode = mNodes[startIndex];
+    startNode.mGeneration = mGeneration;
+    startNode.mParent = -1;
+    startNode.mClosed = false;
+    startNode.mG = 0.0;
+    pushOpen(startIndex, useHeuristic ? manhattanDistance(startX, startY, x2, y2) : 0.0);
+
+    // The 4 adjacent tiles first, then the 4 diagonal ones. For a diagonal tile, the indexes of
+    // the 2 adjacent tiles that must be passable
+    static const int NEIGHBORS[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+    static const unsigned int DIAGONAL_CONDITIONS[4][2] = {{0, 2}, {0, 3}, {1, 2}, {1, 3}};
+
+    int32_t foundIndex = -1;
+    while(!mOpenList.empty())
+    {
+        std::pop_heap(mOpenList.begin(), mOpenList.end(), OpenEntryGreater());
+        OpenEntry entry = mOpenList.back();
+        mOpenList.pop_back();
+
+        Node& currentNode = mNodes[entry.mIndex];
+        // The node has been pushed again with a lower cost since this entry was added
+        if(entry.mSequence != currentNode.mSequence)
+            continue;
+
+        currentNode.mClosed = true;
+
+        // We found the path, break out of the search loop
+        if(useHeuristic ? (static_cast<int32_t>(entry.mIndex) == destinationIndex) : (currentNode.mGoalGeneration == mGeneration))
+        {
+            foundIndex = static_cast<int32_t>(entry.mIndex);
+            break;
+        }
+
+        int currentX = static_cast<int>(entry.mIndex) % mMapSizeX;
+        int currentY = static_cast<int>(entry.mIndex) / mMapSizeX;
+        double speed = passability.getSpeedFrom(currentX, currentY);
+
+        // Check the tiles surrounding the current square
+        bool areTilesPassable[4] = {false, false, false, false};
+        // Note : to disable diagonals, process tiles from 0 to 3. To allow them, process tiles from 0 to 7
+        for(unsigned int i = 0; i < 8; ++i)
+        {
+            // We only process a diagonal tile if the 2 tiles adjacent to the original one are passable
+            if((i >= 4) &&
+               (!areTilesPassable[DIAGONAL_CONDITIONS[i - 4][0]] || !areTilesPassable[DIAGONAL_CONDITIONS[i - 4][1]]))
+            {
+                continue;
+            }
+
+            int neighborX = currentX + NEIGHBORS[i][0];
+            int neighborY = currentY + NEIGHBORS[i][1];
+            if((neighborX < 0) || (neighborY < 0) || (neighborX >= mMapSizeX) || (neighborY >= mMapSizeY))
+                continue;
+
+            if((bounds != nullptr) &&
+               ((neighborX < bounds->mMinX) || (neighborX > bounds->mMaxX) ||
+                (neighborY < bounds->mMinY) || (neighborY > bounds->mMaxY)))
+            {
+                continue;
+            }
+
+            uint32_t neighborIndex = static_cast<uint32_t>(neighborX + neighborY * mMapSizeX);
+            bool processNeighbor = false;
+            // We process the tile if the creature can go through. But if it is the first tile that is
+            // not passable, we also process it. That happens if a door is closed
+            if(passability.canGoThrough(neighborX, neighborY) ||
+               (neighborIndex == startIndex))
+            {
+                processNeighbor = true;
+                // We set passability for the 4 adjacent tiles only
+                if(i < 4)
+                    areTilesPassable[i] = true;
+            }
+            else if(passability.canDig(neighborX, neighborY))
+                processNeighbor = true;
+
+            if(!processNeighbor)
+                continue;
+
+            Node& neighborNode = mNodes[neighborIndex];
+            double g = currentNode.mG + manhattanDistance(neighborX, neighborY, currentX, currentY) / speed;
+
+            if(neighborNode.mGeneration != mGeneration)
+            {
+                // First time we reach this tile during this search
+                neighborNode.mGeneration = mGeneration;
+                neighborNode.mClosed = false;
+                neighborNode.mG = g;
+                neighborNode.mParent = static_cast<int32_t>(entry.mIndex);
+                // Use the manhattan distance for the heuristic
+                pushOpen(neighborIndex, g + (useHeuristic ? manhattanDistance(neighborX, neighborY, x2, y2) : 0.0));
+                continue;
+            }
+
+            if(neighborNode.mClosed)
+                continue;
+
+            // If this path to the given neighbor tile is a shorter path than the
+            // one already given, make this the new parent. The old heap entry will
+            // be ignored because its sequence number is outdated
+            if(g < neighborNode.mG)
+            {
+                neighborNode.mG = g;
+                neighborNode.mParent = static_cast<int32_t>(entry.mIndex);
+                pushOpen(neighborIndex, g + (useHeuristic ? manhattanDistance(neighborX, neighborY, x2, y2) : 0.0));
+            }
+        }
+    }
+
+    return foundIndex;
+}
+
+void PathfindingContext::buildPath(const TileContainer& tileContainer, int32_t destinationIndex, std::list<Tile*>& path) const
+{
+    // Follow the parent chain back the the starting tile
+    path.clear();
+    for(int32_t index = destinationIndex; index >= 0; index = mNodes[index].mParent)
+        path.push_front(tileContainer.getTile(index % mMapSizeX, index / mMapSizeX));
+}
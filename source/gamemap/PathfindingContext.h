@@ -0,0 +1,162 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PATHFINDINGCONTEXT_H
+#define PATHFINDINGCONTEXT_H
+
+#include <cstdint>
+#include <list>
+#include <vector>
+
+class Creature;
+class Seat;
+class Tile;
+class TileContainer;
+class TileHotState;
+
+//! \brief Inclusive rectangle a search can be restricted to
+struct PathfindingBounds
+{
+    int mMinX;
+    int mMinY;
+    int mMaxX;
+    int mMaxY;
+};
+
+/*! \brief Passability of every tile for a given creature, copied from the game map.
+ *
+ * Paths can be computed on a snapshot without accessing the tiles or the creature, for example
+ * from another thread while the game map is being updated. Diggable tiles are not handled.
+ */
+struct PassabilitySnapshot
+{
+    //! \brief Copies the passability of every tile for the given creature
+    void build(const TileContainer& tileContainer, const Creature& creature);
+
+    //! \brief Copies again the passability of the tile with the given index from the hot state. The tile
+    //! must not be covered by a building (its passability would depend on the creature)
+    void refreshTile(const TileHotState& hotState, uint32_t index);
+
+    int mMapSizeX;
+    int mMapSizeY;
+    //! \brief Speeds of the creature the snapshot was built for
+    double mSpeedGround;
+    double mSpeedWater;
+    double mSpeedLava;
+    //! \brief Speed used to leave each tile (as used for the move weight)
+    std::vector<double> mSpeedsFrom;
+    //! \brief 1 if the creature can go through the tile, 0 otherwise
+    std::vector<uint8_t> mPassable;
+};
+
+/*! \brief Reusable working memory for the A* search used by GameMap::path.
+ *
+ * The node array is allocated once for the map size and reused between searches. Instead
+ * of clearing it, each search bumps a generation counter: a node whose generation differs
+ * from the current one is considered as not visited yet. The open list is a binary heap.
+ * Ties between nodes with the same cost are broken by insertion order so that the returned
+ * paths are the same as the ones computed with the former sorted open list.
+ *
+ * The A* description can be found here:
+ * http://en.wikipedia.org/wiki/A*_search_algorithm
+ */
+class PathfindingContext
+{
+public:
+    PathfindingContext();
+
+    //! \brief Computes the walkable path between start and destination for the given creature.
+    //! If a path is found, it is stored in path (containing both start and destination) and true
+    //! is returned. Otherwise, path is left untouched and false is returned.
+    //! The parameters have the same meaning as in GameMap::path
+    //! If bounds is not null, tiles outside of it are considered as not passable
+    bool findPath(const TileContainer& tileContainer, Tile* start, Tile* destination,
+        const Creature& creature, Seat* seat, bool throughDiggableTiles, std::list<Tile*>& path,
+        const PathfindingBounds* bounds = nullptr);
+
+    //! \brief Computes the cheapest walkable path between start and any of the given destinations
+    //! with a single Dijkstra search. If a path is found, it is stored in path, chosenTile is set to
+    //! the destination reached and true is returned. Otherwise, path and chosenTile are left untouched
+    //! and false is returned.
+    bool findPathToClosest(const TileContainer& tileContainer, Tile* start, const std::vector<Tile*>& destinations,
+        const Creature& creature, Seat* seat, std::list<Tile*>& path, Tile*& chosenTile);
+
+    //! \brief Same as findPath but on the given snapshot. path is filled with the tile indexes
+    //! (x + y * mapSizeX). It does not access any game object
+    bool findPath(const PassabilitySnapshot& snapshot, uint32_t startIndex, uint32_t destinationIndex,
+        std::vector<uint32_t>& path);
+
+private:
+    struct Node
+    {
+        //! \brief Search this node was last touched by. If it differs from mGeneration, the other
+        //! fields are garbage from a previous search
+        uint32_t mGeneration;
+        //! \brief Sequence number of the last heap entry pushed for this node. Older entries
+        //! still in the heap are ignored when popped
+        uint32_t mSequence;
+        //! \brief Equals mGeneration if this tile is one of the destinations of a multi-target search
+        uint32_t mGoalGeneration;
+        //! \brief Index of the parent node. -1 for the start node
+        int32_t mParent;
+        bool mClosed;
+        double mG;
+    };
+
+    struct OpenEntry
+    {
+        double mFCost;
+        uint32_t mSequence;
+        uint32_t mIndex;
+    };
+
+    //! \brief Min-heap ordering on fCost then on insertion order
+    struct OpenEntryGreater
+    {
+        inline bool operator()(const OpenEntry& e1, const OpenEntry& e2) const
+        {
+            if(e1.mFCost != e2.mFCost)
+                return e1.mFCost > e2.mFCost;
+
+            return e1.mSequence > e2.mSequence;
+        }
+    };
+
+    //! \brief Reallocates the nodes if the map size changed and starts a new generation
+    void startSearch(int mapSizeX, int mapSizeY);
+
+    void pushOpen(uint32_t index, double fCost);
+
+    //! \brief Runs the search from start. If destinationIndex is negative, the search stops on the first
+    //! tile flagged with mGoalGeneration. Returns the index of the tile reached or -1.
+    //! Passability gives the tiles speeds and passability (from the tiles or from a snapshot)
+    template<typename Passability>
+    int32_t search(const Passability& passability, uint32_t startIndex, int32_t destinationIndex,
+        const PathfindingBounds* bounds);
+
+    //! \brief Fills path by following the parents from the given tile
+    void buildPath(const TileContainer& tileContainer, int32_t destinationIndex, std::list<Tile*>& path) const;
+
+    std::vector<Node> mNodes;
+    std::vector<OpenEntry> mOpenList;
+    int mMapSizeX;
+    int mMapSizeY;
+    uint32_t mGeneration;
+    uint32_t mSequence;
+};
+
+#endif // PATHFINDINGCONTEXT_H
@@ -18,13 +18,18 @@
 #ifndef TILECONTAINER_H
 #define TILECONTAINER_H
 
+#include "entities/Tile.h"
+#include "gamemap/EntitySpatialIndex.h"
+#include "gamemap/LineOfSight.h"
+#include "gamemap/TileHotState.h"
+
 #include <cassert>
+#include <cstdint>
 #include <list>
 #include <vector>
 
+class GameMap;
 class ODPacket;
-class TileDistance;
-class Tile;
 
 enum class TileType;
 
@@ -37,10 +42,6 @@ public:
     //! \brief Clears the mesh and deletes the data structure for all the tiles in the TileContainer.
     void clearTiles();
 
-    //! \brief Adds the given tile on map. The tile coordinates members must be ready.
-    //! \returns true if added.
-    bool addTile(Tile* t);
-
     //! \brief Adds the address of a new tile to be stored in this TileContainer.
     void setTileNeighbors(Tile *t);
 
@@ -50,18 +51,69 @@ public:
         assert(mTiles != nullptr);
 
         if (xx < getMapSizeX() && yy < getMapSizeY() && xx >= 0 && yy >= 0)
-            return mTiles[xx][yy];
+            return &mTiles[xx + yy * mMapSizeX];
         else
         {
             return nullptr;
         }
     }
 
+    //! \brief Tiles are stored row by row in a single block. The index of the tile at (x, y)
+    //! is x + y * mapSizeX and stays the same as long as the map is not reallocated
+    inline uint32_t getNbTiles() const
+    { return static_cast<uint32_t>(mMapSizeX * mMapSizeY); }
+
+    inline uint32_t getTileIndex(int xx, int yy) const
+    { return static_cast<uint32_t>(xx + yy * mMapSizeX); }
+
+    //! \brief Returns the index of the given tile without reading it. The tile must belong to this container
+    inline uint32_t getTileIndex(const Tile* tile) const
+    { return static_cast<uint32_t>(tile - mTiles); }
+
+    //! \brief Returns the tile with the given index. The index must be lower than getNbTiles()
+    inline Tile* getTileByIndex(uint32_t index) const
+    {
+        assert(index < getNbTiles());
+        return &mTiles[index];
+    }
+
+    //! \brief Returns the index of the tile at (x + diffX, y + diffY) where (x, y) is the tile with
+    //! the given index. Returns -1 if it is outside the map
+    inline int32_t getNeighborIndex(uint32_t index, int diffX, int diffY) const
+    {
+        int xx = static_cast<int>(index) % mMapSizeX + diffX;
+        int yy = static_cast<int>(index) / mMapSizeX + diffY;
+        if (xx < 0 || yy < 0 || xx >= mMapSizeX || yy >= mMapSizeY)
+            return -1;
+
+        return xx + yy * mMapSizeX;
+    }
+
+    //! \brief Fields of the tiles read by the simulation loops, indexed like the tiles
+    inline const TileHotState& getTileHotState() const
+    { return mTileHotState; }
+
+    inline TileHotState& getTileHotState()
+    { return mTileHotState; }
+
+    //! \brief Creatures and building tiles bucketed by map area, see EntitySpatialIndex
+    inline EntitySpatialIndex& getEntitySpatialIndex()
+    { return mEntitySpatialIndex; }
+
+    inline const EntitySpatialIndex& getEntitySpatialIndex() const
+    { return mEntitySpatialIndex; }
+
     //! \brief This functions exports the needed to retrieve a tile for networking.
     //! The tile informations are not embedded, only the needed to identify the tile
     void tileToPacket(ODPacket& packet, Tile* tile) const;
     Tile* tileFromPacket(ODPacket& packet) const;
 
+    //! \brief Exports a list of tiles with the compact encoding from TileIndexEncoding. The order of the tiles
+    //! is not kept
+    void tilesToPacket(ODPacket& packet, const std::vector<Tile*>& tiles) const;
+    //! \brief Appends the tiles read to the given list. Returns false if the packet is invalid
+    bool tilesFromPacket(ODPacket& packet, std::vector<Tile*>& tiles) const;
+
     //! \brief Returns all the valid tiles in the rectangular region specified by the two corner points given.
     std::vector<Tile*> rectangularRegion(int x1, int y1, int x2, int y2);
 
@@ -95,7 +147,15 @@ public:
 
     //! \brief Returns the tiles visible from the given start tile within radius. The tiles are ordered from the closest to
     //! the furthest
-    std::vector<Tile*> visibleTiles(int x, int y, int radius);
+    inline std::vector<Tile*> visibleTiles(int x, int y, int radius)
+    { return visibleTiles(x, y, radius, mLineOfSight); }
+
+    //! \brief Same as visibleTiles but uses the given LineOfSight. To get the same result, it should have
+    //! the same tile distances as getLineOfSight()
+    std::vector<Tile*> visibleTiles(int x, int y, int radius, LineOfSight& lineOfSight) const;
+
+    inline LineOfSight& getLineOfSight()
+    { return mLineOfSight; }
 
 protected:
     //! \brief The map size
@@ -104,20 +164,18 @@ protected:
 
     int mRr;
 
-    //! \brief Set the map size and memory
-    bool allocateMapMemory(int xSize, int ySize);
+    //! \brief Set the map size and memory. Every tile is constructed with its coordinates
+    bool allocateMapMemory(GameMap* gameMap, int xSize, int ySize);
 private:
-    Tile*** mTiles;
+    //! \brief Tiles block. Tiles are constructed in place and never move until the map is cleared
+    Tile* mTiles;
 
-    //! \brief Fills mTileDistance that will help to compute a vector with sorted Tiles more efficiently
-    void buildTileDistance(int distance);
+    TileHotState mTileHotState;
 
-    //! \brief Helper to compute tile distances more efficiently
-    std::vector<TileDistance> mTileDistance;
+    EntitySpatialIndex mEntitySpatialIndex;
 
-    //! \brief Stores the highest distance computed. If a bigger distance is asked, mTileDistance will have to be updated by
-    //! calling buildTileDistance with the higher distance
-    int mTileDistanceComputed;
+    //! \brief Helper to compute tile distances and visible tiles more efficiently
+    LineOfSight mLineOfSight;
 };
 
 #endif //TILECONTAINER_H
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/TileHotState.h"
+
+void TileHotState::resize(uint32_t nbTiles)
+{
+    mTypes.assign(nbTiles, static_cast<uint8_t>(TileType::nullTileType));
+    mTileVisuals.assign(nbTiles, static_cast<uint8_t>(TileVisual::nullTileVisual));
+    mFlags.assign(nbTiles, 0);
+    mFullness.assign(nbTiles, 0.0);
+    mSeats.assign(nbTiles, nullptr);
+    mCoveringBuildings.assign(nbTiles, nullptr);
+}
+
+void TileHotState::clear()
+{
+    mTypes.clear();
+    mTileVisuals.clear();
+    mFlags.clear();
+    mFullness.clear();
+    mSeats.clear();
+    mCoveringBuildings.clear();
+}
+
+bool TileHotState::update(uint32_t index, const Tile& tile)
+{
+    if(index >= getNbTiles())
+        return false;
+
+    mTypes[index] = static_cast<uint8_t>(tile.getType());
+    mTileVisuals[index] = static_cast<uint8_t>(tile.getTileVisual());
+    mFullness[index] = tile.getFullness();
+    uint8_t flags = 0;
+    if(tile.getFullness() > 0.0)
+        flags |= FlagFull;
+    if(tile.isClaimed())
+        flags |= FlagClaimed;
+    bool isClaimChanged = (((mFlags[index] ^ flags) & FlagClaimed) != 0) ||
+        (((flags & FlagClaimed) != 0) && (mSeats[index] != tile.getSeat()));
+    mFlags[index] = flags;
+    mSeats[index] = tile.getSeat();
+    mCoveringBuildings[index] = tile.getCoveringBuilding();
+    return isClaimChanged;
+}
+
+bool TileHotState::isFloodFillPossible(TileType tileType, double fullness, FloodFillType type)
+{
+    // No floodfill can be set on full tiles
+    if(fullness > 0.0)
+        return false;
+
+    switch(tileType)
+    {
+        case TileType::dirt:
+        case TileType::gold:
+        case TileType::rock:
+        {
+            switch(type)
+            {
+                case FloodFillType::ground:
+                case FloodFillType::groundWater:
+                case FloodFillType::groundLava:
+                case FloodFillType::groundWaterLava:
+                {
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+        case TileType::water:
+        {
+            switch(type)
+            {
+                case FloodFillType::groundWater:
+                case FloodFillType::groundWaterLava:
+                {
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+        case TileType::lava:
+        {
+            switch(type)
+            {
+                case FloodFillType::groundLava:
+                case FloodFillType::groundWaterLava:
+                {
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+        default:
+            return false;
+    }
+
+    return false;
+}
+
+double TileHotState::getCreatureSpeed(TileVisual tileVisual, double speedGround, double speedWater, double speedLava)
+{
+    switch(tileVisual)
+    {
+        case TileVisual::dirtGround:
+        case TileVisual::goldGround:
+        case TileVisual::rockGround:
+        case TileVisual::claimedGround:
+            return speedGround;
+        case TileVisual::waterGround:
+            return speedWater;
+        case TileVisual::lavaGround:
+            return speedLava;
+        default:
+            return 0.0;
+    }
+}
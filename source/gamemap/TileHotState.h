@@ -0,0 +1,99 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILEHOTSTATE_H
+#define TILEHOTSTATE_H
+
+#include "entities/Tile.h"
+
+#include <cstdint>
+#include <vector>
+
+class Building;
+class Seat;
+
+/*! \brief Copy of the tile fields read by the simulation loops stored as one array per field
+ * (indexed like the tiles in TileContainer). Loops over the whole map, like counting the
+ * claimed tiles or building a passability snapshot, only walk the arrays they need instead
+ * of loading every Tile.
+ * The Tile stays the owner of the values and refreshes its entry each time one of them changes.
+ */
+class TileHotState
+{
+public:
+    TileHotState()
+    {}
+
+    void resize(uint32_t nbTiles);
+
+    void clear();
+
+    //! \brief Copies the hot fields of the given tile to the entry at index. Returns true if the
+    //! tile got claimed, unclaimed or changed owner
+    bool update(uint32_t index, const Tile& tile);
+
+    inline uint32_t getNbTiles() const
+    { return static_cast<uint32_t>(mTypes.size()); }
+
+    inline TileType getType(uint32_t index) const
+    { return static_cast<TileType>(mTypes[index]); }
+
+    inline TileVisual getTileVisual(uint32_t index) const
+    { return static_cast<TileVisual>(mTileVisuals[index]); }
+
+    inline double getFullness(uint32_t index) const
+    { return mFullness[index]; }
+
+    inline bool isFullTile(uint32_t index) const
+    { return (mFlags[index] & FlagFull) != 0; }
+
+    //! \brief Same as Tile::isClaimed
+    inline bool isClaimed(uint32_t index) const
+    { return (mFlags[index] & FlagClaimed) != 0; }
+
+    inline Seat* getSeat(uint32_t index) const
+    { return mSeats[index]; }
+
+    inline Building* getCoveringBuilding(uint32_t index) const
+    { return mCoveringBuildings[index]; }
+
+    inline bool isFloodFillPossible(uint32_t index, FloodFillType type) const
+    { return isFloodFillPossible(getType(index), getFullness(index), type); }
+
+    //! \brief Returns true if a tile with the given type and fullness can have the given floodfill type
+    static bool isFloodFillPossible(TileType tileType, double fullness, FloodFillType type);
+
+    //! \brief Returns the speed, among the given ones, a creature has on a tile with the given visual
+    //! when no building covers it. 0 if the tile cannot be walked on
+    static double getCreatureSpeed(TileVisual tileVisual, double speedGround, double speedWater, double speedLava);
+
+private:
+    enum Flags
+    {
+        FlagFull = 0x01,
+        FlagClaimed = 0x02
+    };
+
+    std::vector<uint8_t> mTypes;
+    std::vector<uint8_t> mTileVisuals;
+    std::vector<uint8_t> mFlags;
+    std::vector<double> mFullness;
+    std::vector<Seat*> mSeats;
+    std::vector<Building*> mCoveringBuildings;
+};
+
+#endif // TILEHOTSTATE_H
@@ -0,0 +1,444 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/VisionMap.h"
+
+#include "entities/Creature.h"
+#include "entities/CreatureDefinition.h"
+#include "entities/Tile.h"
+#include "game/Seat.h"
+#include "gamemap/GameMap.h"
+#include "spells/Spell.h"
+#include "utils/Helper.h"
+#include "utils/LogManager.h"
+#include "utils/ThreadPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+const uint32_t VisionMap::CREATURES_PER_TASK = 8;
+
+//! \brief Size (in tiles) of the cells the blockable sources are sorted in
+static const int SOURCE_CELL_SIZE = 8;
+
+VisionMap::VisionMap() :
+    mIsInitialized(false),
+    mNbTiles(0),
+    mMapSizeX(0),
+    mIsFOWDeactivated(false),
+    mNbCellsX(0),
+    mNbCellsY(0),
+    mBlockableRadiusMax(0)
+{
+}
+
+void VisionMap::clear()
+{
+    mIsInitialized = false;
+    mSeats.clear();
+    mNbTiles = 0;
+    mMapSizeX = 0;
+    mCoverage.clear();
+    mOwnVision.clear();
+    mAlliedSeatIndexes.clear();
+    mTeamVision.clear();
+    mTmpVision.resize(0);
+    mDirtyTileSources.clear();
+    mIsTileSourceDirty.clear();
+    mIsFOWDeactivated = false;
+    mSources.clear();
+    mBlockableSourceCells.clear();
+    mNbCellsX = 0;
+    mNbCellsY = 0;
+    mBlockableRadiusMax = 0;
+    mCreaturesToUpdate.clear();
+    mWorkerLinesOfSight.clear();
+}
+
+void VisionMap::initialize(GameMap& gameMap)
+{
+    mSeats = gameMap.getSeats();
+    mNbTiles = gameMap.getNbTiles();
+    mMapSizeX = gameMap.getMapSizeX();
+    uint32_t nbSeats = static_cast<uint32_t>(mSeats.size());
+    mCoverage.assign(nbSeats * mNbTiles, 0);
+    mOwnVision.assign(nbSeats, BitVector());
+    mTeamVision.assign(nbSeats, BitVector());
+    mAlliedSeatIndexes.assign(nbSeats, std::vector<uint32_t>());
+    for(uint32_t seatIndex = 0; seatIndex < nbSeats; ++seatIndex)
+    {
+        mOwnVision[seatIndex].resize(mNbTiles);
+        mTeamVision[seatIndex].resize(mNbTiles);
+        std::vector<uint32_t>& alliedSeatIndexes = mAlliedSeatIndexes[seatIndex];
+        alliedSeatIndexes.push_back(seatIndex);
+        for(Seat* alliedSeat : mSeats[seatIndex]->getAlliedSeats())
+        {
+            int32_t alliedSeatIndex = getSeatIndex(alliedSeat);
+            if(alliedSeatIndex < 0)
+                continue;
+
+            uint32_t index = static_cast<uint32_t>(alliedSeatIndex);
+            if(std::find(alliedSeatIndexes.begin(), alliedSeatIndexes.end(), index) != alliedSeatIndexes.end())
+                continue;
+
+            alliedSeatIndexes.push_back(index);
+        }
+    }
+    mTmpVision.resize(mNbTiles);
+    mIsFOWDeactivated = false;
+    mSources.clear();
+    mNbCellsX = (gameMap.getMapSizeX() + SOURCE_CELL_SIZE - 1) / SOURCE_CELL_SIZE;
+    mNbCellsY = (gameMap.getMapSizeY() + SOURCE_CELL_SIZE - 1) / SOURCE_CELL_SIZE;
+    mBlockableSourceCells.assign(static_cast<uint32_t>(mNbCellsX * mNbCellsY), std::vector<Source*>());
+    mBlockableRadiusMax = 0;
+
+    // Every claimed tile will register itself at the first update
+    mIsTileSourceDirty.assign(mNbTiles, 1);
+    mDirtyTileSources.resize(mNbTiles);
+    for(uint32_t tileIndex = 0; tileIndex < mNbTiles; ++tileIndex)
+    {
+        mDirtyTileSources[tileIndex] = tileIndex;
+        gameMap.getTileByIndex(tileIndex)->clearVision();
+    }
+
+    for(Seat* seat : mSeats)
+        seat->clearTilesWithVision();
+
+    mIsInitialized = true;
+}
+
+int32_t VisionMap::getSeatIndex(const Seat* seat) const
+{
+    for(uint32_t seatIndex = 0; seatIndex < mSeats.size(); ++seatIndex)
+    {
+        if(mSeats[seatIndex] == seat)
+            return static_cast<int32_t>(seatIndex);
+    }
+
+    return -1;
+}
+
+bool VisionMap::needsUpdate(const GameEntity& source, Seat* seat, const Tile* center, uint32_t radius) const
+{
+    std::map<const GameEntity*, Source>::const_iterator it = mSources.find(&source);
+    if(it == mSources.end())
+        return true;
+
+    const Source& visionSource = it->second;
+    if(visionSource.mIsDirty)
+        return true;
+    if(visionSource.mSeat != seat)
+        return true;
+    if(center == nullptr)
+        return true;
+    if((visionSource.mCenterX != center->getX()) || (visionSource.mCenterY != center->getY()))
+        return true;
+    if(visionSource.mRadius != radius)
+        return true;
+
+    return false;
+}
+
+void VisionMap::setSource(const GameEntity& source, Seat* seat, const Tile* center, uint32_t radius,
+    const std::vector<Tile*>& tiles, bool isBlockable)
+{
+    int32_t seatIndex = getSeatIndex(seat);
+    if(!mIsInitialized || (seatIndex < 0) || (center == nullptr))
+    {
+        removeSource(source);
+        return;
+    }
+
+    Source newSource;
+    newSource.mSeat = seat;
+    newSource.mCenterX = center->getX();
+    newSource.mCenterY = center->getY();
+    newSource.mRadius = radius;
+    newSource.mIsBlockable = isBlockable;
+    newSource.mIsDirty = false;
+    newSource.mSeatIndex = static_cast<uint32_t>(seatIndex);
+    newSource.mCellIndex = 0;
+
+    newSource.mTileIndexes.reserve(tiles.size());
+    for(Tile* tile : tiles)
+        newSource.mTileIndexes.push_back(static_cast<uint32_t>(tile->getX() + tile->getY() * mMapSizeX));
+
+    // We add the new tiles before removing the old ones so that the tiles still seen
+    // do not lose vision in between
+    addSourceCoverage(newSource);
+    std::map<const GameEntity*, Source>::iterator it = mSources.find(&source);
+    if(it == mSources.end())
+    {
+        it = mSources.insert(std::make_pair(&source, std::move(newSource))).first;
+        addBlockableSource(it->second);
+        return;
+    }
+
+    removeSourceCoverage(it->second);
+    removeBlockableSource(it->second);
+    it->second = std::move(newSource);
+    addBlockableSource(it->second);
+}
+
+void VisionMap::removeSource(const GameEntity& source)
+{
+    std::map<const GameEntity*, Source>::iterator it = mSources.find(&source);
+    if(it == mSources.end())
+        return;
+
+    removeSourceCoverage(it->second);
+    removeBlockableSource(it->second);
+    mSources.erase(it);
+}
+
+void VisionMap::notifyTileVisionChanged(const Tile& tile)
+{
+    if(!mIsInitialized)
+        return;
+
+    // Only the cells that may contain the center of a source seeing the tile are checked
+    int radiusMax = static_cast<int>(mBlockableRadiusMax);
+    int cellXMin = std::max(tile.getX() - radiusMax, 0) / SOURCE_CELL_SIZE;
+    int cellXMax = std::min((tile.getX() + radiusMax) / SOURCE_CELL_SIZE, mNbCellsX - 1);
+    int cellYMin = std::max(tile.getY() - radiusMax, 0) / SOURCE_CELL_SIZE;
+    int cellYMax = std::min((tile.getY() + radiusMax) / SOURCE_CELL_SIZE, mNbCellsY - 1);
+    for(int cellY = cellYMin; cellY <= cellYMax; ++cellY)
+    {
+        for(int cellX = cellXMin; cellX <= cellXMax; ++cellX)
+        {
+            for(Source* source : mBlockableSourceCells[cellX + cellY * mNbCellsX])
+            {
+                if(source->mIsDirty)
+                    continue;
+
+                int radius = static_cast<int>(source->mRadius);
+                if(std::abs(tile.getX() - source->mCenterX) > radius)
+                    continue;
+                if(std::abs(tile.getY() - source->mCenterY) > radius)
+                    continue;
+
+                source->mIsDirty = true;
+            }
+        }
+    }
+}
+
+void VisionMap::notifyTileClaimChanged(uint32_t tileIndex)
+{
+    if(!mIsInitialized)
+        return;
+
+    if(tileIndex >= mNbTiles)
+        return;
+
+    if(mIsTileSourceDirty[tileIndex] != 0)
+        return;
+
+    mIsTileSourceDirty[tileIndex] = 1;
+    mDirtyTileSources.push_back(tileIndex);
+}
+
+void VisionMap::update(GameMap& gameMap)
+{
+    if(!mIsInitialized || (mSeats != gameMap.getSeats()) || (mNbTiles != gameMap.getNbTiles()))
+        initialize(gameMap);
+
+    // If the FOW is deactivated, we allow vision for every seat
+    bool isFOWDeactivated = !gameMap.getIsFOWActivated();
+    if(isFOWDeactivated != mIsFOWDeactivated)
+    {
+        mIsFOWDeactivated = isFOWDeactivated;
+        for(uint32_t seatIndex = 0; seatIndex < mSeats.size(); ++seatIndex)
+        {
+            for(uint32_t tileIndex = 0; tileIndex < mNbTiles; ++tileIndex)
+            {
+                if(isFOWDeactivated)
+                    addCoverage(seatIndex, tileIndex);
+                else
+                    removeCoverage(seatIndex, tileIndex);
+            }
+        }
+    }
+
+    for(uint32_t tileIndex : mDirtyTileSources)
+    {
+        mIsTileSourceDirty[tileIndex] = 0;
+        gameMap.getTileByIndex(tileIndex)->computeVisibleTiles();
+    }
+    mDirtyTileSources.clear();
+
+    // Creatures and spells only recompute their visible tiles if needed
+    mCreaturesToUpdate.clear();
+    for(Creature* creature : gameMap.getCreatures())
+    {
+        if(creature->needsTilesInSightUpdate())
+            mCreaturesToUpdate.push_back(creature);
+    }
+    updateCreaturesTilesInSight(gameMap, mCreaturesToUpdate);
+    for(Creature* creature : mCreaturesToUpdate)
+        creature->setVisionSource();
+    mCreaturesToUpdate.clear();
+
+    for(Spell* spell : gameMap.getSpells())
+        spell->computeVisibleTiles();
+
+    applyChangedVision(gameMap);
+}
+
+bool VisionMap::hasVision(const Seat* seat, uint32_t tileIndex) const
+{
+    int32_t seatIndex = getSeatIndex(seat);
+    if((seatIndex < 0) || (tileIndex >= mNbTiles))
+        return false;
+
+    return mTeamVision[static_cast<uint32_t>(seatIndex)].test(tileIndex);
+}
+
+void VisionMap::addCoverage(uint32_t seatIndex, uint32_t tileIndex)
+{
+    uint32_t index = seatIndex * mNbTiles + tileIndex;
+    ++mCoverage[index];
+    if(mCoverage[index] != 1)
+        return;
+
+    mOwnVision[seatIndex].set(tileIndex, true);
+}
+
+void VisionMap::removeCoverage(uint32_t seatIndex, uint32_t tileIndex)
+{
+    uint32_t index = seatIndex * mNbTiles + tileIndex;
+    if(mCoverage[index] == 0)
+    {
+        OD_LOG_ERR("Removing vision not given seatIndex=" + Helper::toString(seatIndex)
+            + ", tileIndex=" + Helper::toString(tileIndex));
+        return;
+    }
+
+    --mCoverage[index];
+    if(mCoverage[index] != 0)
+        return;
+
+    mOwnVision[seatIndex].set(tileIndex, false);
+}
+
+void VisionMap::addSourceCoverage(const Source& source)
+{
+    for(uint32_t tileIndex : source.mTileIndexes)
+        addCoverage(source.mSeatIndex, tileIndex);
+}
+
+void VisionMap::removeSourceCoverage(const Source& source)
+{
+    for(uint32_t tileIndex : source.mTileIndexes)
+        removeCoverage(source.mSeatIndex, tileIndex);
+}
+
+void VisionMap::addBlockableSource(Source& source)
+{
+    if(!source.mIsBlockable)
+        return;
+
+    int cellX = source.mCenterX / SOURCE_CELL_SIZE;
+    int cellY = source.mCenterY / SOURCE_CELL_SIZE;
+    source.mCellIndex = static_cast<uint32_t>(cellX + cellY * mNbCellsX);
+    mBlockableSourceCells[source.mCellIndex].push_back(&source);
+    mBlockableRadiusMax = std::max(mBlockableRadiusMax, source.mRadius);
+}
+
+void VisionMap::removeBlockableSource(const Source& source)
+{
+    if(!source.mIsBlockable)
+        return;
+
+    // The order of the sources within a cell does not matter
+    std::vector<Source*>& cell = mBlockableSourceCells[source.mCellIndex];
+    std::vector<Source*>::iterator it = std::find(cell.begin(), cell.end(), &source);
+    if(it == cell.end())
+    {
+        OD_LOG_ERR("Blockable source not found in cell=" + Helper::toString(source.mCellIndex));
+        return;
+    }
+
+    *it = cell.back();
+    cell.pop_back();
+}
+
+void VisionMap::applyChangedVision(GameMap& gameMap)
+{
+    for(uint32_t seatIndex = 0; seatIndex < mSeats.size(); ++seatIndex)
+    {
+        // Allied seats share their vision
+        const std::vector<uint32_t>& alliedSeatIndexes = mAlliedSeatIndexes[seatIndex];
+        if(alliedSeatIndexes.size() == 1)
+            mTmpVision = mOwnVision[seatIndex];
+        else
+        {
+            mTmpVision.assignOr(mOwnVision[alliedSeatIndexes[0]], mOwnVision[alliedSeatIndexes[1]]);
+            for(uint32_t i = 2; i < alliedSeatIndexes.size(); ++i)
+                mTmpVision.orWith(mOwnVision[alliedSeatIndexes[i]]);
+        }
+
+        // A tile may have gained and lost vision during the same turn. We only notify the
+        // tiles that differ from the last update
+        Seat* seat = mSeats[seatIndex];
+        BitVector::forEachDifference(mTmpVision, mTeamVision[seatIndex], [&](uint32_t tileIndex, bool hasVision)
+        {
+            Tile* tile = gameMap.getTileByIndex(tileIndex);
+            tile->setSeatHasVision(seat, hasVision);
+            seat->notifyVisionOnTile(tile, hasVision);
+        });
+        std::swap(mTmpVision, mTeamVision[seatIndex]);
+    }
+}
+
+void VisionMap::updateCreaturesTilesInSight(GameMap& gameMap, const std::vector<Creature*>& creatures)
+{
+    ThreadPool& threadPool = gameMap.getThreadPool();
+    if((threadPool.getNbWorkers() == 0) ||
+       (creatures.size() < 2 * CREATURES_PER_TASK))
+    {
+        for(Creature* creature : creatures)
+            creature->updateTilesInSight();
+
+        return;
+    }
+
+    // The workers only read the tile distances. We compute them before for the highest sight
+    LineOfSight& lineOfSight = gameMap.getLineOfSight();
+    int sightRadiusMax = 0;
+    for(Creature* creature : creatures)
+        sightRadiusMax = std::max(sightRadiusMax, creature->getDefinition()->getSightRadius());
+    lineOfSight.buildTileDistance(sightRadiusMax);
+
+    // The tile distances only depend on the distance they were computed for. Copies with the same
+    // distance as the game map will order the visible tiles the same way
+    for(uint32_t i = 0; i < threadPool.getNbSlots(); ++i)
+    {
+        if(i >= mWorkerLinesOfSight.size())
+            mWorkerLinesOfSight.push_back(lineOfSight);
+        else if(mWorkerLinesOfSight[i].getTileDistanceComputed() != lineOfSight.getTileDistanceComputed())
+            mWorkerLinesOfSight[i] = lineOfSight;
+    }
+
+    threadPool.parallelFor(0, static_cast<uint32_t>(creatures.size()), CREATURES_PER_TASK,
+        [this, &creatures, &threadPool](uint32_t begin, uint32_t end)
+    {
+        LineOfSight& workerLineOfSight = mWorkerLinesOfSight[threadPool.getCurrentSlot()];
+        for(uint32_t index = begin; index < end; ++index)
+            creatures[index]->updateTilesInSight(workerLineOfSight);
+    });
+}
@@ -0,0 +1,174 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VISIONMAP_H
+#define VISIONMAP_H
+
+#include "gamemap/LineOfSight.h"
+#include "utils/BitVector.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+class Creature;
+class GameEntity;
+class GameMap;
+class Seat;
+class Tile;
+
+/*! \brief Keeps the tiles each seat has vision on, on server side.
+ *
+ * Vision is given by sources (claimed tiles, creatures, spells). Each source registers the tiles
+ * it sees and the map counts, for every seat and every tile, how many sources owned by the seat give
+ * vision. The tiles with a count above 0 are kept in a bitset per seat.
+ * Sources are only recomputed when they move, change owner or radius, or when a tile blocking
+ * vision changes near them. Once per turn, update computes the vision of each seat by OR-ing the
+ * bitsets of its allies with its own and applies the bits that changed since the last turn to the
+ * tiles (Tile::getSeatsWithVision) and to the seats (Seat::hasVisionOnTile).
+ * The creatures that need to recompute the tiles they see do it on the thread pool since it only
+ * reads the map. Their sources are then updated on the main thread. As the coverage does not
+ * depend on the order the sources are updated in, the result is the same as a serial update.
+ */
+class VisionMap
+{
+public:
+    VisionMap();
+
+    //! \brief Forgets every source. Vision will be computed again from scratch at the next update
+    void clear();
+
+    //! \brief Returns true if the given source has to recompute the tiles it sees. That happens if it
+    //! has no tiles registered yet, if it moved, if its seat or radius changed or if a tile blocking
+    //! vision changed within its radius
+    bool needsUpdate(const GameEntity& source, Seat* seat, const Tile* center, uint32_t radius) const;
+
+    //! \brief Sets the tiles seen by the given source for its seat. If isBlockable is true, the source will have to be recomputed when a tile within its
+    //! radius starts or stops blocking vision
+    void setSource(const GameEntity& source, Seat* seat, const Tile* center, uint32_t radius,
+        const std::vector<Tile*>& tiles, bool isBlockable);
+
+    //! \brief Removes the vision given by the source. Should be called when the source stops giving
+    //! vision or is removed from the game map
+    void removeSource(const GameEntity& source);
+
+    //! \brief Should be called when the tile may start or stop blocking vision (dug, door locked, ...)
+    void notifyTileVisionChanged(const Tile& tile);
+
+    //! \brief Should be called when the tile with the given index is claimed or changes owner
+    void notifyTileClaimChanged(uint32_t tileIndex);
+
+    //! \brief Recomputes the sources that changed and notifies the tiles and seats whose vision changed.
+    //! Called once per turn on server side
+    void update(GameMap& gameMap);
+
+    //! \brief Returns true if the given seat has vision on the tile with the given index
+    bool hasVision(const Seat* seat, uint32_t tileIndex) const;
+
+    //! \brief Number of creatures updated by each task of the thread pool. If there are less than
+    //! two tasks to run, the creatures are updated on the main thread
+    static const uint32_t CREATURES_PER_TASK;
+
+private:
+    struct Source
+    {
+        uint32_t mSeatIndex;
+        std::vector<uint32_t> mTileIndexes;
+        Seat* mSeat;
+        int mCenterX;
+        int mCenterY;
+        uint32_t mRadius;
+        bool mIsBlockable;
+        bool mIsDirty;
+        //! \brief Index in mBlockableSourceCells of the cell containing the center of blockable sources
+        uint32_t mCellIndex;
+    };
+
+    //! \brief Resets every count for the seats and tiles of the given game map
+    void initialize(GameMap& gameMap);
+
+    //! \brief Returns the index of the seat in mSeats or -1 if not found
+    int32_t getSeatIndex(const Seat* seat) const;
+
+    void addCoverage(uint32_t seatIndex, uint32_t tileIndex);
+    void removeCoverage(uint32_t seatIndex, uint32_t tileIndex);
+    void addSourceCoverage(const Source& source);
+    void removeSourceCoverage(const Source& source);
+
+    //! \brief Adds (or removes) the given source to the cell of its center if it is blockable
+    void addBlockableSource(Source& source);
+    void removeBlockableSource(const Source& source);
+
+    //! \brief Computes the vision of every seat and notifies the tiles and seats about the
+    //! vision that changed since the last call
+    void applyChangedVision(GameMap& gameMap);
+
+    //! \brief Calls Creature::updateTilesInSight for the given creatures. If there are enough of
+    //! them, they are split between the threads of the game map thread pool
+    void updateCreaturesTilesInSight(GameMap& gameMap, const std::vector<Creature*>& creatures);
+
+    bool mIsInitialized;
+
+    //! \brief Seats of the game map when initialized. Their index is used in mCoverage
+    std::vector<Seat*> mSeats;
+
+    uint32_t mNbTiles;
+    int mMapSizeX;
+
+    //! \brief Number of sources giving vision, indexed by seatIndex * mNbTiles + tileIndex
+    std::vector<uint16_t> mCoverage;
+
+    //! \brief Tiles seen by the sources of each seat (mCoverage > 0), indexed like mSeats
+    std::vector<BitVector> mOwnVision;
+
+    //! \brief For each seat, the index of the seat and of its allies in mSeats
+    std::vector<std::vector<uint32_t>> mAlliedSeatIndexes;
+
+    //! \brief Vision of each seat (its own and its allies') applied at the last update
+    std::vector<BitVector> mTeamVision;
+
+    //! \brief Used to compute the new vision of a seat in applyChangedVision
+    BitVector mTmpVision;
+
+    //! \brief Tiles that were claimed or changed owner since the last update
+    std::vector<uint32_t> mDirtyTileSources;
+    std::vector<uint8_t> mIsTileSourceDirty;
+
+    //! \brief True if the whole map is currently visible for every seat because the fog of war
+    //! is not activated
+    bool mIsFOWDeactivated;
+
+    std::map<const GameEntity*, Source> mSources;
+
+    //! \brief Blockable sources (pointing to mSources) by the cell of SOURCE_CELL_SIZE tiles containing
+    //! their center. Used to find the sources near a tile whose vision changed without going through
+    //! every source
+    std::vector<std::vector<Source*>> mBlockableSourceCells;
+    int mNbCellsX;
+    int mNbCellsY;
+
+    //! \brief Greatest radius of the blockable sources registered since the map was initialized
+    uint32_t mBlockableRadiusMax;
+
+    //! \brief Creatures whose visible tiles are recomputed during the current update
+    std::vector<Creature*> mCreaturesToUpdate;
+
+    //! \brief LineOfSight is not thread safe. Each slot of the thread pool uses its own copy of the game map one
+    std::vector<LineOfSight> mWorkerLinesOfSight;
+};
+
+#endif // VISIONMAP_H
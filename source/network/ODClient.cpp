@@ -433,13 +433,12 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
 
         case ServerNotificationType::removeEntity:
         {
-            GameEntityType entityType;
-            std::string entityName;
-            OD_ASSERT_TRUE(packetReceived >> entityType >> entityName);
-            GameEntity* entity = gameMap->getEntityFromTypeAndName(entityType, entityName);
+            uint32_t networkId;
+            OD_ASSERT_TRUE(packetReceived >> networkId);
+            GameEntity* entity = gameMap->getEntityFromNetworkId(networkId);
             if(entity == nullptr)
             {
-                OD_LOG_ERR("entityType=" + Helper::toString(static_cast<int32_t>(entityType)) + ", entityName=" + entityName);
+                OD_LOG_ERR("networkId=" + Helper::toString(networkId));
                 break;
             }
 
@@ -473,19 +472,19 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
 
         case ServerNotificationType::animatedObjectSetWalkPath:
         {
-            std::string objName;
+            uint32_t networkId;
             std::string walkAnim;
             std::string endAnim;
             bool loopEndAnim;
             bool playIdleWhenAnimationEnds;
             uint32_t nbDest;
-            OD_ASSERT_TRUE(packetReceived >> objName >> walkAnim >> endAnim);
+            OD_ASSERT_TRUE(packetReceived >> networkId >> walkAnim >> endAnim);
             OD_ASSERT_TRUE(packetReceived >> loopEndAnim >> playIdleWhenAnimationEnds >> nbDest);
 
-            MovableGameEntity *tempAnimatedObject = gameMap->getAnimatedObject(objName);
+            MovableGameEntity *tempAnimatedObject = gameMap->getEntityFromNetworkId(networkId);
             if(tempAnimatedObject == nullptr)
             {
-                OD_LOG_ERR("objName=" + objName);
+                OD_LOG_ERR("networkId=" + Helper::toString(networkId));
                 break;
             }
 
@@ -552,17 +551,17 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
 
         case ServerNotificationType::setObjectAnimationState:
         {
-            std::string objName;
+            uint32_t networkId;
             std::string animState;
             bool loop;
             bool playIdleWhenAnimationEnds;
             bool shouldSetWalkDirection;
-            OD_ASSERT_TRUE(packetReceived >> objName >> animState
+            OD_ASSERT_TRUE(packetReceived >> networkId >> animState
                 >> loop >> playIdleWhenAnimationEnds >> shouldSetWalkDirection);
-            MovableGameEntity *obj = gameMap->getAnimatedObject(objName);
+            MovableGameEntity *obj = gameMap->getEntityFromNetworkId(networkId);
             if (obj == nullptr)
             {
-                OD_LOG_ERR("objName=" + objName + ", state=" + animState);
+                OD_LOG_ERR("networkId=" + Helper::toString(networkId) + ", state=" + animState);
                 break;
             }
 
@@ -590,18 +589,16 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
         case ServerNotificationType::entitiesRefresh:
         {
             uint32_t nbEntities;
-            GameEntityType entityType;
-            std::string entityName;
+            uint32_t networkId;
             OD_ASSERT_TRUE(packetReceived >> nbEntities);
             while(nbEntities > 0)
             {
                 --nbEntities;
-                OD_ASSERT_TRUE(packetReceived >> entityType);
-                OD_ASSERT_TRUE(packetReceived >> entityName);
-                GameEntity* entity = gameMap->getEntityFromTypeAndName(entityType, entityName);
+                OD_ASSERT_TRUE(packetReceived >> networkId);
+                GameEntity* entity = gameMap->getEntityFromNetworkId(networkId);
                 if(entity == nullptr)
                 {
-                    OD_LOG_ERR("entityType=" + Helper::toString(static_cast<int32_t>(entityType)) + ", entityName=" + entityName);
+                    OD_LOG_ERR("networkId=" + Helper::toString(networkId));
                     break;
                 }
 
@@ -757,28 +754,19 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
 
         case ServerNotificationType::refreshVisibleTiles:
         {
-            uint32_t nbTiles;
             // Tiles we gained vision
-            OD_ASSERT_TRUE(packetReceived >> nbTiles);
-            while(nbTiles > 0)
+            std::vector<Tile*> tiles;
+            OD_ASSERT_TRUE(gameMap->tilesFromPacket(packetReceived, tiles));
+            for(Tile* tile : tiles)
             {
-                --nbTiles;
-                Tile* tile = gameMap->tileFromPacket(packetReceived);
-                if(tile == nullptr)
-                    continue;
-
                 tile->setLocalPlayerHasVision(true);
                 tile->refreshMesh();
             }
             // Tiles we lost vision
-            OD_ASSERT_TRUE(packetReceived >> nbTiles);
-            while(nbTiles > 0)
+            tiles.clear();
+            OD_ASSERT_TRUE(gameMap->tilesFromPacket(packetReceived, tiles));
+            for(Tile* tile : tiles)
             {
-                --nbTiles;
-                Tile* tile = gameMap->tileFromPacket(packetReceived);
-                if(tile == nullptr)
-                    continue;
-
                 tile->setLocalPlayerHasVision(false);
                 tile->refreshMesh();
             }
@@ -828,21 +816,21 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
 
         case ServerNotificationType::carryEntity:
         {
-            std::string carrierName;
-            GameEntityType entityType;
-            std::string carriedName;
-            OD_ASSERT_TRUE(packetReceived >> carrierName >> entityType >> carriedName);
-            Creature* carrier = gameMap->getCreature(carrierName);
-            if(carrier == nullptr)
+            uint32_t carrierId;
+            uint32_t carriedId;
+            OD_ASSERT_TRUE(packetReceived >> carrierId >> carriedId);
+            MovableGameEntity* carrierEntity = gameMap->getEntityFromNetworkId(carrierId);
+            if((carrierEntity == nullptr) || (carrierEntity->getObjectType() != GameEntityType::creature))
             {
-                OD_LOG_ERR("carrierName=" + carrierName);
+                OD_LOG_ERR("carrierId=" + Helper::toString(carrierId));
                 break;
             }
+            Creature* carrier = static_cast<Creature*>(carrierEntity);
 
-            GameEntity* carried = gameMap->getEntityFromTypeAndName(entityType, carriedName);
+            GameEntity* carried = gameMap->getEntityFromNetworkId(carriedId);
             if(carried == nullptr)
             {
-                OD_LOG_ERR("entityType=" + Helper::toString(static_cast<int32_t>(entityType)) + ", carriedName=" + carriedName);
+                OD_LOG_ERR("carriedId=" + Helper::toString(carriedId));
                 break;
             }
 
@@ -854,22 +842,22 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
 
         case ServerNotificationType::releaseCarriedEntity:
         {
-            std::string carrierName;
-            GameEntityType entityType;
-            std::string carriedName;
+            uint32_t carrierId;
+            uint32_t carriedId;
             Ogre::Vector3 pos;
-            OD_ASSERT_TRUE(packetReceived >> carrierName >> entityType >> carriedName >> pos);
-            Creature* carrier = gameMap->getCreature(carrierName);
-            if(carrier == nullptr)
+            OD_ASSERT_TRUE(packetReceived >> carrierId >> carriedId >> pos);
+            MovableGameEntity* carrierEntity = gameMap->getEntityFromNetworkId(carrierId);
+            if((carrierEntity == nullptr) || (carrierEntity->getObjectType() != GameEntityType::creature))
             {
-                OD_LOG_ERR("carrierName=" + carrierName);
+                OD_LOG_ERR("carrierId=" + Helper::toString(carrierId));
                 break;
             }
+            Creature* carrier = static_cast<Creature*>(carrierEntity);
 
-            GameEntity* carried = gameMap->getEntityFromTypeAndName(entityType, carriedName);
+            GameEntity* carried = gameMap->getEntityFromNetworkId(carriedId);
             if(carried == nullptr)
             {
-                OD_LOG_ERR("entityType=" + Helper::toString(static_cast<int32_t>(entityType)) + ", carriedName=" + carriedName);
+                OD_LOG_ERR("carriedId=" + Helper::toString(carriedId));
                 break;
             }
 
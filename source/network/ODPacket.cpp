@@ -240,6 +240,11 @@ ODPacket::operator bool() const
     return mPacket;
 }
 
+std::size_t ODPacket::getDataSize() const
+{
+    return mPacket.getDataSize();
+}
+
 void ODPacket::clear()
 {
     mPacket.clear();
@@ -125,6 +125,9 @@ class ODPacket
          */
         void clear();
 
+        //! \brief Returns the size in bytes of the data in the packet
+        std::size_t getDataSize() const;
+
         /*! \brief Writes the packet content to the given ofstream.
          */
         void writePacket(int32_t timestamp, std::ofstream& os);
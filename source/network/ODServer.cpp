@@ -253,7 +253,7 @@ void ODServer::sendMsg(Player* player, ODPacket& packet)
     {
         // If player is nullptr, we send the message to every connected player
         for (ODSocketClient* client : mSockClients)
-            client->send(packet);
+            sendToClient(client, packet);
 
         return;
     }
@@ -270,7 +270,7 @@ void ODServer::sendMsg(Player* player, ODPacket& packet)
     }
 
     if(client != nullptr)
-        client->send(packet);
+        sendToClient(client, packet);
 }
 
 void ODServer::handleConsoleCommand(Player* player, GameMap* gameMap, const std::vector<std::string>& args)
@@ -395,12 +395,21 @@ void ODServer::serverThread()
     GameMap* gameMap = mGameMap;
     sf::Clock clock;
     double turnLengthMs = 1000.0 / ODApplication::turnsPerSecond;
+    // The turns are paced by this clock only: the network thread handles the sockets meanwhile
+    sf::Clock turnClock;
+    double nextTurnMs = turnLengthMs;
     bool isClientConnected = true;
     while(isConnected() && isClientConnected)
     {
-        // doTask should return after the length of 1 turn even if their are communications. When
-        // it returns, we can launch next turn.
-        doTask(static_cast<int32_t>(turnLengthMs));
+        // doTask handles the client messages until it is time for the next turn. If the last
+        // turn was too long, it only handles the messages already received.
+        doTask(static_cast<int32_t>(nextTurnMs - turnClock.getElapsedTime().asMilliseconds()));
+        nextTurnMs += turnLengthMs;
+        // If we are late, the next turn starts as soon as possible but we do not try to catch up the missed ones
+        double elapsedMs = static_cast<double>(turnClock.getElapsedTime().asMilliseconds());
+        if(nextTurnMs < elapsedMs)
+            nextTurnMs = elapsedMs;
+
         // If all the clients are disconnected during a game, we close the server
         if((mServerState == ServerState::StateGame) &&
            (mSockClients.empty()))
@@ -586,17 +595,14 @@ void ODServer::processServerNotifications()
     }
 }
 
-bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
+bool ODServer::processClientNotifications(ODSocketClient* clientSocket, ODSocketClient::ODComStatus status,
+    ODPacket& packetReceived)
 {
     if (!clientSocket)
         return false;
 
     GameMap* gameMap = mGameMap;
 
-    ODPacket packetReceived;
-
-    ODSocketClient::ODComStatus status = clientSocket->recv(packetReceived);
-
     // If the client closed the connection
     if (status != ODSocketClient::ODComStatus::OK)
     {
@@ -639,7 +645,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
             mPlayerConfig = otherHumanConnected->getPlayer();
             ODPacket packetSend;
             packetSend << ServerNotificationType::playerConfigChange;
-            otherHumanConnected->send(packetSend);
+            sendToClient(otherHumanConnected, packetSend);
 
             OD_LOG_INF("Changing game host to " + mPlayerConfig->getNick());
         }
@@ -759,7 +765,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
                 gameMap->tileToPacket(packet, tile);
             }
 
-            clientSocket->send(packet);
+            sendToClient(clientSocket, packet);
             break;
         }
 
@@ -772,7 +778,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
             // Tell the client to give us their nickname
             ODPacket packetSend;
             packetSend << ServerNotificationType::pickNick << mServerMode;
-            clientSocket->send(packetSend);
+            sendToClient(clientSocket, packetSend);
             break;
         }
 
@@ -814,7 +820,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
                 mPlayerConfig = curPlayer;
                 ODPacket packetSend;
                 packetSend << ServerNotificationType::playerConfigChange;
-                clientSocket->send(packetSend);
+                sendToClient(clientSocket, packetSend);
             }
 
             Seat* seat = seats[0];
@@ -831,11 +837,11 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
             int32_t teamId = 0;
             seat->setMapSize(gameMap->getMapSizeX(), gameMap->getMapSizeY());
             packetSend << nick << id << seatId << teamId;
-            clientSocket->send(packetSend);
+            sendToClient(clientSocket, packetSend);
 
             packetSend.clear();
             packetSend << ServerNotificationType::startGameMode << seatId << mServerMode;
-            clientSocket->send(packetSend);
+            sendToClient(clientSocket, packetSend);
             mSeatsConfigured = true;
             break;
         }
@@ -852,7 +858,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
                 OD_LOG_INF("New player host: " + mPlayerConfig->getNick());
                 ODPacket packetSend;
                 packetSend << ServerNotificationType::playerConfigChange;
-                clientSocket->send(packetSend);
+                sendToClient(clientSocket, packetSend);
             }
 
             ODPacket packetSend;
@@ -866,7 +872,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
                 int32_t id = client->getPlayer()->getId();
                 packetSend << nick << id;
             }
-            clientSocket->send(packetSend);
+            sendToClient(clientSocket, packetSend);
 
             // Then, we notify the newly connected client to every client
             const std::string& clientNick = clientSocket->getPlayer()->getNick();
@@ -880,7 +886,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
                 if(clientSocket == client)
                     continue;
 
-                client->send(packetSend);
+                sendToClient(client, packetSend);
             }
 
             // Then we look for the first available human seat and assign the player there (if available)
@@ -1082,7 +1088,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
                         + Helper::toString(player->getId())
                         + ", nick=" + player->getNick());
                     client->setState("rejected");
-                    client->send(packetSend);
+                    sendToClient(client, packetSend);
                     delete player;
                     client->setPlayer(nullptr);
                 }
@@ -1109,7 +1115,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
                 ODPacket packetSend;
                 int seatId = client->getPlayer()->getSeat()->getId();
                 packetSend << ServerNotificationType::startGameMode << seatId << mServerMode;
-                client->send(packetSend);
+                sendToClient(client, packetSend);
             }
 
             for(Seat* seat : gameMap->getSeats())
@@ -1824,50 +1830,38 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
     return true;
 }
 
-ODSocketClient* ODServer::notifyNewConnection(sf::TcpListener& sockListener)
+bool ODServer::notifyNewConnection(ODSocketClient* newClient)
 {
-    ODSocketClient* newClient = new ODSocketClient;
-    sf::Socket::Status status = sockListener.accept(newClient->getSockClient());
-    if (status != sf::Socket::Done)
-    {
-        OD_LOG_ERR("Error while listening to socket status=" + Helper::toString(static_cast<uint32_t>(status)));
-        delete newClient;
-        return nullptr;
-    }
-
     switch(mServerState)
     {
         case ServerState::StateNone:
         {
             // It is not normal to receive new connexions while not connected. We are in an unexpected state
             OD_LOG_ERR("Unexpected none server mode");
-            delete newClient;
-            return nullptr;
+            return false;
         }
         case ServerState::StateConfiguration:
         {
             newClient->setState("connected");
-            return newClient;
+            return true;
         }
         case ServerState::StateGame:
         {
             // TODO : handle re-connexion if a client was disconnected and tries to reconnect
             OD_LOG_WRN("Received a reconnexion from a client while in game state");
-            delete newClient;
-            return nullptr;
+            return false;
         }
         default:
             OD_LOG_ERR("Unexpected server state=" + Helper::toString(static_cast<uint32_t>(mServerState)));
             break;
     }
 
-    delete newClient;
-    return nullptr;
+    return false;
 }
 
-bool ODServer::notifyClientMessage(ODSocketClient *clientSocket)
+bool ODServer::notifyClientMessage(ODSocketClient *clientSocket, ODSocketClient::ODComStatus status, ODPacket& packet)
 {
-    bool ret = processClientNotifications(clientSocket);
+    bool ret = processClientNotifications(clientSocket, status, packet);
     if(!ret)
     {
         std::string nick = clientSocket->getPlayer() ? clientSocket->getPlayer()->getNick() : std::string();
@@ -47,6 +47,8 @@ ODPacket& operator>>(ODPacket& is, EventShortNoticeType& type);
  * a "copy" from the server gamemap containing only the useful information for the player.
  * The server has its own thread to update the server gamemap. When a relevant change occurs,
  * the server sends messages to the clients so that they know they should update the client gamemaps.
+ * The sockets themselves are handled by a network thread (see ODSocketServer): the server thread
+ * only queues the packets to send and handles the received ones in doTask.
  * The server gamemap should only be accessed from the server thread because it is not thread safe.
  * and the server thread should never be used for calling functions from the client gamemap.
  * As a consequence, ODFrameListener.h should not be included is ODServer.cpp
@@ -96,8 +98,8 @@ class ODServer: public Ogre::Singleton<ODServer>,
     int32_t getNetworkPort() const;
 
 protected:
-    ODSocketClient* notifyNewConnection(sf::TcpListener& sockListener) override;
-    bool notifyClientMessage(ODSocketClient *sock) override;
+    bool notifyNewConnection(ODSocketClient* sock) override;
+    bool notifyClientMessage(ODSocketClient *sock, ODSocketClient::ODComStatus status, ODPacket& packet) override;
     void serverThread() override;
 
 private:
@@ -136,14 +138,15 @@ private:
      */
     void processServerNotifications();
 
-    /*! \brief The function running in server-mode which listens for messages from an individual, already connected, client.
+    /*! \brief The function running in server-mode which handles the messages from an individual, already connected, client.
      *
-     * This function receives TCP packets one at a time from a connected client,
-     * decodes them, and carries out requests for the client, returning any
-     * results.
+     * This function is called for each TCP packet the network thread received from a connected client
+     * (or when receiving failed if status is not OK). It decodes the packet and carries out requests for
+     * the client, returning any results.
      * \returns false When the client has disconnected.
      */
-    bool processClientNotifications(ODSocketClient* clientSocket);
+    bool processClientNotifications(ODSocketClient* clientSocket, ODSocketClient::ODComStatus status,
+        ODPacket& packetReceived);
 
     //! \brief Sends the packet to the given player. If player is nullptr, the packet is sent to every connected player
     void sendMsg(Player* player, ODPacket& packet);
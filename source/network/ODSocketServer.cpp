@@ -24,9 +24,15 @@
 
 #include <SFML/System.hpp>
 
+#include <algorithm>
+
+//! \brief Maximum time the network thread waits for the sockets before sending the queued packets
+const int32_t NETWORK_WAIT_MS = 5;
+
 ODSocketServer::ODSocketServer():
     mThread(nullptr),
-    mIsConnected(false)
+    mIsConnected(false),
+    mNetworkThread(nullptr)
 {
 }
 
@@ -52,6 +58,8 @@ bool ODSocketServer::createServer(int listeningPort)
     mSockSelector.add(mSockListener);
     mIsConnected = true;
     OD_LOG_INF("Server connected and listening");
+    mNetworkThread = new sf::Thread(&ODSocketServer::networkThread, this);
+    mNetworkThread->launch();
     mThread = new sf::Thread(&ODSocketServer::serverThread, this);
     mThread->launch();
 
@@ -66,60 +74,145 @@ bool ODSocketServer::isConnected()
 void ODSocketServer::doTask(int timeoutMs)
 {
     mClockMainTask.restart();
-    while((timeoutMs == 0) ||
-          (timeoutMs > mClockMainTask.getElapsedTime().asMilliseconds()))
+    while(mIsConnected)
     {
-        bool isSockReady;
-        if(timeoutMs != 0)
+        NetworkEvent event;
+        while(mReceivedEvents.tryPop(event))
         {
-            // We adapt the timeout so that the function returns after timeoutMs
-            // even if events occurred
-            int timeoutMsAdjusted = std::max(1, timeoutMs - mClockMainTask.getElapsedTime().asMilliseconds());
-            isSockReady = mSockSelector.wait(sf::milliseconds(timeoutMsAdjusted));
+            switch(event.mType)
+            {
+                case NetworkEventType::clientConnected:
+                {
+                    if(!notifyNewConnection(event.mClient))
+                    {
+                        // The server does not want to keep the client
+                        disconnectClient(event.mClient);
+                        break;
+                    }
+
+                    OD_LOG_INF("New client connected.");
+                    mSockClients.push_back(event.mClient);
+                    break;
+                }
+                case NetworkEventType::clientMessage:
+                {
+                    // Packets received from a client being removed are ignored. As the client is only deleted
+                    // after clientReleased, its address cannot be reused meanwhile
+                    if(std::find(mSockClients.begin(), mSockClients.end(), event.mClient) == mSockClients.end())
+                        break;
+
+                    if(!notifyClientMessage(event.mClient, event.mStatus, event.mPacket))
+                    {
+                        // The server wants to remove the client
+                        mSockClients.erase(std::remove(mSockClients.begin(), mSockClients.end(), event.mClient), mSockClients.end());
+                        disconnectClient(event.mClient);
+                    }
+
+                    break;
+                }
+                case NetworkEventType::clientReleased:
+                {
+                    delete event.mClient;
+                    break;
+                }
+                default:
+                    OD_LOG_ERR("Unexpected network event type=" + Helper::toString(static_cast<uint32_t>(event.mType)));
+                    break;
+            }
         }
-        else
+
+        if(timeoutMs <= mClockMainTask.getElapsedTime().asMilliseconds())
+            return;
+
+        // We wait a bit for the network thread to receive something
+        sf::sleep(sf::milliseconds(1));
+    }
+}
+
+void ODSocketServer::sendToClient(ODSocketClient* sock, const ODPacket& packet)
+{
+    OutgoingPacket outgoingPacket;
+    outgoingPacket.mClient = sock;
+    outgoingPacket.mIsDisconnect = false;
+    outgoingPacket.mPacket = packet;
+    mOutgoingPackets.push(outgoingPacket);
+}
+
+void ODSocketServer::disconnectClient(ODSocketClient* client)
+{
+    // The packets queued before are sent before the client is disconnected
+    OutgoingPacket outgoingPacket;
+    outgoingPacket.mClient = client;
+    outgoingPacket.mIsDisconnect = true;
+    mOutgoingPackets.push(outgoingPacket);
+}
+
+void ODSocketServer::networkThread()
+{
+    while(mIsConnected)
+    {
+        OutgoingPacket outgoingPacket;
+        while(mOutgoingPackets.tryPop(outgoingPacket))
         {
-            isSockReady = mSockSelector.wait(sf::Time::Zero);
+            ODSocketClient* client = outgoingPacket.mClient;
+            if(!outgoingPacket.mIsDisconnect)
+            {
+                client->send(outgoingPacket.mPacket);
+                continue;
+            }
+
+            mNetworkClients.erase(std::remove(mNetworkClients.begin(), mNetworkClients.end(), client), mNetworkClients.end());
+            mSockSelector.remove(client->getSockClient());
+            client->disconnect();
+
+            NetworkEvent event;
+            event.mType = NetworkEventType::clientReleased;
+            event.mClient = client;
+            mReceivedEvents.push(event);
         }
 
-        // Check if a client tries to connect or to communicate
-        if(!isSockReady)
+        // Check if a client tries to connect or to communicate. We do not wait too long to
+        // send the packets queued meanwhile
+        if(!mSockSelector.wait(sf::milliseconds(NETWORK_WAIT_MS)))
             continue;
 
         if(mSockSelector.isReady(mSockListener))
         {
             // New connection
-            ODSocketClient* newClient = notifyNewConnection(mSockListener);
-            if (newClient != nullptr)
+            ODSocketClient* newClient = new ODSocketClient;
+            sf::Socket::Status status = mSockListener.accept(newClient->getSockClient());
+            if (status != sf::Socket::Done)
+            {
+                OD_LOG_ERR("Error while listening to socket status=" + Helper::toString(static_cast<uint32_t>(status)));
+                delete newClient;
+            }
+            else
             {
-                // New connection
-                OD_LOG_INF("New client connected.");
-                // The server wants to keep the client
                 newClient->setSource(ODSocketClient::ODSource::network);
                 mSockSelector.add(newClient->getSockClient());
-                mSockClients.push_back(newClient);
+                mNetworkClients.push_back(newClient);
+
+                NetworkEvent event;
+                event.mType = NetworkEventType::clientConnected;
+                event.mClient = newClient;
+                mReceivedEvents.push(event);
             }
         }
-        else
-        {
 
-            for(std::vector<ODSocketClient*>::iterator it = mSockClients.begin(); it != mSockClients.end();)
-            {
-                ODSocketClient* client = *it;
-                if((mSockSelector.isReady(client->getSockClient())) &&
-                    (!notifyClientMessage(client)))
-                {
-                    // The server wants to remove the client
-                    it = mSockClients.erase(it);
-                    mSockSelector.remove(client->getSockClient());
-                    client->disconnect();
-                    delete client;
-                }
-                else
-                {
-                    ++it;
-                }
-            }
+        for(ODSocketClient* client : mNetworkClients)
+        {
+            if(!mSockSelector.isReady(client->getSockClient()))
+                continue;
+
+            NetworkEvent event;
+            event.mType = NetworkEventType::clientMessage;
+            event.mClient = client;
+            event.mStatus = client->recv(event.mPacket);
+            // If the connection is broken, we stop listening to the client until the server thread removes it
+            if(event.mStatus == ODSocketClient::ODComStatus::Error)
+                mSockSelector.remove(client->getSockClient());
+
+            mReceivedEvents.push(event);
         }
     }
 }
@@ -130,14 +223,32 @@ void ODSocketServer::stopServer()
     if(mThread != nullptr)
         delete mThread; // Delete waits for the thread to finish
     mThread = nullptr;
+    if(mNetworkThread != nullptr)
+        delete mNetworkThread;
+    mNetworkThread = nullptr;
     mSockSelector.clear();
     mSockListener.close();
-    for (std::vector<ODSocketClient*>::iterator it = mSockClients.begin(); it != mSockClients.end(); ++it)
+
+    // Now that both threads are stopped, we can empty the queues. The released clients are only
+    // referenced by their event
+    NetworkEvent event;
+    while(mReceivedEvents.tryPop(event))
+    {
+        if(event.mType == NetworkEventType::clientReleased)
+            delete event.mClient;
+    }
+    OutgoingPacket outgoingPacket;
+    while(mOutgoingPackets.tryPop(outgoingPacket))
+    {
+    }
+
+    for (std::vector<ODSocketClient*>::iterator it = mNetworkClients.begin(); it != mNetworkClients.end(); ++it)
     {
         ODSocketClient* client = *it;
         client->disconnect();
         delete client;
     }
 
+    mNetworkClients.clear();
     mSockClients.clear();
 }
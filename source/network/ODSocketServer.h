@@ -20,10 +20,19 @@
 
 #include "ODSocketClient.h"
 
+#include "utils/SpscQueue.h"
+
 #include <SFML/Network.hpp>
 
+#include <atomic>
+
 class ODPacket;
 
+/*! \brief The sockets are only used by a dedicated network thread. It accepts the new clients, receives
+ * their packets and sends the packets queued by the server thread. Both threads exchange data through
+ * lock free queues so that a slow client cannot delay the server thread and a long turn cannot delay
+ * the reception of the messages.
+ */
 class ODSocketServer
 {
     public:
@@ -37,14 +46,15 @@ class ODSocketServer
         virtual void stopServer();
 
     protected:
-        /*! \brief Function called when a new client connects. If the server returns an ODSocketClient,
-         *! it will be added to the client list
+        /*! \brief Function called from the doTask context when a new client connects. If it returns true,
+         *! the client will be added to the client list. Otherwise, it will be disconnected
          */
-        virtual ODSocketClient* notifyNewConnection(sf::TcpListener& sockListener) = 0;
+        virtual bool notifyNewConnection(ODSocketClient* sock) = 0;
 
-        /*! \brief Function called when a client sends a message. As this function is called
-         * from the doTask context, it shall return as soon as possible (we should not send
-         * a message and wait actively for its answer). The proper way of communicating should be :
+        /*! \brief Function called from the doTask context when a packet has been received from a client
+         * or when receiving failed (status is not OK). As this function is called from the doTask context,
+         * it shall return as soon as possible (we should not send a message and wait actively for its answer).
+         * The proper way of communicating should be :
          * 1 - read the message
          * 2 - If needed, send something (answer or new question)
          * 3 - Save somewhere if we are waiting for something from the client
@@ -52,26 +62,69 @@ class ODSocketServer
          *     will be called again
          * If the function returns false, the client will be removed from the list and properly deleted
          */
-        virtual bool notifyClientMessage(ODSocketClient *sock) = 0;
-
-        /*! \brief Main function task. Checks if a new client connects. If so, notifyNewConnection
-         * will be called with the client socket. If it returns true, the client is saved in the
-         * client list. If not, the client is discarded. doTask also checks if a connected client sent
-         * a message. If so, calls notifyClientMessage with the client socket.
-         * If timeoutMs = 0, this function will never return. Otherwise, it will always return after
-         * timeoutMs milliseconds, even if new clients connected or clients are sending messages.
+        virtual bool notifyClientMessage(ODSocketClient* sock, ODSocketClient::ODComStatus status, ODPacket& packet) = 0;
+
+        /*! \brief Main function task. Handles what the network thread received: calls notifyNewConnection
+         * for new clients and notifyClientMessage for each received packet. It returns after timeoutMs
+         * milliseconds (or when the server is stopped). If timeoutMs <= 0, it only handles what has
+         * already been received.
          */
         void doTask(int timeoutMs);
+
+        //! \brief Queues the packet so that the network thread sends it to the given client. It should
+        //! only be called from the doTask context (server thread)
+        void sendToClient(ODSocketClient* sock, const ODPacket& packet);
+
+        //! \brief Clients accepted by notifyNewConnection. Only used by the server thread
         std::vector<ODSocketClient*> mSockClients;
         virtual void serverThread() = 0;
         sf::Thread* mThread;
 
     private:
+        enum class NetworkEventType
+        {
+            clientConnected,
+            clientMessage,
+            //! \brief The network thread does not use the client anymore. It can be deleted
+            clientReleased
+        };
+
+        //! \brief Sent from the network thread to the server thread
+        struct NetworkEvent
+        {
+            NetworkEventType mType;
+            ODSocketClient* mClient;
+            ODSocketClient::ODComStatus mStatus;
+            ODPacket mPacket;
+        };
+
+        //! \brief Sent from the server thread to the network thread. If mIsDisconnect is true, the
+        //! client should be disconnected. Otherwise, mPacket should be sent to it
+        struct OutgoingPacket
+        {
+            ODSocketClient* mClient;
+            bool mIsDisconnect;
+            ODPacket mPacket;
+        };
+
+        //! \brief Loop of the network thread
+        void networkThread();
+
+        //! \brief Asks the network thread to disconnect the client. It will be deleted once the network
+        //! thread releases it
+        void disconnectClient(ODSocketClient* client);
+
         sf::TcpListener mSockListener;
         sf::SocketSelector mSockSelector;
         sf::Clock mClockMainTask;
-        bool mIsConnected;
+        std::atomic<bool> mIsConnected;
+        sf::Thread* mNetworkThread;
+
+        //! \brief Every connected client. Only used by the network thread
+        std::vector<ODSocketClient*> mNetworkClients;
+
+        SpscQueue<NetworkEvent> mReceivedEvents;
+        SpscQueue<OutgoingPacket> mOutgoingPackets;
 };
 
 #endif // ODSOCKETSERVER_H
-
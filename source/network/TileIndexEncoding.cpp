@@ -0,0 +1,231 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "network/TileIndexEncoding.h"
+
+#include "network/ODPacket.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+enum class Encoding : uint8_t
+{
+    list,
+    runs,
+    bitmap
+};
+
+//! \brief Run lengths are sent as uint16_t. Longer runs are split
+const uint32_t MAX_RUN_LENGTH = std::numeric_limits<uint16_t>::max();
+
+uint32_t countRuns(const std::vector<uint32_t>& indexes)
+{
+    uint32_t nbRuns = 0;
+    uint32_t runLength = 0;
+    for(uint32_t i = 0; i < indexes.size(); ++i)
+    {
+        if((runLength > 0) && (runLength < MAX_RUN_LENGTH) && (indexes[i] == indexes[i - 1] + 1))
+        {
+            ++runLength;
+            continue;
+        }
+
+        ++nbRuns;
+        runLength = 1;
+    }
+    return nbRuns;
+}
+
+void writeRuns(ODPacket& packet, const std::vector<uint32_t>& indexes, uint32_t nbRuns)
+{
+    packet << nbRuns;
+    uint32_t i = 0;
+    while(i < indexes.size())
+    {
+        uint32_t first = indexes[i];
+        uint32_t runLength = 1;
+        while((i + runLength < indexes.size()) && (runLength < MAX_RUN_LENGTH) &&
+              (indexes[i + runLength] == indexes[i + runLength - 1] + 1))
+        {
+            ++runLength;
+        }
+        uint16_t length = static_cast<uint16_t>(runLength);
+        packet << first << length;
+        i += runLength;
+    }
+}
+
+void writeBitmap(ODPacket& packet, const std::vector<uint32_t>& indexes, int mapSizeX,
+    uint16_t xMin, uint16_t yMin, uint16_t width, uint16_t height)
+{
+    packet << xMin << yMin << width << height;
+    std::vector<uint8_t> bytes((static_cast<uint32_t>(width) * height + 7) / 8, 0);
+    for(uint32_t index : indexes)
+    {
+        uint32_t xx = index % static_cast<uint32_t>(mapSizeX) - xMin;
+        uint32_t yy = index / static_cast<uint32_t>(mapSizeX) - yMin;
+        uint32_t bit = xx + yy * width;
+        bytes[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+    }
+    for(uint8_t byte : bytes)
+        packet << byte;
+}
+}
+
+namespace TileIndexEncoding
+{
+void writeTileIndexes(ODPacket& packet, const std::vector<uint32_t>& indexes, int mapSizeX, int mapSizeY)
+{
+    // We compute the size of each encoding and use the smallest
+    uint32_t nbIndexes = static_cast<uint32_t>(indexes.size());
+    uint64_t sizeList = 4 + 4 * static_cast<uint64_t>(nbIndexes);
+
+    uint32_t nbRuns = countRuns(indexes);
+    uint64_t sizeRuns = 4 + 6 * static_cast<uint64_t>(nbRuns);
+
+    uint64_t sizeBitmap = std::numeric_limits<uint64_t>::max();
+    uint32_t xMin = 0;
+    uint32_t yMin = 0;
+    uint32_t xMax = 0;
+    uint32_t yMax = 0;
+    if((nbIndexes > 0) &&
+       (mapSizeX <= std::numeric_limits<uint16_t>::max()) &&
+       (mapSizeY <= std::numeric_limits<uint16_t>::max()))
+    {
+        xMin = std::numeric_limits<uint32_t>::max();
+        yMin = std::numeric_limits<uint32_t>::max();
+        for(uint32_t index : indexes)
+        {
+            uint32_t xx = index % static_cast<uint32_t>(mapSizeX);
+            uint32_t yy = index / static_cast<uint32_t>(mapSizeX);
+            xMin = std::min(xMin, xx);
+            yMin = std::min(yMin, yy);
+            xMax = std::max(xMax, xx);
+            yMax = std::max(yMax, yy);
+        }
+        uint64_t nbBits = static_cast<uint64_t>(xMax - xMin + 1) * (yMax - yMin + 1);
+        sizeBitmap = 8 + (nbBits + 7) / 8;
+    }
+
+    if((sizeBitmap < sizeRuns) && (sizeBitmap < sizeList))
+    {
+        packet << static_cast<uint8_t>(Encoding::bitmap);
+        writeBitmap(packet, indexes, mapSizeX, static_cast<uint16_t>(xMin), static_cast<uint16_t>(yMin),
+            static_cast<uint16_t>(xMax - xMin + 1), static_cast<uint16_t>(yMax - yMin + 1));
+        return;
+    }
+
+    if(sizeRuns < sizeList)
+    {
+        packet << static_cast<uint8_t>(Encoding::runs);
+        writeRuns(packet, indexes, nbRuns);
+        return;
+    }
+
+    packet << static_cast<uint8_t>(Encoding::list);
+    packet << nbIndexes;
+    for(uint32_t index : indexes)
+        packet << index;
+}
+
+bool readTileIndexes(ODPacket& packet, int mapSizeX, int mapSizeY, std::vector<uint32_t>& indexes)
+{
+    if((mapSizeX <= 0) || (mapSizeY <= 0))
+        return false;
+
+    uint32_t nbTiles = static_cast<uint32_t>(mapSizeX) * static_cast<uint32_t>(mapSizeY);
+    uint8_t encoding;
+    if(!(packet >> encoding))
+        return false;
+
+    switch(static_cast<Encoding>(encoding))
+    {
+        case Encoding::list:
+        {
+            uint32_t nbIndexes;
+            if(!(packet >> nbIndexes))
+                return false;
+
+            for(uint32_t i = 0; i < nbIndexes; ++i)
+            {
+                uint32_t index;
+                if(!(packet >> index))
+                    return false;
+                if(index >= nbTiles)
+                    return false;
+
+                indexes.push_back(index);
+            }
+            return true;
+        }
+        case Encoding::runs:
+        {
+            uint32_t nbRuns;
+            if(!(packet >> nbRuns))
+                return false;
+
+            for(uint32_t i = 0; i < nbRuns; ++i)
+            {
+                uint32_t first;
+                uint16_t length;
+                if(!(packet >> first >> length))
+                    return false;
+                if((first >= nbTiles) || (length > nbTiles - first))
+                    return false;
+
+                for(uint32_t index = first; index < first + length; ++index)
+                    indexes.push_back(index);
+            }
+            return true;
+        }
+        case Encoding::bitmap:
+        {
+            uint16_t xMin;
+            uint16_t yMin;
+            uint16_t width;
+            uint16_t height;
+            if(!(packet >> xMin >> yMin >> width >> height))
+                return false;
+            if((static_cast<int>(xMin) + width > mapSizeX) || (static_cast<int>(yMin) + height > mapSizeY))
+                return false;
+
+            uint32_t nbBits = static_cast<uint32_t>(width) * height;
+            uint8_t byte = 0;
+            for(uint32_t bit = 0; bit < nbBits; ++bit)
+            {
+                if((bit % 8) == 0)
+                {
+                    if(!(packet >> byte))
+                        return false;
+                }
+
+                if((byte & (1 << (bit % 8))) == 0)
+                    continue;
+
+                uint32_t xx = xMin + bit % width;
+                uint32_t yy = yMin + bit / width;
+                indexes.push_back(xx + yy * static_cast<uint32_t>(mapSizeX));
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+}
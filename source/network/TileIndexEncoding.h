@@ -0,0 +1,45 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILEINDEXENCODING_H
+#define TILEINDEXENCODING_H
+
+#include <cstdint>
+#include <vector>
+
+class ODPacket;
+
+/*! \brief Compact network encoding for sets of tiles given by their index (x + y * mapSizeX).
+ *
+ * The tiles are written with the smallest of these encodings:
+ * - List: every index
+ * - Runs: each run of consecutive indexes as its first index and its length. Tiles seen by a creature or
+ *   a spell are mostly made of such runs (one per row)
+ * - Bitmap: the bounding box of the tiles and one bit per tile of the box
+ * The order of the tiles is not kept.
+ */
+namespace TileIndexEncoding
+{
+    //! \brief Writes the given tile indexes. They should be sorted to get the best result
+    void writeTileIndexes(ODPacket& packet, const std::vector<uint32_t>& indexes, int mapSizeX, int mapSizeY);
+
+    //! \brief Reads tile indexes written with writeTileIndexes and appends them to indexes. Returns false if
+    //! the packet is invalid or if an index is outside the map
+    bool readTileIndexes(ODPacket& packet, int mapSizeX, int mapSizeY, std::vector<uint32_t>& indexes);
+}
+
+#endif // TILEINDEXENCODING_H
@@ -147,7 +147,9 @@ void RoomPortal::claimForSeat(Seat* seat, Tile* tile, double danceRate)
     }
 
     mClaimedValue = static_cast<double>(numCoveredTiles());
+    Seat* oldSeat = getSeat();
     setSeat(seat);
+    getGameMap()->notifyRoomSeatChanged(this, oldSeat);
 
     for(Tile* tile : mCoveredTiles)
         tile->claimTile(seat);
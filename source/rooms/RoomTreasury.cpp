@@ -237,7 +237,9 @@ static const int maxGoldinTile = 1000;
 
 RoomTreasury::RoomTreasury(GameMap* gameMap) :
     Room(gameMap),
-    mGoldChanged(false)
+    mGoldChanged(false),
+    mGoldStored(0),
+    mIsGoldCountedBySeat(false)
 {
     setMeshName("Treasury");
 }
@@ -260,6 +262,58 @@ void RoomTreasury::doUpkeep()
     }
 }
 
+void RoomTreasury::addToGameMap()
+{
+    // The seat counts the gold already stored when the room is added (see Seat::addRoom)
+    Room::addToGameMap();
+    mIsGoldCountedBySeat = true;
+}
+
+void RoomTreasury::removeFromGameMap()
+{
+    Room::removeFromGameMap();
+    mIsGoldCountedBySeat = false;
+}
+
+void RoomTreasury::absorbRoom(Room* r)
+{
+    if(r->getType() != getType())
+    {
+        OD_LOG_ERR("Trying to merge incompatible rooms: " + getName() + ", type=" + RoomManager::getRoomNameFromRoomType(getType()) + ", with " + r->getName() + ", type=" + RoomManager::getRoomNameFromRoomType(r->getType()));
+        return;
+    }
+
+    int goldStorage = getTotalGoldStorage();
+    Room::absorbRoom(r);
+
+    // The gold of the absorbed treasury tiles is now in this room. Both rooms belong to the same seat so we
+    // move the gold from one to the other without changing the seat totals
+    RoomTreasury* roomAbs = static_cast<RoomTreasury*>(r);
+    int goldAbsorbed = roomAbs->mGoldStored;
+    int goldStorageAbsorbed = getTotalGoldStorage() - goldStorage;
+    for(std::pair<Tile* const, TileData*>& p : roomAbs->mTileData)
+        static_cast<RoomTreasuryTileData*>(p.second)->mGoldInTile = 0;
+
+    roomAbs->notifyGoldChanged(-goldAbsorbed, -goldStorageAbsorbed);
+    notifyGoldChanged(goldAbsorbed, goldStorageAbsorbed);
+}
+
+void RoomTreasury::repairRoom()
+{
+    int goldStorage = getTotalGoldStorage();
+    Room::repairRoom();
+    notifyGoldChanged(0, getTotalGoldStorage() - goldStorage);
+}
+
+void RoomTreasury::notifyGoldChanged(int goldStoredDelta, int goldStorageDelta)
+{
+    mGoldStored += goldStoredDelta;
+    if(!mIsGoldCountedBySeat)
+        return;
+
+    getSeat()->notifyGoldStorageChanged(goldStoredDelta, goldStorageDelta);
+}
+
 bool RoomTreasury::removeCoveredTile(Tile* t)
 {
     // if the mesh has gold, we erase the mesh
@@ -268,6 +322,7 @@ bool RoomTreasury::removeCoveredTile(Tile* t)
     if(!roomTreasuryTileData->mMeshOfTile.empty())
         removeBuildingObject(t);
 
+    int goldReleased = roomTreasuryTileData->mGoldInTile;
     if(roomTreasuryTileData->mGoldInTile > 0)
     {
         int value = roomTreasuryTileData->mGoldInTile;
@@ -287,7 +342,10 @@ bool RoomTreasury::removeCoveredTile(Tile* t)
 
     roomTreasuryTileData->mMeshOfTile.clear();
     roomTreasuryTileData->mGoldInTile = 0;
-    return Room::removeCoveredTile(t);
+    int goldStorage = getTotalGoldStorage();
+    bool isRemoved = Room::removeCoveredTile(t);
+    notifyGoldChanged(-goldReleased, getTotalGoldStorage() - goldStorage);
+    return isRemoved;
 }
 
 int RoomTreasury::getTotalGoldStorage() const
@@ -297,15 +355,7 @@ int RoomTreasury::getTotalGoldStorage() const
 
 int RoomTreasury::getTotalGoldStored() const
 {
-    int totalGold = 0;
-
-    for (const std::pair<Tile* const, TileData*>& p : mTileData)
-    {
-        RoomTreasuryTileData* roomTreasuryTileData = static_cast<RoomTreasuryTileData*>(p.second);
-        totalGold += roomTreasuryTileData->mGoldInTile;
-    }
-
-    return totalGold;
+    return mGoldStored;
 }
 
 int RoomTreasury::depositGold(int gold, Tile *tile)
@@ -344,6 +394,7 @@ int RoomTreasury::depositGold(int gold, Tile *tile)
         return wasDeposited;
 
     mGoldChanged = true;
+    notifyGoldChanged(wasDeposited, 0);
 
     // Tells the client to play a deposit gold sound. For now, we only send it to the players
     // with vision on tile
@@ -377,6 +428,7 @@ int RoomTreasury::withdrawGold(int gold)
         }
     }
 
+    notifyGoldChanged(-withdrawlAmount, 0);
     return withdrawlAmount;
 }
 
@@ -56,6 +56,10 @@ public:
 
     // Functions overriding virtual functions in the Room base class.
     bool removeCoveredTile(Tile* t) override;
+    void addToGameMap() override;
+    void removeFromGameMap() override;
+    void absorbRoom(Room* r) override;
+    void repairRoom() override;
 
     // Functions specific to this class.
     virtual void doUpkeep() override;
@@ -83,7 +87,17 @@ protected:
 
 private:
     void updateMeshesForTile(Tile* tile, RoomTreasuryTileData* roomTreasuryTileData);
+
+    //! \brief Updates mGoldStored and notifies the seat while it counts this treasury in its totals
+    void notifyGoldChanged(int goldStoredDelta, int goldStorageDelta);
+
     bool mGoldChanged;
+
+    //! \brief Sum of the gold in the tiles
+    int mGoldStored;
+
+    //! \brief True between addToGameMap and removeFromGameMap (when the seat counts the gold of this treasury)
+    bool mIsGoldCountedBySeat;
 };
 
 #endif // ROOMTREASURY_H
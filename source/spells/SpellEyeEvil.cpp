@@ -90,9 +90,13 @@ void SpellEyeEvil::computeVisibleTiles()
         return;
     }
 
+    // The eye does not move. Its tiles only have to be registered once
+    VisionMap& visionMap = getGameMap()->getVisionMap();
+    if(!visionMap.needsUpdate(*this, getSeat(), posTile, radius))
+        return;
+
     std::vector<Tile*> tiles = getGameMap()->circularRegion(posTile->getX(), posTile->getY(), radius);
-    for(Tile* tile : tiles)
-        tile->notifyVision(getSeat());
+    visionMap.setSource(*this, getSeat(), posTile, radius, tiles, false);
 }
 
 void SpellEyeEvil::checkSpellCast(GameMap* gameMap, const InputManager& inputManager, InputCommand& inputCommand)
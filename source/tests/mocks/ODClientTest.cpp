@@ -394,16 +394,28 @@ bool ODClientTest::processMessage(ServerNotificationType cmd, ODPacket& packetRe
             BOOST_CHECK(packetReceived >> mPlayers[mLocalPlayerIndex].mGoals);
             break;
         }
-        case ServerNotificationType::setObjectAnimationState:
+        case ServerNotificationType::addEntity:
         {
+            // We only read the beginning of the entity (see GameEntity::exportToPacket) to know its network id
+            int32_t entityType;
+            uint32_t networkId;
+            int32_t seatId;
             std::string entityName;
+            BOOST_CHECK(packetReceived >> entityType >> networkId >> seatId >> entityName);
+            mEntityNames[networkId] = entityName;
+            break;
+        }
+        case ServerNotificationType::setObjectAnimationState:
+        {
+            uint32_t networkId;
             std::string animState;
             bool loop;
             bool playIdleWhenAnimationEnds;
             bool shouldSetWalkDirection;
             Ogre::Vector3 walkDirection(0, 0, 0);
-            BOOST_CHECK(packetReceived >> entityName >> animState
+            BOOST_CHECK(packetReceived >> networkId >> animState
                 >> loop >> playIdleWhenAnimationEnds >> shouldSetWalkDirection);
+            const std::string& entityName = mEntityNames[networkId];
 
             if(shouldSetWalkDirection)
             {
@@ -415,13 +427,14 @@ bool ODClientTest::processMessage(ServerNotificationType cmd, ODPacket& packetRe
         }
         case ServerNotificationType::animatedObjectSetWalkPath:
         {
-            std::string entityName;
+            uint32_t networkId;
             std::string walkAnim;
             std::string endAnim;
             bool loopEndAnim;
             bool playIdleWhenAnimationEnds;
             uint32_t nbDest;
-            BOOST_CHECK(packetReceived >> entityName >> walkAnim >> endAnim);
+            BOOST_CHECK(packetReceived >> networkId >> walkAnim >> endAnim);
+            const std::string& entityName = mEntityNames[networkId];
             BOOST_CHECK(packetReceived >> loopEndAnim >> playIdleWhenAnimationEnds >> nbDest);
             std::vector<Ogre::Vector3> path;
             while(nbDest)
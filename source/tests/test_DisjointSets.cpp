@@ -0,0 +1,81 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/DisjointSets.h"
+
+#define BOOST_TEST_MODULE DisjointSets
+#include "BoostTestTargetConfig.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(test_MergeKeepsName)
+{
+    DisjointSets sets;
+    BOOST_CHECK_EQUAL(sets.find(5), 5);
+
+    sets.merge(5, 3);
+    BOOST_CHECK_EQUAL(sets.find(5), 3);
+    BOOST_CHECK_EQUAL(sets.find(3), 3);
+
+    // The name of the kept set is used even if it is the smaller one
+    sets.merge(7, 8);
+    sets.merge(9, 8);
+    sets.merge(8, 3);
+    BOOST_CHECK_EQUAL(sets.find(9), 3);
+    BOOST_CHECK_EQUAL(sets.find(7), 3);
+
+    // 0 is never merged
+    sets.merge(0, 3);
+    BOOST_CHECK_EQUAL(sets.find(0), 0);
+
+    sets.clear();
+    BOOST_CHECK_EQUAL(sets.find(9), 9);
+}
+
+BOOST_AUTO_TEST_CASE(test_ConcurrentFinds)
+{
+    // find does not modify the sets so several threads can search them at the same time. Run with
+    // the thread sanitizer to check it
+    const uint32_t nbValues = 20000;
+    DisjointSets sets;
+    for(uint32_t i = 2; i < nbValues; ++i)
+        sets.merge(i, (i % 2 == 0) ? i - 2 : 1);
+
+    const DisjointSets& constSets = sets;
+    std::atomic<uint32_t> nbWrongFinds(0);
+    std::vector<std::thread> threads;
+    for(uint32_t t = 0; t < 4; ++t)
+    {
+        threads.push_back(std::thread([&constSets, &nbWrongFinds, nbValues]()
+        {
+            for(uint32_t i = 1; i < nbValues; ++i)
+            {
+                uint32_t expected = (i % 2 == 0) ? 2 : 1;
+                if(constSets.find(i) != expected)
+                    ++nbWrongFinds;
+            }
+        }));
+    }
+
+    for(std::thread& thread : threads)
+        thread.join();
+
+    BOOST_CHECK_EQUAL(nbWrongFinds.load(), 0);
+}
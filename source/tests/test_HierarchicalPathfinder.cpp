@@ -0,0 +1,203 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE HierarchicalPathfinder
+#include "BoostTestTargetConfig.h"
+
+#include "entities/Creature.h"
+#include "entities/CreatureDefinition.h"
+#include "entities/Tile.h"
+#include "gamemap/GameMap.h"
+#include "gamemap/HierarchicalPathfinder.h"
+#include "gamemap/PathfindingContext.h"
+#include "utils/ConfigManager.h"
+#include "utils/LogManager.h"
+#include "utils/LogSinkConsole.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <list>
+#include <memory>
+
+// The map is made of 3 clusters side by side. Lava (that the test creature cannot walk on)
+// separates them, except for one opening in each wall:
+//
+//      x=0 ........ x=10 ........ x=20 ........ x=29
+//       |  cluster 0  L  cluster 1  L  cluster 2  |
+//
+// The creature has the default speeds of a CreatureDefinition (it only walks on ground). Like in
+// test_TileContainer, a client game map is used because it does not need the server resources.
+
+namespace
+{
+const int MAP_SIZE_X = 3 * 10;
+const int MAP_SIZE_Y = 10;
+const int WALL_WEST_X = 10;
+const int WALL_EAST_X = 20;
+
+void setGround(GameMap& gameMap, int xx, int yy)
+{
+    Tile* tile = gameMap.getTile(xx, yy);
+    tile->setType(TileType::dirt);
+    tile->setTileVisual(TileVisual::dirtGround);
+}
+
+void setLava(GameMap& gameMap, int xx, int yy)
+{
+    Tile* tile = gameMap.getTile(xx, yy);
+    tile->setType(TileType::lava);
+    tile->setTileVisual(TileVisual::lavaGround);
+}
+
+bool isInPath(const std::list<Tile*>& path, Tile* tile)
+{
+    return std::find(path.begin(), path.end(), tile) != path.end();
+}
+
+struct PathfinderFixture
+{
+    PathfinderFixture() :
+        mConfigManager(OD_TEST_DATA_PATH "config/", "", OD_TEST_DATA_PATH "sounds/"),
+        mGameMap(false),
+        mDefinition("TestCreature")
+    {
+        mLogMgr.addSink(std::unique_ptr<LogSink>(new LogSinkConsole()));
+        BOOST_REQUIRE(mGameMap.createNewMap(MAP_SIZE_X, MAP_SIZE_Y));
+        for(int yy = 0; yy < MAP_SIZE_Y; ++yy)
+        {
+            for(int xx = 0; xx < MAP_SIZE_X; ++xx)
+            {
+                if((xx == WALL_WEST_X) || (xx == WALL_EAST_X))
+                    setLava(mGameMap, xx, yy);
+                else
+                    setGround(mGameMap, xx, yy);
+            }
+        }
+        setGround(mGameMap, WALL_WEST_X, 2);
+        setGround(mGameMap, WALL_EAST_X, 7);
+
+        mCreature.reset(new Creature(&mGameMap, &mDefinition, nullptr));
+    }
+
+    bool findPath(int x1, int y1, int x2, int y2, std::list<Tile*>& path)
+    {
+        return mPathfinder.findPath(mGameMap, mContext, mGameMap.getTile(x1, y1), mGameMap.getTile(x2, y2),
+            *mCreature, FloodFillType::ground, nullptr, path);
+    }
+
+    bool findFullPath(int x1, int y1, int x2, int y2, std::list<Tile*>& path)
+    {
+        return mContext.findPath(mGameMap, mGameMap.getTile(x1, y1), mGameMap.getTile(x2, y2),
+            *mCreature, nullptr, false, path);
+    }
+
+    //! \brief Checks that the creature can walk every tile of the path and that each tile is a
+    //! neighbor of the previous one. Diagonal moves need both tiles around the corner to be walkable
+    void checkPathWalkable(const std::list<Tile*>& path)
+    {
+        const Tile* previous = nullptr;
+        for(Tile* tile : path)
+        {
+            BOOST_CHECK(mCreature->canGoThroughTile(tile));
+            if(previous != nullptr)
+            {
+                int dx = tile->getX() - previous->getX();
+                int dy = tile->getY() - previous->getY();
+                BOOST_CHECK(std::max(std::abs(dx), std::abs(dy)) == 1);
+                if((dx != 0) && (dy != 0))
+                {
+                    BOOST_CHECK(mCreature->canGoThroughTile(mGameMap.getTile(previous->getX() + dx, previous->getY())));
+                    BOOST_CHECK(mCreature->canGoThroughTile(mGameMap.getTile(previous->getX(), previous->getY() + dy)));
+                }
+            }
+            previous = tile;
+        }
+    }
+
+    LogManager mLogMgr;
+    ConfigManager mConfigManager;
+    GameMap mGameMap;
+    CreatureDefinition mDefinition;
+    std::unique_ptr<Creature> mCreature;
+    HierarchicalPathfinder mPathfinder;
+    PathfindingContext mContext;
+};
+}
+
+BOOST_FIXTURE_TEST_CASE(test_EntrancesAcrossClusters, PathfinderFixture)
+{
+    std::list<Tile*> path;
+    BOOST_REQUIRE(findPath(1, 5, MAP_SIZE_X - 2, 5, path));
+    BOOST_REQUIRE(!path.empty());
+    BOOST_CHECK(path.front() == mGameMap.getTile(1, 5));
+    BOOST_CHECK(path.back() == mGameMap.getTile(MAP_SIZE_X - 2, 5));
+
+    // The only entrances between the clusters are the openings in the walls
+    BOOST_CHECK(isInPath(path, mGameMap.getTile(WALL_WEST_X, 2)));
+    BOOST_CHECK(isInPath(path, mGameMap.getTile(WALL_EAST_X, 7)));
+    checkPathWalkable(path);
+
+    // Within a cluster, the path is refined directly
+    std::list<Tile*> localPath;
+    BOOST_REQUIRE(findPath(1, 1, 8, 8, localPath));
+    BOOST_CHECK(localPath.front() == mGameMap.getTile(1, 1));
+    BOOST_CHECK(localPath.back() == mGameMap.getTile(8, 8));
+    checkPathWalkable(localPath);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_RepairAfterTileChanged, PathfinderFixture)
+{
+    std::list<Tile*> path;
+    BOOST_REQUIRE(findPath(1, 5, MAP_SIZE_X - 2, 5, path));
+
+    // Closing the only opening of the west wall cuts the map
+    setLava(mGameMap, WALL_WEST_X, 2);
+    mPathfinder.notifyTileChanged(*mGameMap.getTile(WALL_WEST_X, 2));
+    path.clear();
+    BOOST_CHECK(!findPath(1, 5, MAP_SIZE_X - 2, 5, path));
+    BOOST_CHECK(path.empty());
+    BOOST_CHECK(!findFullPath(1, 5, MAP_SIZE_X - 2, 5, path));
+
+    // A new opening creates a new entrance when the cluster is repaired
+    setGround(mGameMap, WALL_WEST_X, 8);
+    mPathfinder.notifyTileChanged(*mGameMap.getTile(WALL_WEST_X, 8));
+    path.clear();
+    BOOST_REQUIRE(findPath(1, 5, MAP_SIZE_X - 2, 5, path));
+    BOOST_CHECK(isInPath(path, mGameMap.getTile(WALL_WEST_X, 8)));
+    BOOST_CHECK(!isInPath(path, mGameMap.getTile(WALL_WEST_X, 2)));
+    BOOST_CHECK(path.back() == mGameMap.getTile(MAP_SIZE_X - 2, 5));
+    checkPathWalkable(path);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_FallbackWhenRefinementFails, PathfinderFixture)
+{
+    std::list<Tile*> path;
+    BOOST_REQUIRE(findPath(1, 5, MAP_SIZE_X - 2, 5, path));
+
+    // The tiles change without notifying the pathfinder. The abstract path still goes through
+    // the former opening but the creature cannot walk there anymore
+    setLava(mGameMap, WALL_WEST_X, 2);
+    setGround(mGameMap, WALL_WEST_X, 8);
+    path.clear();
+    BOOST_CHECK(!findPath(1, 5, MAP_SIZE_X - 2, 5, path));
+    BOOST_CHECK(path.empty());
+
+    // That is why the caller falls back on a full search, which finds the new opening
+    BOOST_REQUIRE(findFullPath(1, 5, MAP_SIZE_X - 2, 5, path));
+    BOOST_CHECK(isInPath(path, mGameMap.getTile(WALL_WEST_X, 8)));
+    checkPathWalkable(path);
+}
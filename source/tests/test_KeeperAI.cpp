@@ -0,0 +1,74 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mocks/ODClientTest.h"
+
+#include "game/SeatData.h"
+#include "utils/LogManager.h"
+#include "utils/LogSinkConsole.h"
+
+#define BOOST_TEST_MODULE TestKeeperAI
+#include <BoostTestTargetConfig.h>
+
+BOOST_AUTO_TEST_CASE(test_KeeperAIsOnPoolThreads)
+{
+    // The keeper AIs decide at the same time on the server thread pool while reading the same game
+    // map (see AIManager::doTurn). We let several of them play to check the server keeps running.
+    // Run the server with the thread sanitizer to check the decisions only read the game map
+    LogManager logMgr;
+    logMgr.addSink(std::unique_ptr<LogSink>(new LogSinkConsole()));
+    std::vector<PlayerInfo> players;
+
+    // We know we have seat id = 1, 2, 3 and that seat 1 is for a human player
+    PlayerInfo player;
+    player.mNick = "PlayerStub1";
+    player.mWantedSeatId = 1;
+    player.mWantedTeamId = 1;
+    player.mIsHuman = true;
+    // The player id will be set by the server
+    player.mPlayerId = -1;
+    // We take faction index 0 for every player (keeper faction)
+    player.mWantedFactionIndex = 0;
+    players.push_back(player);
+
+    // We add the AI players
+    for(int seatId = 2; seatId <= 3; ++seatId)
+    {
+        PlayerInfo playerAi;
+        playerAi.mPlayerId = 0;
+        playerAi.mWantedSeatId = seatId;
+        playerAi.mWantedTeamId = seatId;
+        playerAi.mWantedFactionIndex = 0;
+        playerAi.mIsHuman = false;
+        players.push_back(playerAi);
+        OD_LOG_INF("Adding ai player seatId=" + Helper::toString(seatId));
+    }
+
+    ODClientTest client(players, 0);
+    BOOST_CHECK(client.connect("localhost", 32222, 10, "test_KeeperAIReplay"));
+    BOOST_CHECK(client.isConnected());
+
+    // The AIs summon workers, dig and build rooms during the first turns
+    client.runFor(30000);
+
+    // We expect the server to still be sending turns
+    OD_LOG_INF("turnNum=" + Helper::toString(client.mTurnNum));
+    BOOST_CHECK(client.isConnected());
+    BOOST_CHECK(client.mTurnNum > 20);
+
+    client.disconnect(false);
+}
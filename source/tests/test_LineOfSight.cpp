@@ -0,0 +1,281 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE LineOfSight
+#include "BoostTestTargetConfig.h"
+
+#include "gamemap/LineOfSight.h"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+// Checks that LineOfSight gives the same visible tiles, in the same order, as the algorithm
+// TileContainer::visibleTiles used before the stencils were introduced. The reference below is
+// that algorithm with Tile replaced by cells of a grid.
+
+namespace
+{
+const int MAP_SIZE = 40;
+
+struct Cell
+{
+    int mX;
+    int mY;
+    bool mBlocksVision;
+};
+
+class Grid
+{
+public:
+    Grid(uint32_t seed, double wallRatio) :
+        mCells(MAP_SIZE * MAP_SIZE)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        for(int yy = 0; yy < MAP_SIZE; ++yy)
+        {
+            for(int xx = 0; xx < MAP_SIZE; ++xx)
+            {
+                Cell& cell = mCells[xx + yy * MAP_SIZE];
+                cell.mX = xx;
+                cell.mY = yy;
+                cell.mBlocksVision = dist(rng) < wallRatio;
+            }
+        }
+    }
+
+    Cell* getCell(int xx, int yy)
+    {
+        if(xx < 0 || yy < 0 || xx >= MAP_SIZE || yy >= MAP_SIZE)
+            return nullptr;
+
+        return &mCells[xx + yy * MAP_SIZE];
+    }
+
+private:
+    std::vector<Cell> mCells;
+};
+
+class CellDistanceProcess
+{
+public:
+    CellDistanceProcess(const TileDistance& tileDistance, Cell* cell):
+        mTileDistance(tileDistance),
+        mCell(cell),
+        mHiddenValueNorth(0.0),
+        mHiddenValueSouth(0.0)
+    {
+    }
+
+    inline const TileDistance& getTileDistance() const
+    { return mTileDistance; }
+
+    void addHiddenValueNorth(double val)
+    {
+        if(val <= mHiddenValueNorth)
+            return;
+
+        mHiddenValueNorth = val;
+    }
+
+    void addHiddenValueSouth(double val)
+    {
+        if(val <= mHiddenValueSouth)
+            return;
+
+        mHiddenValueSouth = val;
+    }
+
+    inline bool isTileVisible() const
+    { return (mHiddenValueNorth + mHiddenValueSouth) <= 0.5; }
+
+    inline double getHiddenValueNorth() const
+    { return mHiddenValueNorth; }
+
+    inline double getHiddenValueSouth() const
+    { return mHiddenValueSouth; }
+
+    inline Cell* getCell() const
+    { return mCell; }
+
+private:
+    const TileDistance& mTileDistance;
+    Cell* mCell;
+    double mHiddenValueNorth;
+    double mHiddenValueSouth;
+};
+
+std::vector<Cell*> referenceVisibleTiles(Grid& grid, const std::vector<TileDistance>& tileDistances,
+    int x, int y, int radius)
+{
+    std::vector<Cell*> returnList;
+    int radiusSquared = radius * radius;
+    std::vector<CellDistanceProcess> cellsProcess[8];
+    for(uint32_t k = 0; k < 8; ++k)
+    {
+        for(const TileDistance& tileDist : tileDistances)
+        {
+            if(tileDist.getDistSquared() > radiusSquared)
+                break;
+
+            int dx = tileDist.getDiffX();
+            int dy = tileDist.getDiffY();
+            Cell* cell = nullptr;
+            switch(k)
+            {
+                case 0: cell = grid.getCell(x + dx, y + dy); break;
+                case 1: cell = grid.getCell(x + dy, y - dx); break;
+                case 2: cell = grid.getCell(x - dx, y - dy); break;
+                case 3: cell = grid.getCell(x - dy, y + dx); break;
+                case 4: cell = grid.getCell(x + dy, y + dx); break;
+                case 5: cell = grid.getCell(x + dx, y - dy); break;
+                case 6: cell = grid.getCell(x - dy, y - dx); break;
+                case 7: cell = grid.getCell(x - dx, y + dy); break;
+                default: break;
+            }
+            cellsProcess[k].push_back(CellDistanceProcess(tileDist, cell));
+        }
+    }
+
+    for(uint32_t k = 0; k < 8; ++k)
+    {
+        for(CellDistanceProcess& process : cellsProcess[k])
+        {
+            if(process.getCell() == nullptr)
+                continue;
+
+            if(!process.getCell()->mBlocksVision)
+                continue;
+
+            for(const std::pair<uint32_t, double>& p : process.getTileDistance().getHiddenTilesNorth())
+            {
+                if(p.first >= cellsProcess[k].size())
+                    continue;
+
+                cellsProcess[k][p.first].addHiddenValueNorth(p.second);
+            }
+            for(const std::pair<uint32_t, double>& p : process.getTileDistance().getHiddenTilesSouth())
+            {
+                if(p.first >= cellsProcess[k].size())
+                    continue;
+
+                cellsProcess[k][p.first].addHiddenValueSouth(p.second);
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < cellsProcess[0].size(); ++i)
+    {
+        for(uint32_t k = 0; k < 8; ++k)
+        {
+            CellDistanceProcess& process = cellsProcess[k][i];
+            if(process.getCell() == nullptr)
+                continue;
+
+            if((k > 0) && (process.getTileDistance().getDistSquared() == 0))
+                continue;
+
+            if((process.getTileDistance().getType() == TileDistance::TileDistanceType::Horizontal) && (k > 3))
+                continue;
+
+            if((process.getTileDistance().getType() == TileDistance::TileDistanceType::Diagonal) && (k > 3))
+                continue;
+
+            if(process.getTileDistance().getType() == TileDistance::TileDistanceType::Diagonal)
+            {
+                CellDistanceProcess& process2 = cellsProcess[k + 4][i];
+                process.addHiddenValueNorth(process2.getHiddenValueSouth());
+                process.addHiddenValueSouth(process2.getHiddenValueNorth());
+            }
+
+            if(!process.isTileVisible())
+                continue;
+
+            returnList.push_back(process.getCell());
+        }
+    }
+    return returnList;
+}
+
+std::vector<Cell*> lineOfSightVisibleTiles(LineOfSight& lineOfSight, Grid& grid, int x, int y, int radius)
+{
+    const std::vector<std::pair<int, int>>& offsets = lineOfSight.computeVisibleTiles(
+        static_cast<uint32_t>(x + y * MAP_SIZE), radius, [&grid, x, y](int diffX, int diffY)
+    {
+        Cell* cell = grid.getCell(x + diffX, y + diffY);
+        if(cell == nullptr)
+            return LineOfSight::TileState::outsideMap;
+
+        if(cell->mBlocksVision)
+            return LineOfSight::TileState::blocksVision;
+
+        return LineOfSight::TileState::permitsVision;
+    });
+
+    std::vector<Cell*> cells;
+    for(const std::pair<int, int>& offset : offsets)
+        cells.push_back(grid.getCell(x + offset.first, y + offset.second));
+
+    return cells;
+}
+
+void checkGrid(LineOfSight& lineOfSight, Grid& grid, int radius)
+{
+    lineOfSight.buildTileDistance(radius);
+    for(int yy = 0; yy < MAP_SIZE; ++yy)
+    {
+        for(int xx = 0; xx < MAP_SIZE; ++xx)
+        {
+            std::vector<Cell*> expected = referenceVisibleTiles(grid, lineOfSight.getTileDistances(), xx, yy, radius);
+            std::vector<Cell*> result = lineOfSightVisibleTiles(lineOfSight, grid, xx, yy, radius);
+            BOOST_REQUIRE(expected == result);
+        }
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_LineOfSightMatchesReference)
+{
+    // The tile distances are computed for a bigger radius than some of the tested ones like in
+    // the game (where they are computed for the highest sight of the creatures)
+    LineOfSight lineOfSight(15);
+    lineOfSight.setMemoEnabled(false);
+    uint32_t seed = 1;
+    for(double wallRatio : {0.0, 0.1, 0.3, 0.6})
+    {
+        for(int radius : {0, 1, 2, 5, 8, 15, 20})
+        {
+            Grid grid(seed++, wallRatio);
+            checkGrid(lineOfSight, grid, radius);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_LineOfSightMemo)
+{
+    LineOfSight lineOfSight(10);
+    Grid grid(42, 0.3);
+    Grid otherGrid(43, 0.3);
+    // The first pass fills the memo. The second one uses it. Then, the walls change around each center
+    // and the memorized results should not be used
+    checkGrid(lineOfSight, grid, 10);
+    checkGrid(lineOfSight, grid, 10);
+    checkGrid(lineOfSight, otherGrid, 10);
+    checkGrid(lineOfSight, grid, 6);
+    checkGrid(lineOfSight, grid, 10);
+}
@@ -0,0 +1,184 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE PathCache
+#include "BoostTestTargetConfig.h"
+
+#include "entities/Tile.h"
+#include "gamemap/GameMap.h"
+#include "gamemap/PathCache.h"
+#include "utils/LogManager.h"
+#include "utils/LogSinkConsole.h"
+
+#include <list>
+#include <memory>
+
+// The cached paths are made of tiles so, like in test_TileContainer, they are taken from a
+// client game map. The paths do not need to be walkable for the cache.
+
+namespace
+{
+const int MAP_SIZE_X = 7;
+const int MAP_SIZE_Y = 5;
+
+struct CacheFixture
+{
+    CacheFixture() :
+        mGameMap(false)
+    {
+        mLogMgr.addSink(std::unique_ptr<LogSink>(new LogSinkConsole()));
+        BOOST_REQUIRE(mGameMap.createNewMap(MAP_SIZE_X, MAP_SIZE_Y));
+        mCache.setMapSize(MAP_SIZE_X, MAP_SIZE_Y);
+    }
+
+    PathCache::Key makeKey(int x1, int y1, int x2, int y2)
+    {
+        PathCache::Key key;
+        key.mStartIndex = mGameMap.getTileIndex(x1, y1);
+        key.mDestIndex = mGameMap.getTileIndex(x2, y2);
+        key.mSpeedGround = 1.0;
+        key.mSpeedWater = 0.0;
+        key.mSpeedLava = 0.0;
+        key.mSeatId = 1;
+        key.mCanCrossEnemyDoors = true;
+        return key;
+    }
+
+    //! \brief Straight path on the given row, both ends included
+    std::list<Tile*> makeRowPath(int yy, int x1, int x2)
+    {
+        std::list<Tile*> path;
+        for(int xx = x1; xx <= x2; ++xx)
+            path.push_back(mGameMap.getTile(xx, yy));
+        return path;
+    }
+
+    LogManager mLogMgr;
+    GameMap mGameMap;
+    PathCache mCache;
+};
+}
+
+BOOST_FIXTURE_TEST_CASE(test_AddAndGet, CacheFixture)
+{
+    std::list<Tile*> path = makeRowPath(0, 0, 4);
+    mCache.addPath(makeKey(0, 0, 4, 0), path);
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 1u);
+
+    std::list<Tile*> cachedPath;
+    BOOST_REQUIRE(mCache.getPath(makeKey(0, 0, 4, 0), cachedPath));
+    BOOST_CHECK(cachedPath == path);
+    BOOST_CHECK_EQUAL(mCache.getNbHits(), 1u);
+
+    // Any difference in the key is another entry
+    PathCache::Key otherSeat = makeKey(0, 0, 4, 0);
+    otherSeat.mSeatId = 2;
+    BOOST_CHECK(!mCache.getPath(otherSeat, cachedPath));
+    PathCache::Key otherDoors = makeKey(0, 0, 4, 0);
+    otherDoors.mCanCrossEnemyDoors = false;
+    BOOST_CHECK(!mCache.getPath(otherDoors, cachedPath));
+    BOOST_CHECK(!mCache.getPath(makeKey(4, 0, 0, 0), cachedPath));
+    BOOST_CHECK_EQUAL(mCache.getNbMisses(), 3u);
+
+    // Empty paths (no path found) are not cached
+    mCache.addPath(makeKey(0, 1, 4, 1), std::list<Tile*>());
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 1u);
+
+    // Adding a path again replaces it
+    std::list<Tile*> newPath = makeRowPath(0, 0, 4);
+    newPath.insert(++newPath.begin(), mGameMap.getTile(1, 1));
+    mCache.addPath(makeKey(0, 0, 4, 0), newPath);
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 1u);
+    BOOST_REQUIRE(mCache.getPath(makeKey(0, 0, 4, 0), cachedPath));
+    BOOST_CHECK(cachedPath == newPath);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_InvalidateTile, CacheFixture)
+{
+    mCache.addPath(makeKey(0, 0, 4, 0), makeRowPath(0, 0, 4));
+    mCache.addPath(makeKey(0, 2, 4, 2), makeRowPath(2, 0, 4));
+    mCache.addPath(makeKey(2, 0, 6, 0), makeRowPath(0, 2, 6));
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 3u);
+
+    // A tile no path goes through does not drop anything
+    mCache.invalidateTile(*mGameMap.getTile(5, 4));
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 3u);
+
+    // Only the paths going through the tile are dropped
+    mCache.invalidateTile(*mGameMap.getTile(3, 0));
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 1u);
+    std::list<Tile*> cachedPath;
+    BOOST_CHECK(!mCache.getPath(makeKey(0, 0, 4, 0), cachedPath));
+    BOOST_CHECK(!mCache.getPath(makeKey(2, 0, 6, 0), cachedPath));
+    BOOST_CHECK(mCache.getPath(makeKey(0, 2, 4, 2), cachedPath));
+
+    // The end of a path counts too
+    mCache.invalidateTile(*mGameMap.getTile(4, 2));
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 0u);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_Clear, CacheFixture)
+{
+    mCache.addPath(makeKey(0, 0, 4, 0), makeRowPath(0, 0, 4));
+    mCache.addPath(makeKey(0, 2, 4, 2), makeRowPath(2, 0, 4));
+    mCache.clear();
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 0u);
+    std::list<Tile*> cachedPath;
+    BOOST_CHECK(!mCache.getPath(makeKey(0, 0, 4, 0), cachedPath));
+
+    // The cache can be used again. The references from the paths cleared are forgotten so that
+    // invalidating their tiles does not drop the new paths
+    mCache.addPath(makeKey(0, 2, 4, 2), makeRowPath(2, 0, 4));
+    mCache.invalidateTile(*mGameMap.getTile(2, 0));
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 1u);
+    BOOST_CHECK(mCache.getPath(makeKey(0, 2, 4, 2), cachedPath));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_OutdatedReferences, CacheFixture)
+{
+    // The path is dropped through one of its tiles. The other tiles still reference its slot
+    mCache.addPath(makeKey(0, 0, 4, 0), makeRowPath(0, 0, 4));
+    mCache.invalidateTile(*mGameMap.getTile(0, 0));
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 0u);
+
+    // The slot is reused by another path. The former references have an older generation so
+    // invalidating their tiles must not drop the new path
+    mCache.addPath(makeKey(0, 3, 4, 3), makeRowPath(3, 0, 4));
+    for(int xx = 1; xx <= 4; ++xx)
+        mCache.invalidateTile(*mGameMap.getTile(xx, 0));
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 1u);
+    std::list<Tile*> cachedPath;
+    BOOST_REQUIRE(mCache.getPath(makeKey(0, 3, 4, 3), cachedPath));
+    BOOST_CHECK(cachedPath == makeRowPath(3, 0, 4));
+
+    // The same happens when a path is replaced
+    mCache.addPath(makeKey(0, 3, 4, 3), makeRowPath(4, 0, 4));
+    mCache.invalidateTile(*mGameMap.getTile(2, 3));
+    BOOST_CHECK(mCache.getPath(makeKey(0, 3, 4, 3), cachedPath));
+    mCache.invalidateTile(*mGameMap.getTile(2, 4));
+    BOOST_CHECK(!mCache.getPath(makeKey(0, 3, 4, 3), cachedPath));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_ClearAfterTilesFreed, CacheFixture)
+{
+    // Clearing does not read the tiles of the cached paths so it works even if they were already
+    // freed (reading them would be reported by the address sanitizer)
+    mCache.addPath(makeKey(0, 0, 4, 0), makeRowPath(0, 0, 4));
+    mGameMap.clearTiles();
+    mCache.clear();
+    BOOST_CHECK_EQUAL(mCache.getNbPaths(), 0u);
+}
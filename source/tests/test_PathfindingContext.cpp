@@ -0,0 +1,229 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE PathfindingContext
+#include "BoostTestTargetConfig.h"
+
+#include "gamemap/PathfindingContext.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Checks that PathfindingContext gives the same paths as the A* GameMap::path used before the
+// context was introduced (with its open list sorted by insertion). The reference below is that
+// algorithm working on a PassabilitySnapshot instead of the tiles and the creature.
+
+namespace
+{
+const int MAP_SIZE_X = 40;
+const int MAP_SIZE_Y = 30;
+
+//! \brief Fills the snapshot with random tiles. Some are not passable and the others have a random
+//! speed (like ground, water or lava for a creature that can walk on all of them)
+void buildSnapshot(PassabilitySnapshot& snapshot, uint32_t seed, double wallRatio)
+{
+    static const double SPEEDS[3] = {1.0, 0.5, 0.8};
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::uniform_int_distribution<int> speedDist(0, 2);
+    snapshot.mMapSizeX = MAP_SIZE_X;
+    snapshot.mMapSizeY = MAP_SIZE_Y;
+    snapshot.mSpeedGround = SPEEDS[0];
+    snapshot.mSpeedWater = SPEEDS[1];
+    snapshot.mSpeedLava = SPEEDS[2];
+    snapshot.mSpeedsFrom.resize(MAP_SIZE_X * MAP_SIZE_Y);
+    snapshot.mPassable.resize(MAP_SIZE_X * MAP_SIZE_Y);
+    for(uint32_t index = 0; index < snapshot.mPassable.size(); ++index)
+    {
+        // Like full tiles, the tiles that cannot be walked are left at the ground speed
+        bool isPassable = dist(rng) >= wallRatio;
+        snapshot.mPassable[index] = isPassable ? 1 : 0;
+        snapshot.mSpeedsFrom[index] = isPassable ? SPEEDS[speedDist(rng)] : SPEEDS[0];
+    }
+}
+
+class AstarEntry
+{
+public:
+    AstarEntry(int x, int y, AstarEntry* parent, double g, double h) :
+        mX(x),
+        mY(y),
+        mParent(parent),
+        mG(g),
+        mH(h),
+        mHasBeenProcessed(false)
+    {}
+
+    static double computeHeuristic(int x1, int y1, int x2, int y2)
+    {
+        return std::fabs(static_cast<double>(x2 - x1)) + std::fabs(static_cast<double>(y2 - y1));
+    }
+
+    inline double fCost() const
+    { return mG + mH; }
+
+    int mX;
+    int mY;
+    AstarEntry* mParent;
+    double mG;
+    double mH;
+    bool mHasBeenProcessed;
+};
+
+//! \brief The former GameMap::path without the flood fill check and the diggable tiles
+bool referencePath(const PassabilitySnapshot& snapshot, int x1, int y1, int x2, int y2, std::vector<uint32_t>& path)
+{
+    std::vector<std::unique_ptr<AstarEntry>> processList(MAP_SIZE_X * MAP_SIZE_Y);
+    processList[x1 + y1 * MAP_SIZE_X].reset(new AstarEntry(x1, y1, nullptr, 0.0,
+        AstarEntry::computeHeuristic(x1, y1, x2, y2)));
+    std::vector<AstarEntry*> openList;
+    openList.push_back(processList[x1 + y1 * MAP_SIZE_X].get());
+    AstarEntry* destinationEntry = nullptr;
+    while(!openList.empty())
+    {
+        // openList being sorted, the last element is the smallest
+        AstarEntry* currentEntry = openList.back();
+        openList.pop_back();
+        currentEntry->mHasBeenProcessed = true;
+
+        if((currentEntry->mX == x2) && (currentEntry->mY == y2))
+        {
+            destinationEntry = currentEntry;
+            break;
+        }
+
+        static const int NEIGHBORS[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+        static const int DIAGONAL_CONDITIONS[4][2] = {{0, 2}, {0, 3}, {1, 2}, {1, 3}};
+        bool areTilesPassable[4] = {false, false, false, false};
+        for(int i = 0; i < 8; ++i)
+        {
+            if((i >= 4) &&
+               (!areTilesPassable[DIAGONAL_CONDITIONS[i - 4][0]] || !areTilesPassable[DIAGONAL_CONDITIONS[i - 4][1]]))
+            {
+                continue;
+            }
+
+            int neighborX = currentEntry->mX + NEIGHBORS[i][0];
+            int neighborY = currentEntry->mY + NEIGHBORS[i][1];
+            if((neighborX < 0) || (neighborY < 0) || (neighborX >= MAP_SIZE_X) || (neighborY >= MAP_SIZE_Y))
+                continue;
+
+            int neighborIndex = neighborX + neighborY * MAP_SIZE_X;
+            if((snapshot.mPassable[neighborIndex] == 0) && ((neighborX != x1) || (neighborY != y1)))
+                continue;
+
+            if(i < 4)
+                areTilesPassable[i] = true;
+
+            AstarEntry* neighborEntry = processList[neighborIndex].get();
+            if((neighborEntry != nullptr) && neighborEntry->mHasBeenProcessed)
+                continue;
+
+            double weightToParent = AstarEntry::computeHeuristic(neighborX, neighborY, currentEntry->mX, currentEntry->mY);
+            weightToParent /= snapshot.mSpeedsFrom[currentEntry->mX + currentEntry->mY * MAP_SIZE_X];
+            if(neighborEntry == nullptr)
+            {
+                neighborEntry = new AstarEntry(neighborX, neighborY, currentEntry, currentEntry->mG + weightToParent,
+                    AstarEntry::computeHeuristic(neighborX, neighborY, x2, y2));
+                processList[neighborIndex].reset(neighborEntry);
+            }
+            else if(currentEntry->mG + weightToParent < neighborEntry->mG)
+            {
+                neighborEntry->mG = currentEntry->mG + weightToParent;
+                neighborEntry->mParent = currentEntry;
+                openList.erase(std::find(openList.begin(), openList.end(), neighborEntry));
+            }
+            else
+                continue;
+
+            // The new entry goes before the ones with the same cost so that they are processed first
+            auto itr = openList.begin();
+            while((itr != openList.end()) && ((*itr)->fCost() > neighborEntry->fCost()))
+                ++itr;
+
+            openList.insert(itr, neighborEntry);
+        }
+    }
+
+    if(destinationEntry == nullptr)
+        return false;
+
+    path.clear();
+    for(AstarEntry* entry = destinationEntry; entry != nullptr; entry = entry->mParent)
+        path.push_back(static_cast<uint32_t>(entry->mX + entry->mY * MAP_SIZE_X));
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_PathfindingContextMatchesReference)
+{
+    PathfindingContext context;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> distX(0, MAP_SIZE_X - 1);
+    std::uniform_int_distribution<int> distY(0, MAP_SIZE_Y - 1);
+    uint32_t nbPathsFound = 0;
+    for(uint32_t seed = 0; seed < 20; ++seed)
+    {
+        PassabilitySnapshot snapshot;
+        buildSnapshot(snapshot, seed, 0.1 + 0.02 * seed);
+        for(uint32_t i = 0; i < 20; ++i)
+        {
+            int x1 = distX(rng);
+            int y1 = distY(rng);
+            int x2 = distX(rng);
+            int y2 = distY(rng);
+            std::vector<uint32_t> expected;
+            std::vector<uint32_t> path;
+            bool isExpectedFound = referencePath(snapshot, x1, y1, x2, y2, expected);
+            // The same context is used for every search so that its reuse is checked too
+            bool isFound = context.findPath(snapshot, static_cast<uint32_t>(x1 + y1 * MAP_SIZE_X),
+                static_cast<uint32_t>(x2 + y2 * MAP_SIZE_X), path);
+            BOOST_CHECK_EQUAL(isFound, isExpectedFound);
+            if(!isFound || !isExpectedFound)
+                continue;
+
+            ++nbPathsFound;
+            BOOST_CHECK_EQUAL_COLLECTIONS(path.begin(), path.end(), expected.begin(), expected.end());
+        }
+    }
+
+    // Most of the random maps should be open enough to compare actual paths
+    BOOST_CHECK(nbPathsFound > 100);
+}
+
+BOOST_AUTO_TEST_CASE(test_PathfindingContextBlockedStart)
+{
+    // Like a creature standing on a closed door, the start tile can be left even if it is not passable
+    PathfindingContext context;
+    PassabilitySnapshot snapshot;
+    buildSnapshot(snapshot, 0, 0.0);
+    snapshot.mPassable[0] = 0;
+    std::vector<uint32_t> expected;
+    std::vector<uint32_t> path;
+    BOOST_REQUIRE(referencePath(snapshot, 0, 0, 5, 5, expected));
+    BOOST_REQUIRE(context.findPath(snapshot, 0, static_cast<uint32_t>(5 + 5 * MAP_SIZE_X), path));
+    BOOST_CHECK_EQUAL_COLLECTIONS(path.begin(), path.end(), expected.begin(), expected.end());
+
+    // A destination that is not passable cannot be reached
+    snapshot.mPassable[static_cast<uint32_t>(5 + 5 * MAP_SIZE_X)] = 0;
+    BOOST_CHECK(!referencePath(snapshot, 0, 0, 5, 5, expected));
+    BOOST_CHECK(!context.findPath(snapshot, 0, static_cast<uint32_t>(5 + 5 * MAP_SIZE_X), path));
+}
@@ -0,0 +1,84 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/SpscQueue.h"
+
+#define BOOST_TEST_MODULE SpscQueue
+#include "BoostTestTargetConfig.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_CASE(test_SingleThread)
+{
+    SpscQueue<std::string> queue;
+    std::string value;
+    BOOST_CHECK(queue.isEmpty());
+    BOOST_CHECK(!queue.tryPop(value));
+
+    queue.push("a");
+    queue.push("b");
+    BOOST_CHECK(!queue.isEmpty());
+    BOOST_CHECK(queue.tryPop(value));
+    BOOST_CHECK_EQUAL(value, "a");
+
+    queue.push("c");
+    BOOST_CHECK(queue.tryPop(value));
+    BOOST_CHECK_EQUAL(value, "b");
+    BOOST_CHECK(queue.tryPop(value));
+    BOOST_CHECK_EQUAL(value, "c");
+    BOOST_CHECK(queue.isEmpty());
+    BOOST_CHECK(!queue.tryPop(value));
+
+    // Remaining elements are freed with the queue
+    queue.push("d");
+}
+
+BOOST_AUTO_TEST_CASE(test_ProducerConsumer)
+{
+    // The values are popped in the order they were pushed
+    const uint32_t nbValues = 100000;
+    SpscQueue<uint32_t> queue;
+    std::atomic<bool> isOrderValid(true);
+    std::thread consumer([&queue, &isOrderValid, nbValues]()
+    {
+        uint32_t expected = 0;
+        while(expected < nbValues)
+        {
+            uint32_t value;
+            if(!queue.tryPop(value))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if(value != expected)
+                isOrderValid = false;
+
+            ++expected;
+        }
+    });
+
+    for(uint32_t i = 0; i < nbValues; ++i)
+        queue.push(i);
+
+    consumer.join();
+    BOOST_CHECK(isOrderValid);
+    BOOST_CHECK(queue.isEmpty());
+}
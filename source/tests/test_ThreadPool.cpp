@@ -0,0 +1,155 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/ThreadPool.h"
+
+#define BOOST_TEST_MODULE ThreadPool
+#include "BoostTestTargetConfig.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+//! Worker counts every test is run with. 0 means that the calling thread runs everything
+const uint32_t NB_WORKERS[] = { 0, 1, 3 };
+}
+
+BOOST_AUTO_TEST_CASE(test_ParallelForVisitsEachIndexOnce)
+{
+    for(uint32_t nbWorkers : NB_WORKERS)
+    {
+        ThreadPool threadPool(nbWorkers);
+        BOOST_CHECK_EQUAL(threadPool.getNbWorkers(), nbWorkers);
+
+        const uint32_t nbIndexes = 10007;
+        std::vector<std::atomic<uint32_t>> visits(nbIndexes);
+        for(std::atomic<uint32_t>& visit : visits)
+            visit = 0;
+
+        std::atomic<bool> isSlotValid(true);
+        std::atomic<bool> isChunkValid(true);
+        threadPool.parallelFor(0, nbIndexes, 64, [&](uint32_t begin, uint32_t end)
+        {
+            if((begin >= end) || (end - begin > 64))
+                isChunkValid = false;
+            if(threadPool.getCurrentSlot() >= threadPool.getNbSlots())
+                isSlotValid = false;
+
+            for(uint32_t i = begin; i < end; ++i)
+                ++visits[i];
+        });
+
+        BOOST_CHECK(isSlotValid);
+        BOOST_CHECK(isChunkValid);
+        uint32_t nbWrongVisits = 0;
+        for(std::atomic<uint32_t>& visit : visits)
+        {
+            if(visit != 1)
+                ++nbWrongVisits;
+        }
+        BOOST_CHECK_EQUAL(nbWrongVisits, 0);
+
+        // Empty ranges do nothing
+        bool isCalled = false;
+        threadPool.parallelFor(5, 5, 1, [&](uint32_t, uint32_t) { isCalled = true; });
+        BOOST_CHECK(!isCalled);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_ParallelReduceIsDeterministic)
+{
+    // Floating point additions are not associative: the sum only stays the same if the
+    // partial sums are always combined in the same order
+    const uint32_t nbValues = 100000;
+    std::vector<double> values(nbValues);
+    for(uint32_t i = 0; i < nbValues; ++i)
+        values[i] = 1.0 / (1.0 + i * 0.37);
+
+    auto sumChunk = [&values](uint32_t begin, uint32_t end)
+    {
+        double sum = 0.0;
+        for(uint32_t i = begin; i < end; ++i)
+            sum += values[i];
+        return sum;
+    };
+    auto add = [](double a, double b) { return a + b; };
+
+    ThreadPool serialPool(0);
+    double expected = serialPool.parallelReduce(0, nbValues, 1000, 0.0, sumChunk, add);
+    for(uint32_t nbWorkers : NB_WORKERS)
+    {
+        ThreadPool threadPool(nbWorkers);
+        for(int run = 0; run < 10; ++run)
+        {
+            double result = threadPool.parallelReduce(0, nbValues, 1000, 0.0, sumChunk, add);
+            BOOST_CHECK_EQUAL(result, expected);
+        }
+    }
+
+    // The chunks are combined in order
+    ThreadPool threadPool(3);
+    std::vector<uint32_t> firsts = threadPool.parallelReduce(0, 10, 3, std::vector<uint32_t>(),
+        [](uint32_t begin, uint32_t) { return std::vector<uint32_t>(1, begin); },
+        [](std::vector<uint32_t> a, const std::vector<uint32_t>& b)
+        {
+            a.insert(a.end(), b.begin(), b.end());
+            return a;
+        });
+    std::vector<uint32_t> expectedFirsts = { 0, 3, 6, 9 };
+    BOOST_CHECK(firsts == expectedFirsts);
+}
+
+BOOST_AUTO_TEST_CASE(test_TaskGroups)
+{
+    for(uint32_t nbWorkers : NB_WORKERS)
+    {
+        ThreadPool threadPool(nbWorkers);
+        std::atomic<uint32_t> nbTasksDone(0);
+        std::atomic<bool> isNestedGroupDone(true);
+        {
+            TaskGroup taskGroup(threadPool);
+            for(uint32_t i = 0; i < 100; ++i)
+            {
+                taskGroup.run([&threadPool, &nbTasksDone, &isNestedGroupDone]()
+                {
+                    // Tasks can wait for their own groups without blocking the workers
+                    TaskGroup nestedGroup(threadPool);
+                    for(uint32_t j = 0; j < 10; ++j)
+                        nestedGroup.run([&nbTasksDone]() { ++nbTasksDone; });
+                    nestedGroup.wait();
+                    if(!nestedGroup.isDone())
+                        isNestedGroupDone = false;
+                    ++nbTasksDone;
+                });
+            }
+            taskGroup.wait();
+            BOOST_CHECK(taskGroup.isDone());
+            BOOST_CHECK(isNestedGroupDone);
+            BOOST_CHECK_EQUAL(nbTasksDone.load(), 1100);
+        }
+
+        // A group that is not waited for is waited for when destroyed
+        {
+            TaskGroup taskGroup(threadPool);
+            for(uint32_t i = 0; i < 50; ++i)
+                taskGroup.run([&nbTasksDone]() { ++nbTasksDone; });
+        }
+        BOOST_CHECK_EQUAL(nbTasksDone.load(), 1150);
+    }
+}
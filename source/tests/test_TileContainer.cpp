@@ -0,0 +1,146 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE TileContainer
+#include "BoostTestTargetConfig.h"
+
+#include "entities/Tile.h"
+#include "gamemap/GameMap.h"
+#include "utils/LogManager.h"
+#include "utils/LogSinkConsole.h"
+
+#include <memory>
+
+// The tiles need a gamemap. We use a client one because it does not need the server
+// resources (like the simulation threads). Its tiles have no mesh until they are rendered.
+
+namespace
+{
+const int MAP_SIZE_X = 7;
+const int MAP_SIZE_Y = 5;
+
+struct LogFixture
+{
+    LogFixture()
+    {
+        mLogMgr.addSink(std::unique_ptr<LogSink>(new LogSinkConsole()));
+    }
+
+    LogManager mLogMgr;
+};
+}
+
+BOOST_FIXTURE_TEST_CASE(test_Allocation, LogFixture)
+{
+    GameMap gameMap(false);
+    BOOST_CHECK(!gameMap.createNewMap(0, MAP_SIZE_Y));
+    BOOST_CHECK(!gameMap.createNewMap(MAP_SIZE_X, -1));
+
+    BOOST_REQUIRE(gameMap.createNewMap(MAP_SIZE_X, MAP_SIZE_Y));
+    BOOST_CHECK_EQUAL(gameMap.getMapSizeX(), MAP_SIZE_X);
+    BOOST_CHECK_EQUAL(gameMap.getMapSizeY(), MAP_SIZE_Y);
+    BOOST_CHECK_EQUAL(gameMap.getNbTiles(), static_cast<uint32_t>(MAP_SIZE_X * MAP_SIZE_Y));
+
+    for(int yy = 0; yy < MAP_SIZE_Y; ++yy)
+    {
+        for(int xx = 0; xx < MAP_SIZE_X; ++xx)
+        {
+            Tile* tile = gameMap.getTile(xx, yy);
+            BOOST_REQUIRE(tile != nullptr);
+            BOOST_CHECK_EQUAL(tile->getX(), xx);
+            BOOST_CHECK_EQUAL(tile->getY(), yy);
+            BOOST_CHECK(tile->getType() == TileType::dirt);
+            BOOST_CHECK(tile->getGameMap() == &gameMap);
+        }
+    }
+
+    // The tiles are stored row by row in a single block
+    Tile* first = gameMap.getTile(0, 0);
+    BOOST_CHECK(gameMap.getTile(1, 0) == first + 1);
+    BOOST_CHECK(gameMap.getTile(0, 1) == first + MAP_SIZE_X);
+    BOOST_CHECK(gameMap.getTile(MAP_SIZE_X - 1, MAP_SIZE_Y - 1) == first + MAP_SIZE_X * MAP_SIZE_Y - 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_GetTileBounds, LogFixture)
+{
+    GameMap gameMap(false);
+    BOOST_REQUIRE(gameMap.createNewMap(MAP_SIZE_X, MAP_SIZE_Y));
+
+    BOOST_CHECK(gameMap.getTile(0, 0) != nullptr);
+    BOOST_CHECK(gameMap.getTile(MAP_SIZE_X - 1, 0) != nullptr);
+    BOOST_CHECK(gameMap.getTile(0, MAP_SIZE_Y - 1) != nullptr);
+    BOOST_CHECK(gameMap.getTile(MAP_SIZE_X - 1, MAP_SIZE_Y - 1) != nullptr);
+
+    BOOST_CHECK(gameMap.getTile(-1, 0) == nullptr);
+    BOOST_CHECK(gameMap.getTile(0, -1) == nullptr);
+    BOOST_CHECK(gameMap.getTile(MAP_SIZE_X, 0) == nullptr);
+    BOOST_CHECK(gameMap.getTile(0, MAP_SIZE_Y) == nullptr);
+    BOOST_CHECK(gameMap.getTile(MAP_SIZE_X, MAP_SIZE_Y) == nullptr);
+    // Out of the row but still within the block
+    BOOST_CHECK(gameMap.getTile(MAP_SIZE_X, 1) == nullptr);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_IndexMapping, LogFixture)
+{
+    GameMap gameMap(false);
+    BOOST_REQUIRE(gameMap.createNewMap(MAP_SIZE_X, MAP_SIZE_Y));
+
+    for(uint32_t index = 0; index < gameMap.getNbTiles(); ++index)
+    {
+        Tile* tile = gameMap.getTileByIndex(index);
+        BOOST_REQUIRE(tile != nullptr);
+        BOOST_CHECK_EQUAL(gameMap.getTileIndex(tile), index);
+        BOOST_CHECK_EQUAL(gameMap.getTileIndex(tile->getX(), tile->getY()), index);
+        BOOST_CHECK(gameMap.getTile(tile->getX(), tile->getY()) == tile);
+    }
+
+    uint32_t index = gameMap.getTileIndex(3, 2);
+    BOOST_CHECK_EQUAL(gameMap.getNeighborIndex(index, 1, 0), static_cast<int32_t>(gameMap.getTileIndex(4, 2)));
+    BOOST_CHECK_EQUAL(gameMap.getNeighborIndex(index, 0, -1), static_cast<int32_t>(gameMap.getTileIndex(3, 1)));
+    BOOST_CHECK_EQUAL(gameMap.getNeighborIndex(index, -1, 1), static_cast<int32_t>(gameMap.getTileIndex(2, 3)));
+
+    // The neighbors outside the map do not wrap around to the next or previous row
+    BOOST_CHECK_EQUAL(gameMap.getNeighborIndex(gameMap.getTileIndex(0, 2), -1, 0), -1);
+    BOOST_CHECK_EQUAL(gameMap.getNeighborIndex(gameMap.getTileIndex(MAP_SIZE_X - 1, 2), 1, 0), -1);
+    BOOST_CHECK_EQUAL(gameMap.getNeighborIndex(gameMap.getTileIndex(3, 0), 0, -1), -1);
+    BOOST_CHECK_EQUAL(gameMap.getNeighborIndex(gameMap.getTileIndex(3, MAP_SIZE_Y - 1), 0, 1), -1);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_Destruction, LogFixture)
+{
+    GameMap gameMap(false);
+    BOOST_REQUIRE(gameMap.createNewMap(MAP_SIZE_X, MAP_SIZE_Y));
+
+    gameMap.clearTiles();
+    BOOST_CHECK_EQUAL(gameMap.getMapSizeX(), 0);
+    BOOST_CHECK_EQUAL(gameMap.getMapSizeY(), 0);
+    BOOST_CHECK_EQUAL(gameMap.getNbTiles(), 0u);
+
+    // The container can be allocated again with another size
+    BOOST_REQUIRE(gameMap.createNewMap(MAP_SIZE_Y, MAP_SIZE_X));
+    BOOST_CHECK_EQUAL(gameMap.getNbTiles(), static_cast<uint32_t>(MAP_SIZE_X * MAP_SIZE_Y));
+    Tile* tile = gameMap.getTile(MAP_SIZE_Y - 1, MAP_SIZE_X - 1);
+    BOOST_REQUIRE(tile != nullptr);
+    BOOST_CHECK_EQUAL(tile->getX(), MAP_SIZE_Y - 1);
+    BOOST_CHECK_EQUAL(tile->getY(), MAP_SIZE_X - 1);
+    BOOST_CHECK(gameMap.getTile(MAP_SIZE_X - 1, 0) == nullptr);
+
+    // Allocating again without clearing replaces the tiles. The remaining ones are freed
+    // with the gamemap
+    BOOST_REQUIRE(gameMap.createNewMap(MAP_SIZE_X, MAP_SIZE_Y));
+    BOOST_CHECK(gameMap.getTile(MAP_SIZE_X - 1, 0) != nullptr);
+}
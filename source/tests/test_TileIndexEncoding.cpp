@@ -0,0 +1,166 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE TileIndexEncoding
+#include "BoostTestTargetConfig.h"
+
+#include "network/ODPacket.h"
+#include "network/TileIndexEncoding.h"
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares the size of the refreshVisibleTiles lists with the old format (number of tiles then
+// x and y of each tile) and with TileIndexEncoding for typical vision changes.
+
+namespace
+{
+const int MAP_SIZE_X = 100;
+const int MAP_SIZE_Y = 80;
+
+uint32_t tileIndex(int xx, int yy)
+{
+    return static_cast<uint32_t>(xx + yy * MAP_SIZE_X);
+}
+
+//! \brief Tiles within radius of the given center (without walls)
+std::vector<uint32_t> circle(int x, int y, int radius)
+{
+    std::vector<uint32_t> indexes;
+    for(int yy = std::max(0, y - radius); yy <= std::min(MAP_SIZE_Y - 1, y + radius); ++yy)
+    {
+        for(int xx = std::max(0, x - radius); xx <= std::min(MAP_SIZE_X - 1, x + radius); ++xx)
+        {
+            if((xx - x) * (xx - x) + (yy - y) * (yy - y) > radius * radius)
+                continue;
+
+            indexes.push_back(tileIndex(xx, yy));
+        }
+    }
+    return indexes;
+}
+
+std::size_t oldFormatSize(const std::vector<uint32_t>& indexes)
+{
+    ODPacket packet;
+    uint32_t nbTiles = static_cast<uint32_t>(indexes.size());
+    packet << nbTiles;
+    for(uint32_t index : indexes)
+    {
+        int32_t xx = static_cast<int32_t>(index % MAP_SIZE_X);
+        int32_t yy = static_cast<int32_t>(index / MAP_SIZE_X);
+        packet << xx << yy;
+    }
+    return packet.getDataSize();
+}
+
+void checkScenario(const std::string& name, std::vector<uint32_t> indexes)
+{
+    std::sort(indexes.begin(), indexes.end());
+    indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+
+    ODPacket packet;
+    TileIndexEncoding::writeTileIndexes(packet, indexes, MAP_SIZE_X, MAP_SIZE_Y);
+    std::size_t newSize = packet.getDataSize();
+    std::size_t oldSize = oldFormatSize(indexes);
+    BOOST_TEST_MESSAGE(name + ": " + std::to_string(indexes.size()) + " tiles, old format="
+        + std::to_string(oldSize) + " bytes, new format=" + std::to_string(newSize) + " bytes");
+
+    std::vector<uint32_t> result;
+    BOOST_REQUIRE(TileIndexEncoding::readTileIndexes(packet, MAP_SIZE_X, MAP_SIZE_Y, result));
+    std::sort(result.begin(), result.end());
+    BOOST_CHECK(result == indexes);
+
+    // The encoding byte is the only overhead allowed compared to the old format
+    BOOST_CHECK(newSize <= oldSize + 1);
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_TileIndexEncodingBandwidth)
+{
+    checkScenario("Empty", {});
+    checkScenario("Single tile", {tileIndex(42, 17)});
+    checkScenario("Creature sight", circle(30, 30, 7));
+    checkScenario("Creature at the map border", circle(0, 40, 10));
+    checkScenario("Eye of evil", circle(70, 20, 15));
+
+    // A creature moving one tile to the right gains vision on the right border of its sight
+    std::vector<uint32_t> before = circle(50, 50, 10);
+    std::vector<uint32_t> after = circle(51, 50, 10);
+    std::vector<uint32_t> gained;
+    std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(gained));
+    checkScenario("Creature moving", gained);
+
+    // Several creatures moving in a dungeon
+    std::vector<uint32_t> several;
+    for(int i = 0; i < 5; ++i)
+    {
+        std::vector<uint32_t> tiles = circle(10 + 15 * i, 10 + 10 * i, 6);
+        several.insert(several.end(), tiles.begin(), tiles.end());
+    }
+    checkScenario("Several creatures", several);
+
+    std::mt19937 rng(12);
+    std::uniform_int_distribution<uint32_t> dist(0, MAP_SIZE_X * MAP_SIZE_Y - 1);
+    std::vector<uint32_t> scattered;
+    for(int i = 0; i < 200; ++i)
+        scattered.push_back(dist(rng));
+    checkScenario("Scattered tiles", scattered);
+
+    std::vector<uint32_t> fullMap;
+    for(uint32_t index = 0; index < MAP_SIZE_X * MAP_SIZE_Y; ++index)
+        fullMap.push_back(index);
+    checkScenario("Full map", fullMap);
+
+    std::vector<uint32_t> checkerboard;
+    for(int yy = 20; yy < 40; ++yy)
+    {
+        for(int xx = 20 + (yy % 2); xx < 40; xx += 2)
+            checkerboard.push_back(tileIndex(xx, yy));
+    }
+    checkScenario("Checkerboard", checkerboard);
+}
+
+BOOST_AUTO_TEST_CASE(test_TileIndexEncodingInvalid)
+{
+    // Indexes outside the map are refused
+    {
+        ODPacket packet;
+        TileIndexEncoding::writeTileIndexes(packet, {tileIndex(10, 10)}, MAP_SIZE_X, MAP_SIZE_Y);
+        std::vector<uint32_t> result;
+        BOOST_CHECK(!TileIndexEncoding::readTileIndexes(packet, 10, 10, result));
+    }
+    {
+        ODPacket packet;
+        TileIndexEncoding::writeTileIndexes(packet, circle(50, 50, 10), MAP_SIZE_X, MAP_SIZE_Y);
+        std::vector<uint32_t> result;
+        BOOST_CHECK(!TileIndexEncoding::readTileIndexes(packet, 40, 40, result));
+    }
+    // Truncated packet
+    {
+        ODPacket packet;
+        uint8_t encoding = 0;
+        uint32_t nbTiles = 3;
+        uint32_t index = 5;
+        packet << encoding << nbTiles << index;
+        std::vector<uint32_t> result;
+        BOOST_CHECK(!TileIndexEncoding::readTileIndexes(packet, MAP_SIZE_X, MAP_SIZE_Y, result));
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/BitVector.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+void BitVector::resize(uint32_t nbBits)
+{
+    mNbBits = nbBits;
+    mWords.assign((nbBits + 63) / 64, 0);
+}
+
+void BitVector::reset()
+{
+    std::fill(mWords.begin(), mWords.end(), 0);
+}
+
+void BitVector::assignOr(const BitVector& a, const BitVector& b)
+{
+    assert((a.mNbBits == mNbBits) && (b.mNbBits == mNbBits));
+    // Plain loops over the words so that the compiler can vectorize them
+    uint64_t* words = mWords.data();
+    const uint64_t* wordsA = a.mWords.data();
+    const uint64_t* wordsB = b.mWords.data();
+    uint32_t nbWords = static_cast<uint32_t>(mWords.size());
+    for(uint32_t i = 0; i < nbWords; ++i)
+        words[i] = wordsA[i] | wordsB[i];
+}
+
+void BitVector::orWith(const BitVector& other)
+{
+    assert(other.mNbBits == mNbBits);
+    uint64_t* words = mWords.data();
+    const uint64_t* wordsOther = other.mWords.data();
+    uint32_t nbWords = static_cast<uint32_t>(mWords.size());
+    for(uint32_t i = 0; i < nbWords; ++i)
+        words[i] |= wordsOther[i];
+}
+
+uint32_t BitVector::lowestBitIndex(uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<uint32_t>(__builtin_ctzll(word));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<uint32_t>(index);
+#else
+    uint32_t index = 0;
+    while((word & 1) == 0)
+    {
+        word >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BITVECTOR_H
+#define BITVECTOR_H
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+/*! \brief Packed array of bits with a runtime size. The bits are stored in 64 bits words so that
+ * whole vectors can be combined word by word (the loops are simple enough to be vectorized
+ * by the compiler). The bits after the size in the last word are always 0.
+ */
+class BitVector
+{
+public:
+    BitVector() :
+        mNbBits(0)
+    {}
+
+    //! \brief Sets the number of bits. Every bit is set to false
+    void resize(uint32_t nbBits);
+
+    //! \brief Sets every bit to false
+    void reset();
+
+    inline uint32_t size() const
+    { return mNbBits; }
+
+    inline bool test(uint32_t index) const
+    {
+        assert(index < mNbBits);
+        return (mWords[index / 64] & (static_cast<uint64_t>(1) << (index % 64))) != 0;
+    }
+
+    inline void set(uint32_t index, bool value)
+    {
+        assert(index < mNbBits);
+        uint64_t mask = static_cast<uint64_t>(1) << (index % 64);
+        if(value)
+            mWords[index / 64] |= mask;
+        else
+            mWords[index / 64] &= ~mask;
+    }
+
+    //! \brief Sets this vector to a | b. Every vector must have the same size
+    void assignOr(const BitVector& a, const BitVector& b);
+
+    //! \brief Sets this vector to this | other. Both vectors must have the same size
+    void orWith(const BitVector& other);
+
+    //! \brief Calls function(index) for every bit set to true
+    template<typename Function>
+    void forEachSetBit(Function function) const
+    {
+        for(uint32_t wordIndex = 0; wordIndex < mWords.size(); ++wordIndex)
+            forEachBit(mWords[wordIndex], wordIndex, function);
+    }
+
+    //! \brief Calls function(index, valueInA) for every bit that is different in a and b. Both vectors
+    //! must have the same size
+    template<typename Function>
+    static void forEachDifference(const BitVector& a, const BitVector& b, Function function)
+    {
+        assert(a.mNbBits == b.mNbBits);
+        for(uint32_t wordIndex = 0; wordIndex < a.mWords.size(); ++wordIndex)
+        {
+            uint64_t difference = a.mWords[wordIndex] ^ b.mWords[wordIndex];
+            if(difference == 0)
+                continue;
+
+            uint64_t wordA = a.mWords[wordIndex];
+            while(difference != 0)
+            {
+                uint32_t bit = lowestBitIndex(difference);
+                function(wordIndex * 64 + bit, (wordA & (static_cast<uint64_t>(1) << bit)) != 0);
+                // Clears the lowest bit set
+                difference &= difference - 1;
+            }
+        }
+    }
+
+private:
+    template<typename Function>
+    static inline void forEachBit(uint64_t word, uint32_t wordIndex, Function& function)
+    {
+        while(word != 0)
+        {
+            uint32_t bit = lowestBitIndex(word);
+            function(wordIndex * 64 + bit);
+            // Clears the lowest bit set
+            word &= word - 1;
+        }
+    }
+
+    static uint32_t lowestBitIndex(uint64_t word);
+
+    uint32_t mNbBits;
+    std::vector<uint64_t> mWords;
+};
+
+#endif // BITVECTOR_H
@@ -0,0 +1,98 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/DisjointSets.h"
+
+void DisjointSets::clear()
+{
+    mParent.clear();
+    mSize.clear();
+    mName.clear();
+}
+
+void DisjointSets::reserveValue(uint32_t value)
+{
+    uint32_t oldSize = static_cast<uint32_t>(mParent.size());
+    if(value < oldSize)
+        return;
+
+    // Values are usually allocated in increasing order so we grow by chunks
+    uint32_t newSize = value + 1 + (value / 2);
+    mParent.resize(newSize);
+    mSize.resize(newSize, 1);
+    mName.resize(newSize);
+    for(uint32_t i = oldSize; i < newSize; ++i)
+    {
+        mParent[i] = i;
+        mName[i] = i;
+    }
+}
+
+uint32_t DisjointSets::findRoot(uint32_t value)
+{
+    uint32_t root = value;
+    while(mParent[root] != root)
+        root = mParent[root];
+
+    // Path compression
+    while(mParent[value] != root)
+    {
+        uint32_t next = mParent[value];
+        mParent[value] = root;
+        value = next;
+    }
+
+    return root;
+}
+
+uint32_t DisjointSets::find(uint32_t value) const
+{
+    // Values that were never merged are alone in their set
+    if(value >= mParent.size())
+        return value;
+
+    // No path compression here: the sets are only read
+    uint32_t root = value;
+    while(mParent[root] != root)
+        root = mParent[root];
+
+    return mName[root];
+}
+
+void DisjointSets::merge(uint32_t value, uint32_t valueKept)
+{
+    if((value == 0) || (valueKept == 0))
+        return;
+
+    reserveValue(value > valueKept ? value : valueKept);
+    uint32_t root = findRoot(value);
+    uint32_t rootKept = findRoot(valueKept);
+    if(root == rootKept)
+        return;
+
+    uint32_t name = mName[rootKept];
+    if(mSize[root] > mSize[rootKept])
+    {
+        uint32_t tmp = root;
+        root = rootKept;
+        rootKept = tmp;
+    }
+
+    mParent[root] = rootKept;
+    mSize[rootKept] += mSize[root];
+    mName[rootKept] = name;
+}
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISJOINTSETS_H
+#define DISJOINTSETS_H
+
+#include <cstdint>
+#include <vector>
+
+/*! \brief Union-find structure over unsigned integer values.
+ *
+ * Every value starts in its own set, named after the value. When 2 sets are merged, the
+ * caller chooses which name the merged set keeps. That allows to use set names like colors:
+ * a value that was a set name stays valid as long as its set is not merged into another one.
+ * Union by size keeps the trees logarithmic. Paths are only compressed by merge: find does not
+ * modify the sets so that several threads can search them at the same time (while nobody merges).
+ * Note that the value 0 is reserved and is never merged.
+ */
+class DisjointSets
+{
+public:
+    //! \brief Puts back every value in its own set
+    void clear();
+
+    //! \brief Returns the name of the set the given value belongs to
+    uint32_t find(uint32_t value) const;
+
+    //! \brief Merges the set containing value into the set containing valueKept. The merged
+    //! set is named like the set of valueKept
+    void merge(uint32_t value, uint32_t valueKept);
+
+private:
+    //! \brief Makes sure the given value can be stored
+    void reserveValue(uint32_t value);
+
+    uint32_t findRoot(uint32_t value);
+
+    std::vector<uint32_t> mParent;
+    //! \brief Number of values in the set. Only meaningful for roots
+    std::vector<uint32_t> mSize;
+    //! \brief Name of the set. Only meaningful for roots
+    std::vector<uint32_t> mName;
+};
+
+#endif // DISJOINTSETS_H
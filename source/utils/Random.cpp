@@ -30,19 +30,25 @@
 unsigned long myRandomSeed;
 const unsigned long MAX = 32768;
 
-static unsigned long randgen()
+static unsigned long randgen(unsigned long& seed)
 {
-    myRandomSeed = myRandomSeed * 1103515245 + 12345;
+    seed = seed * 1103515245 + 12345;
     //TODO: What is the purpose of the cast?
-    unsigned long returnVal = static_cast<unsigned int>(myRandomSeed / 65536) % MAX;
+    unsigned long returnVal = static_cast<unsigned int>(seed / 65536) % MAX;
 
     return returnVal;
 }
 
+//! \brief uniformly distributed number [0;1) from the given seed
+static double uniform(unsigned long& seed)
+{
+    return randgen(seed) * 1.0 / static_cast<double>(MAX);
+}
+
 //! \brief uniformly distributed number [0;1)
 static double uniform()
 {
-    return randgen() * 1.0 / static_cast<double>(MAX);
+    return uniform(myRandomSeed);
 }
 
 //! \brief uniformly distributed number [lo;hi)
@@ -107,4 +113,24 @@ double gaussianRandomDouble()
     return std::sqrt(-2.0 * log(Double(0.0, 1.0))) * cos(2.0 * PI * Double(0.0, 1.0));
 }
 
+int Generator::Int(int min, int max)
+{
+    if (min > max)
+    {
+        std::swap(min, max);
+    }
+
+    return static_cast<int>(uniform(mSeed) * (max - min + 1) + min);
+}
+
+unsigned int Generator::Uint(unsigned int min, unsigned int max)
+{
+    if (min > max)
+    {
+        std::swap(min, max);
+    }
+
+    return static_cast<unsigned int>(uniform(mSeed) * (max - min + 1) + min);
+}
+
 } // namespace Random
@@ -60,6 +60,26 @@ namespace Random
      *  \return a gaussian distributed random double value in [-1,1]
      */
     double gaussianRandomDouble();
+
+    /*! \brief Generator with its own seed. Unlike the functions above, it can be used on a worker
+     * thread. Given the same seed, it gives the same numbers whatever the other threads do
+     */
+    class Generator
+    {
+    public:
+        explicit Generator(unsigned long seed) :
+            mSeed(seed)
+        {}
+
+        //! \brief Same as Random::Int
+        int Int(int min, int max);
+
+        //! \brief Same as Random::Uint
+        unsigned int Uint(unsigned int min, unsigned int max);
+
+    private:
+        unsigned long mSeed;
+    };
 }
 
 #endif // RANDOM_H_
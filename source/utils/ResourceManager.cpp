@@ -53,6 +53,7 @@
 
 #include "utils/LogManager.h"
 #include "utils/Helper.h"
+#include "utils/ThreadPool.h"
 
 #include <boost/program_options.hpp>
 
@@ -87,6 +88,7 @@ const std::string ResourceManager::RESOURCEGROUPSOUND = "Sound";
 ResourceManager::ResourceManager(boost::program_options::variables_map& options) :
         mServerMode(false),
         mForcedNetworkPort(-1),
+        mNbSimulationThreads(-1),
         mLogLevel(LogMessageLevel::NORMAL),
         mGameDataPath("./"),
         mUserDataPath("./"),
@@ -442,6 +444,10 @@ void ResourceManager::setupUserDataFolders(boost::program_options::variables_map
     if(itOption != options.end())
         mLogLevel = static_cast<LogMessageLevel>(itOption->second.as<int32_t>());
 
+    itOption = options.find("simthreads");
+    if(itOption != options.end())
+        mNbSimulationThreads = itOption->second.as<int32_t>();
+
     mUserConfigFile = mUserConfigPath + USERCFGFILENAME;
     mCeguiLogFile = mUserDataPath + CEGUILOGFILENAME;
     mShaderCachePath = mUserDataPath + SHADERCACHESUBPATH;
@@ -600,9 +606,18 @@ void ResourceManager::buildCommandOptions(boost::program_options::options_descri
         ("mscreator", boost::program_options::value<std::string>(), "Sets the creator for this map to connect to the master server. server/servercustom/serversave option needs to be on")
         ("port", boost::program_options::value<int32_t>(), "Sets the port used. Note that the port is used for both single and multi player")
         ("loglevel", boost::program_options::value<int32_t>(), "Sets the log level (between 0=Trivial and 3=Critical)")
+        ("simthreads", boost::program_options::value<int32_t>(), "Sets the number of worker threads used by the game simulation (0 to run it on the main thread only)")
     ;
 }
 
+uint32_t ResourceManager::getNbSimulationThreads() const
+{
+    if(mNbSimulationThreads < 0)
+        return ThreadPool::getDefaultNbWorkers();
+
+    return static_cast<uint32_t>(mNbSimulationThreads);
+}
+
 std::string ResourceManager::getGameLevelPathSkirmish() const
 {
     return getGameDataPath() + "levels/skirmish/";
@@ -151,6 +151,10 @@ public:
     inline LogMessageLevel getLogLevel() const
     { return mLogLevel; }
 
+    //! \brief Number of worker threads of the simulation thread pool. If it was not given in
+    //! the command line, ThreadPool::getDefaultNbWorkers is used
+    uint32_t getNbSimulationThreads() const;
+
 private:
     //! \brief used when the executable is launched in server mode
     bool mServerMode;
@@ -160,6 +164,9 @@ private:
     //! \brief used when the network port is forced
     int32_t mForcedNetworkPort;
 
+    //! \brief Number of simulation worker threads given in the command line (-1 if none)
+    int32_t mNbSimulationThreads;
+
     //! \brief The log level
     LogMessageLevel mLogLevel;
 
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+/*! \brief Unbounded lock free queue for exactly one producer thread and one consumer thread.
+ * The producer only uses push and the consumer only uses tryPop and isEmpty. The elements are
+ * stored in a linked list whose first node has already been popped: the producer only writes
+ * the last node and the consumer only frees the nodes before the first one, so they never
+ * need to lock each other. T has to be default constructible.
+ */
+template<typename T>
+class SpscQueue
+{
+public:
+    SpscQueue() :
+        mHead(new Node),
+        mTail(mHead)
+    {}
+
+    ~SpscQueue()
+    {
+        while(mHead != nullptr)
+        {
+            Node* next = mHead->mNext.load(std::memory_order_relaxed);
+            delete mHead;
+            mHead = next;
+        }
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    //! \brief Called by the producer
+    void push(T value)
+    {
+        Node* node = new Node;
+        node->mValue = std::move(value);
+        // The release makes the value visible to the consumer once it sees the node
+        mTail->mNext.store(node, std::memory_order_release);
+        mTail = node;
+    }
+
+    //! \brief Called by the consumer. Returns false if the queue is empty
+    bool tryPop(T& value)
+    {
+        Node* next = mHead->mNext.load(std::memory_order_acquire);
+        if(next == nullptr)
+            return false;
+
+        // next becomes the already popped first node
+        value = std::move(next->mValue);
+        next->mValue = T();
+        delete mHead;
+        mHead = next;
+        return true;
+    }
+
+    //! \brief Called by the consumer
+    bool isEmpty() const
+    {
+        return mHead->mNext.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node
+    {
+        Node() :
+            mValue(),
+            mNext(nullptr)
+        {}
+
+        T mValue;
+        std::atomic<Node*> mNext;
+    };
+
+    //! \brief Only used by the consumer
+    Node* mHead;
+    //! \brief Only used by the producer
+    Node* mTail;
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,217 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/ThreadPool.h"
+
+const uint32_t ThreadPool::MAX_DEFAULT_WORKERS = 4;
+
+//! \brief Pool the calling thread is a worker of (if any) and its index in this pool
+static thread_local const ThreadPool* gWorkerThreadPool = nullptr;
+static thread_local uint32_t gWorkerIndex = 0;
+
+ThreadPool::ThreadPool(uint32_t nbWorkers) :
+    mNbQueuedTasks(0),
+    mIsStopping(false)
+{
+    for(uint32_t i = 0; i < nbWorkers + 1; ++i)
+        mQueues.emplace_back(new TaskQueue);
+
+    for(uint32_t i = 0; i < nbWorkers; ++i)
+        mWorkers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mIsStopping = true;
+    }
+    mWakeCondition.notify_all();
+
+    for(std::thread& worker : mWorkers)
+        worker.join();
+}
+
+uint32_t ThreadPool::getCurrentSlot() const
+{
+    if(gWorkerThreadPool == this)
+        return gWorkerIndex;
+
+    return getNbWorkers();
+}
+
+void ThreadPool::parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize,
+    const std::function<void(uint32_t, uint32_t)>& func)
+{
+    if(end <= begin)
+        return;
+
+    if(grainSize == 0)
+        grainSize = 1;
+
+    // Without workers or with only one chunk, there is nothing to share
+    if((getNbWorkers() == 0) || (end - begin <= grainSize))
+    {
+        for(uint32_t first = begin; first < end; first += grainSize)
+        {
+            uint32_t last = (end - first > grainSize) ? first + grainSize : end;
+            func(first, last);
+            if(last == end)
+                break;
+        }
+
+        return;
+    }
+
+    TaskGroup taskGroup(*this);
+    for(uint32_t first = begin; first < end; first += grainSize)
+    {
+        uint32_t last = (end - first > grainSize) ? first + grainSize : end;
+        taskGroup.run([&func, first, last]()
+        {
+            func(first, last);
+        });
+
+        // Avoids wrapping around when end is close to the maximum value
+        if(last == end)
+            break;
+    }
+    taskGroup.wait();
+}
+
+uint32_t ThreadPool::getDefaultNbWorkers()
+{
+    uint32_t nbCores = std::thread::hardware_concurrency();
+    if(nbCores <= 1)
+        return 0;
+
+    if(nbCores - 1 > MAX_DEFAULT_WORKERS)
+        return MAX_DEFAULT_WORKERS;
+
+    return nbCores - 1;
+}
+
+void ThreadPool::push(Task&& task)
+{
+    TaskQueue& queue = *mQueues[getCurrentSlot()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mMutex);
+        queue.mTasks.push_back(std::move(task));
+    }
+    mNbQueuedTasks.fetch_add(1);
+
+    // We lock the mutex so that a worker cannot miss the notification between its check
+    // of mNbQueuedTasks and its wait
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+    }
+    mWakeCondition.notify_one();
+}
+
+bool ThreadPool::tryRunTask(uint32_t slot)
+{
+    Task task;
+    bool isFound = false;
+
+    // We run the last task of our queue first: it is likely to use the same data as the current one
+    {
+        TaskQueue& queue = *mQueues[slot];
+        std::lock_guard<std::mutex> lock(queue.mMutex);
+        if(!queue.mTasks.empty())
+        {
+            task = std::move(queue.mTasks.back());
+            queue.mTasks.pop_back();
+            isFound = true;
+        }
+    }
+
+    // If there is none, we steal the oldest task of another queue
+    uint32_t nbQueues = static_cast<uint32_t>(mQueues.size());
+    for(uint32_t i = 1; !isFound && (i < nbQueues); ++i)
+    {
+        TaskQueue& queue = *mQueues[(slot + i) % nbQueues];
+        std::lock_guard<std::mutex> lock(queue.mMutex);
+        if(queue.mTasks.empty())
+            continue;
+
+        task = std::move(queue.mTasks.front());
+        queue.mTasks.pop_front();
+        isFound = true;
+    }
+
+    if(!isFound)
+        return false;
+
+    mNbQueuedTasks.fetch_sub(1);
+    task.mFunc();
+    // The captures are released before the group may be seen as done
+    task.mFunc = nullptr;
+    task.mGroup->mNbPendingTasks.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void ThreadPool::workerLoop(uint32_t index)
+{
+    gWorkerThreadPool = this;
+    gWorkerIndex = index;
+
+    while(true)
+    {
+        if(tryRunTask(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWakeCondition.wait(lock, [this]()
+        {
+            return mIsStopping || (mNbQueuedTasks.load() > 0);
+        });
+
+        if(mIsStopping)
+            return;
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool& threadPool) :
+    mThreadPool(threadPool),
+    mNbPendingTasks(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    wait();
+}
+
+void TaskGroup::run(std::function<void()> func)
+{
+    mNbPendingTasks.fetch_add(1);
+    ThreadPool::Task task;
+    task.mFunc = std::move(func);
+    task.mGroup = this;
+    mThreadPool.push(std::move(task));
+}
+
+void TaskGroup::wait()
+{
+    uint32_t slot = mThreadPool.getCurrentSlot();
+    while(!isDone())
+    {
+        // While the tasks of this group are running on other threads, we help with the queued ones
+        if(!mThreadPool.tryRunTask(slot))
+            std::this_thread::yield();
+    }
+}
@@ -0,0 +1,171 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+/*! \brief Work stealing thread pool shared by the simulation subsystems.
+ * Each worker has its own queue. A worker runs the last task pushed on its queue first and, when its
+ * queue is empty, steals the oldest task from the other queues. Tasks pushed from a thread that is not a
+ * worker go to an additional queue. The thread waiting for a TaskGroup runs queued tasks meanwhile so
+ * that a pool without workers runs everything on the calling thread.
+ * Each thread running tasks has a slot (see getCurrentSlot) that can be used to index per thread
+ * scratch data. Only one thread that is not a worker should use the pool at a time.
+ */
+class ThreadPool
+{
+    friend class TaskGroup;
+
+public:
+    //! \brief Starts nbWorkers worker threads
+    explicit ThreadPool(uint32_t nbWorkers);
+    ~ThreadPool();
+
+    inline uint32_t getNbWorkers() const
+    { return static_cast<uint32_t>(mWorkers.size()); }
+
+    //! \brief Number of threads that may run tasks: the workers and the thread waiting for them
+    inline uint32_t getNbSlots() const
+    { return getNbWorkers() + 1; }
+
+    //! \brief Returns the index of the calling thread if it is a worker of this pool and getNbWorkers() otherwise
+    uint32_t getCurrentSlot() const;
+
+    /*! \brief Calls func(chunkBegin, chunkEnd) for consecutive chunks of at most grainSize indexes covering
+     * [begin, end[ and returns when every chunk is done. The chunks may run at the same time on any slot.
+     */
+    void parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize,
+        const std::function<void(uint32_t, uint32_t)>& func);
+
+    /*! \brief Computes mapFunc(chunkBegin, chunkEnd) for the same chunks as parallelFor and combines the
+     * results with reduceFunc, starting from identity. The results are always combined in the order of
+     * the chunks so that the result does not depend on the number of workers or on the scheduling
+     * (even if reduceFunc is not associative, like floating point additions).
+     */
+    template<typename T, typename MapFunc, typename ReduceFunc>
+    T parallelReduce(uint32_t begin, uint32_t end, uint32_t grainSize, const T& identity,
+        MapFunc mapFunc, ReduceFunc reduceFunc)
+    {
+        if(end <= begin)
+            return identity;
+
+        if(grainSize == 0)
+            grainSize = 1;
+
+        // The results are wrapped so that each chunk writes its own memory (even with std::vector<bool>)
+        struct ChunkResult
+        {
+            T mValue;
+        };
+        uint32_t nbChunks = (end - begin - 1) / grainSize + 1;
+        std::vector<ChunkResult> results(nbChunks, ChunkResult{identity});
+        parallelFor(0, nbChunks, 1, [&](uint32_t chunkBegin, uint32_t chunkEnd)
+        {
+            for(uint32_t chunk = chunkBegin; chunk < chunkEnd; ++chunk)
+            {
+                uint32_t first = begin + chunk * grainSize;
+                uint32_t last = (end - first > grainSize) ? first + grainSize : end;
+                results[chunk].mValue = mapFunc(first, last);
+            }
+        });
+
+        T result = identity;
+        for(const ChunkResult& chunkResult : results)
+            result = reduceFunc(result, chunkResult.mValue);
+
+        return result;
+    }
+
+    //! \brief Number of workers used when it is not given in the command line: one less than the
+    //! number of cores (the main thread also runs tasks) with at most MAX_DEFAULT_WORKERS
+    static uint32_t getDefaultNbWorkers();
+
+    static const uint32_t MAX_DEFAULT_WORKERS;
+
+private:
+    struct Task
+    {
+        std::function<void()> mFunc;
+        TaskGroup* mGroup;
+    };
+
+    struct TaskQueue
+    {
+        std::mutex mMutex;
+        std::deque<Task> mTasks;
+    };
+
+    //! \brief Queues the task on the queue of the calling thread and wakes a worker
+    void push(Task&& task);
+
+    //! \brief Runs a queued task if any on the given slot. Returns false if there was none
+    bool tryRunTask(uint32_t slot);
+
+    void workerLoop(uint32_t index);
+
+    //! \brief One queue per slot
+    std::vector<std::unique_ptr<TaskQueue>> mQueues;
+
+    std::vector<std::thread> mWorkers;
+
+    //! \brief Number of tasks in the queues. The workers sleep while there is none
+    std::atomic<uint32_t> mNbQueuedTasks;
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCondition;
+    bool mIsStopping;
+};
+
+/*! \brief Set of tasks run on a ThreadPool that can be waited for together. The group must outlive its
+ * tasks: the destructor waits for them.
+ */
+class TaskGroup
+{
+    friend class ThreadPool;
+
+public:
+    explicit TaskGroup(ThreadPool& threadPool);
+    ~TaskGroup();
+
+    //! \brief Queues the given task. It may run at any time until wait returns
+    void run(std::function<void()> func);
+
+    //! \brief Returns when every task run in this group is done. The calling thread runs queued tasks
+    //! (from any group) meanwhile
+    void wait();
+
+    //! \brief Returns true if every task run in this group is done
+    inline bool isDone() const
+    { return mNbPendingTasks.load(std::memory_order_acquire) == 0; }
+
+private:
+    ThreadPool& mThreadPool;
+    std::atomic<uint32_t> mNbPendingTasks;
+};
+
+#endif // THREADPOOL_H